@@ -7,7 +7,12 @@
 #include "descriptors.hpp"
 #include "chunk_manager.hpp"
 #include "texture_manager.hpp"
+#include "pipeline_cache.hpp"
+#include "parallel_recorder.hpp"
+#include "gpu_culler.hpp"
+#include "gpu_profiler.hpp"
 
+#include <chrono>
 #include <vector>
 
 namespace vkengine {
@@ -32,15 +37,24 @@ class App {
         long frameCount = 0;
         void loadGameObjects();
 
+        // Startup is logged from here to the first presented frame, and to the
+        // first frame that draws any terrain
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        bool terrainShown = false;
+
         Window window{WIDTH, HEIGHT, "Vulkan"};
         Device device{window};
         Renderer renderer{window, device};
+        PipelineCache pipelineCache{device, "data/pipeline_cache.bin"};
     
         std::shared_ptr<DescriptorPool> globalPool{};
         GameObject::Map gameObjects{};
 
         std::unique_ptr<ChunkManager> chunkManager{};
         std::shared_ptr<TextureManager> textureManager{};
+        std::unique_ptr<ParallelRecorder> recorder{};
+        std::unique_ptr<GpuCuller> gpuCuller{};
+        std::unique_ptr<GpuProfiler> gpuProfiler{};
 
         VkDescriptorSet appTextureDescriptorSet;
 };
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "enums.hpp"
+#include "content_pool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vkengine {
+
+struct Block;
+
+// Block ids of one chunk as a small local palette plus a bit-packed index
+// array. Index width is 0, 1, 2, 4 or 8 bits so entries never straddle a
+// 64-bit word; a uniform chunk stores no indices at all.
+//
+// Not internally synchronised: callers hold the owning chunk's mutex for writes.
+class BlockStorage {
+public:
+    static constexpr int VOLUME = 16 * 16 * 16;
+
+    BlockStorage();
+
+    BlockType get(int index) const {
+        if (bits == 0) {
+            return palette[0];
+        }
+        unsigned bit = static_cast<unsigned>(index) * bits;
+        uint64_t word = words[bit >> 6];
+        return palette[(word >> (bit & 63)) & mask()];
+    }
+
+    void set(int index, BlockType type);
+
+    // Back to a uniform chunk of `type`
+    void fill(BlockType type);
+
+    // Bulk conversion; pack() also drops palette entries that are no longer used
+    void pack(const std::array<Block, VOLUME>& blocks);
+    void unpack(std::array<Block, VOLUME>& blocks) const;
+
+    int bitsPerBlock() const { return bits; }
+    size_t paletteSize() const { return palette.size(); }
+
+    // Bytes owned by this storage, including the object itself
+    size_t memoryUsage() const;
+
+    // Equal blocks give equal storage after pack(), so these compare content
+    uint64_t contentHash() const;
+    bool operator==(const BlockStorage& other) const {
+        return bits == other.bits && palette == other.palette && words == other.words;
+    }
+
+private:
+    uint64_t mask() const { return (uint64_t{1} << bits) - 1; }
+    void resize(int newBits);
+    void writeIndex(int index, uint64_t paletteIndex);
+
+    std::vector<BlockType> palette;
+    std::vector<uint64_t> words;
+    uint8_t bits = 0;
+};
+
+// Block storage shared between chunks with identical blocks (all-stone,
+// all-water, repeated plains). Chunks intern freshly packed storage here;
+// their copy-on-write splits it again on the first edit.
+ContentPool<BlockStorage>& blockStoragePool();
+
+} // namespace vkengine
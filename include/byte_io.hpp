@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vkengine {
+
+// Little-endian helpers for on-disk formats, independent of host byte order
+
+inline void putU32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+inline uint32_t getU32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+inline void putU64(char* out, uint64_t value) {
+    putU32(out, static_cast<uint32_t>(value));
+    putU32(out + 4, static_cast<uint32_t>(value >> 32));
+}
+
+inline uint64_t getU64(const char* in) {
+    return static_cast<uint64_t>(getU32(in)) | (static_cast<uint64_t>(getU32(in + 4)) << 32);
+}
+
+inline void appendU32(std::string& out, uint32_t value) {
+    char bytes[4];
+    putU32(bytes, value);
+    out.append(bytes, sizeof(bytes));
+}
+
+inline void appendU64(std::string& out, uint64_t value) {
+    char bytes[8];
+    putU64(bytes, value);
+    out.append(bytes, sizeof(bytes));
+}
+
+} // namespace vkengine
@@ -19,6 +19,8 @@ class Camera {
         const glm::mat4& getView() const { return viewMatrix; }
 
         const glm::vec3 getPosition() const { return glm::inverse(viewMatrix)[3]; }
+        // Unit vector the camera looks along, in world space
+        const glm::vec3 getDirection() const { return {viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2]}; }
     private:
         glm::mat4 projectionMatrix{1.f};
         glm::mat4 viewMatrix{1.f};
@@ -4,13 +4,19 @@
 #include "model.hpp"
 #include "hash.hpp"
 #include "enums.hpp"
-#include "perlin_noise.hpp"
+#include "block_storage.hpp"
+#include "config.hpp"
+#include "world_snapshot.hpp"
 
 #include <memory>
 #include <array>
 #include <vector>
 #include <glm/glm.hpp>
 #include <mutex>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <utility>
 
 namespace vkengine {
 
@@ -39,6 +45,16 @@ struct ChunkCoord {
     };
 };
 
+// Division rounding toward negative infinity, for block and chunk coordinates below zero
+inline int floorDiv(int value, int divisor) {
+    int q = value / divisor;
+    return (value % divisor != 0 && ((value < 0) != (divisor < 0))) ? q - 1 : q;
+}
+
+inline int chunkBlockIndex(int x, int y, int z) {
+    return x + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_SIZE);
+}
+
 struct Block {
     BlockType type;
     
@@ -46,59 +62,85 @@ struct Block {
     Block(BlockType t) : type(t) {}
 };
 
-struct TerrainSettings {
-    PerlinNoise temperatureNoise;
-    PerlinNoise humidityNoise;
-    PerlinNoise elevationNoise;
-    PerlinNoise riverNoise;
-    PerlinNoise caveNoise;
-    PerlinNoise oreNoise;
-
-    // -- 2D Biomes Map -- 
-    double temperatureFrequency = 0.001;
-    double heatFrequency = 0.001;
-
-
-    // -- Heightmap Generation --
-    double elevFrequency = 0.1;
-    int elevOctaves = 4;
-    double elevPersistence = 0.5;
-    double elevHeightScale = 100.0;
-    double elevBaseHeight = 0.0;
-
-    // -- River Carving -- 
-    double riverFrequency = 0.001;
-    double riverThreshold = 0.3;
-    double riverBedHeight = CHUNK_SIZE * 0.25f;
-
-    // -- Caves --
-    double caveFrequency = 0.1;
-    double caveThreshold = 0.6;
-
-    // -- Soil -- 
-    int baseSoilDepth = 3;
-    double soilDepthVariation = 0.5;
-
-    int maxHeight = -256;
-    int minHeight = 256;
-    
-    TerrainSettings(uint64_t seed = 0) : 
-        temperatureNoise(seed + 1), 
-        humidityNoise(seed + 2),
-        elevationNoise(seed + 3),
-        riverNoise(seed + 4),
-        caveNoise(seed + 5),
-        oreNoise(seed + 6) {}
+// Coarsest level of detail: cells of 2^MAX_LOD_LEVEL blocks
+constexpr int MAX_LOD_LEVEL = 3;
+
+// Level of detail a chunk is meshed at: cells of 2^level blocks, and which
+// neighbours render at a different level (bit i: m_neighbors[i]). Faces toward
+// those count as open, which closes the seam with a wall instead of a crack.
+struct ChunkLod {
+    int level = 0;
+    int seams = 0;
+
+    bool operator==(const ChunkLod& other) const {
+        return level == other.level && seams == other.seams;
+    }
+    bool operator!=(const ChunkLod& other) const { return !(*this == other); }
+};
+
+// A large opaque face of a chunk mesh, in chunk-local positions, that the
+// occlusion culler can rasterize to hide what is behind it
+struct OccluderQuad {
+    std::array<glm::vec3, 4> corners;
+};
+
+// Smallest greedy quad, in blocks, worth rasterizing as an occluder
+constexpr int OCCLUDER_MIN_AREA = 4;
+
+// Which pairs of chunk faces are joined through air inside the chunk, one bit
+// per pair. Faces are numbered like m_neighbors (X+, X-, Y+, Y-, Z+, Z-).
+constexpr uint16_t ALL_FACES_CONNECTED = 0x7FFF;
+
+inline int facePairBit(int a, int b) {
+    if (a > b) std::swap(a, b);
+    return a * (11 - a) / 2 + (b - a - 1);
+}
+
+inline bool facesConnected(uint16_t visibility, int a, int b) {
+    return a != b && (visibility >> facePairBit(a, b)) & 1;
+}
+
+// Faces, as bits numbered like m_neighbors, whose front side a camera at `eye`
+// could see on some quad inside the box; the others face away from it entirely
+inline int frontFacingFaces(const glm::vec3& eye, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    return (eye.x > boxMin.x) | (eye.x < boxMax.x) << 1 |
+           (eye.y > boxMin.y) << 2 | (eye.y < boxMax.y) << 3 |
+           (eye.z > boxMin.z) << 4 | (eye.z < boxMax.z) << 5;
+}
+
+class TerrainGenerator;
+class DecorationBuffer;
+class DirtyChunks;
+struct ChunkMemory;
+struct PendingBlock;
+
+// A chunk's blocks and flags as they were when a world snapshot was taken
+struct ChunkSnapshot {
+    std::shared_ptr<const BlockStorage> blocks;
+    int flags = 0;
+    bool current = false;   // not written since the snapshot
 };
 
 class Chunk {
 public:
-    // Constructor with a shared pointer to a game object that will represent this chunk
-    Chunk(Device &device, std::shared_ptr<GameObject> gameObject);
+    // Constructor with a shared pointer to a game object that will represent this chunk.
+    // Edits add the chunk to `dirtyChunks`, if given, for the next save, and
+    // changes in its memory usage are added to `memory`.
+    Chunk(Device &device, std::shared_ptr<GameObject> gameObject, WorldSnapshots* snapshots = nullptr,
+          DirtyChunks* dirtyChunks = nullptr, ChunkMemory* memory = nullptr);
+    // Headless chunk for tools and benchmarks: meshes, but cannot upload
+    explicit Chunk(std::shared_ptr<GameObject> gameObject);
     ~Chunk();
 
     void initialize();
-    void generateTerrain();
+    void generateTerrain(TerrainGenerator& generator, DecorationBuffer& decorations);
+    // Replaces the generated terrain with a saved Chunk::serialize() payload
+    void loadTerrain(std::string_view data);
+    // Applies decoration writes that arrived after this chunk was generated.
+    // Ignored for loaded chunks: their saved blocks already hold every tree,
+    // and re-applying would regrow leaves and wood the player removed. An
+    // edited chunk is marked dirty again, so its saved copy gets the overhang.
+    bool applyDecorations(const std::vector<PendingBlock>& writes);
 
     void fill(int x1, int y1, int z1, int x2, int y2, int z2, BlockType blockType);
     void setBlock(int x, int y, int z, BlockType blockType);
@@ -108,13 +150,53 @@ public:
     bool defaultTerrainGenerated() const { return flags & ChunkFlags::DEFAULT_TERRAIN_GENERATED; }
     bool meshGenerated() const { return flags & ChunkFlags::MESH_GENERATED; }
     bool upToDate() const { return flags & ChunkFlags::UP_TO_DATE; }
+    bool storedOnDisk() const { return flags & ChunkFlags::STORED_ON_DISK; }
+    bool loadedFromDisk() const { return flags & ChunkFlags::LOADED_FROM_DISK; }
+    // Only edits mark a chunk dirty; generated and decorated terrain is reproducible
+    // from the seed. Decorations reaching an already edited chunk do too.
+    bool dirty() const { return flags & ChunkFlags::DIRTY; }
 
     void setMeshGenerated(bool generated);
     void setUpToDate(bool upToDate);
+    void setStoredOnDisk(bool stored);
+    void setDirty(bool dirty);
 
     void generateMesh();
-    void generateGreedyMesh();
+    // Levels above 0 are meshed from a downsampled block grid, always greedily
+    void generateGreedyMesh(ChunkLod lod = {});
     void updateGameObject();
+
+    // Hash of everything the mesh depends on: own blocks, which neighbour border
+    // cells are air, the meshing technique and the level of detail. Equal keys
+    // give identical meshes.
+    uint64_t meshKey(MeshingTechnique technique, ChunkLod lod = {}) const;
+    // Installs a mesh produced elsewhere (e.g. the mesh cache) as if generated at `lod`
+    void setMesh(std::vector<Model::Vertex> vertices, std::vector<uint32_t> indices, ChunkLod lod = {});
+    // Installs a model already uploaded for an identical mesh, with that mesh's
+    // occluders; updateGameObject() then points the game object at it instead of uploading
+    void setSharedMesh(std::shared_ptr<Model> model, ChunkLod lod = {}, std::shared_ptr<const std::vector<OccluderQuad>> occluders = nullptr);
+    // Occluders of the mesh last generated or installed; null for coarse levels,
+    // simple meshing and meshes without large quads
+    const std::shared_ptr<const std::vector<OccluderQuad>>& getMeshOccluders() const { return m_occluders; }
+    // Occluders of the mesh updateGameObject() last put on screen; main thread only
+    const std::shared_ptr<const std::vector<OccluderQuad>>& getOccluders() const { return m_drawnOccluders; }
+
+    // Level of detail the next mesh should use; set from the player's distance.
+    // A mesh built at another level stops counting as generated.
+    void setLod(ChunkLod lod);
+    ChunkLod getLod() const { return unpackLod(m_lod); }
+    // Recomputes the face connectivity from the blocks; done alongside meshing.
+    // Until the first call every pair counts as connected.
+    void updateVisibility();
+    uint16_t getVisibility() const { return m_visibility; }
+    // meshKey() of the current mesh, 0 if it was not computed or a block was written since
+    void setMeshKey(uint64_t key) { m_meshKey = key; }
+    uint64_t getMeshKey() const { return m_meshKey; }
+    const std::vector<Model::Vertex>& getVertices() const { return m_vertices; }
+    const std::vector<uint32_t>& getIndices() const { return m_indices; }
+    // Index offsets of the six face-direction buckets of m_indices, in
+    // m_neighbors order, plus the end; empty if the mesh could not be bucketed
+    const std::vector<uint32_t>& getFaceOffsets() const { return m_faceOffsets; }
     
     std::shared_ptr<GameObject> getGameObject() const { return m_gameObject; }
 
@@ -124,12 +206,38 @@ public:
 
     bool allNeighborsLoaded() const;
 
+    // Block storage or, for a cold chunk, its compressed form
+    size_t blockMemoryUsage() const;
+    // CPU-side mesh arrays, kept until the chunk goes cold
+    size_t meshMemoryUsage() const;
+
+    // Cold tier; caller holds m_mutex. compress() swaps the block storage for
+    // a varint RLE encoding and drops the CPU copy of an uploaded mesh. Any
+    // later block access (meshing, edits, neighbour reads) decompresses it.
+    // Returns false if the chunk cannot go cold right now.
+    bool compress();
+    // Readable without the lock
+    bool isCold() const { return m_cold; }
+    // Last time ChunkManager saw the chunk in range, in steady_clock ticks
+    void touch(int64_t now) { m_lastUsed = now; }
+    int64_t lastUsed() const { return m_lastUsed; }
+
+    // Caller holds m_mutex. Fills `snapshot` with this chunk as of snapshot
+    // `epoch` and returns false if the chunk did not exist yet. The returned
+    // storage is immutable, so it can be serialized after the lock is released.
+    // It is null if the chunk was clean then; a cold chunk is never warmed.
+    bool readSnapshot(uint64_t epoch, ChunkSnapshot& snapshot);
+    // Caller holds m_mutex. The snapshot with `epoch` is done with this chunk.
+    void releaseSnapshot(uint64_t epoch);
+
     std::array<std::shared_ptr<Chunk>, 6> m_neighbors{nullptr};
 
     void clearMesh();
 
     std::string serialize() const;
-    void deserialize(const std::string& data);
+    // Position independent: identical blocks give identical payloads
+    static std::string serialize(const BlockStorage& blocks);
+    void deserialize(std::string_view data);
 
 private:
     struct VertexPosHash {
@@ -140,22 +248,79 @@ private:
         }
     };
 
-    std::array<Block, CHUNK_VOLUME> m_blocks;
+    // Copy-on-write: shared with a snapshot until the next write after it.
+    // Null while the chunk is cold; go through storage().
+    mutable std::shared_ptr<BlockStorage> m_blocks;
+    mutable std::string m_compressed;
+    mutable std::atomic<bool> m_cold{false};
+    std::atomic<int64_t> m_lastUsed{0};
+
+    BlockStorage& storage() const {
+        if (!m_blocks) decompress();
+        return *m_blocks;
+    }
+    void decompress() const;
+    // m_compressed decoded into new storage, leaving the chunk cold
+    std::shared_ptr<BlockStorage> decodeCompressed() const;
+    // Swaps freshly packed storage for an identical chunk's, if there is one
+    void shareStorage() const;
+    WorldSnapshots* m_snapshots = nullptr;
+    DirtyChunks* m_dirtyChunks = nullptr;
+    ChunkMemory* m_memory = nullptr;
+    // What this chunk last added to m_memory
+    mutable size_t m_countedBlockBytes = 0;
+    mutable size_t m_countedMeshBytes = 0;
+    mutable bool m_countedCold = false;
+    // Epoch of the last snapshot active when m_blocks was written
+    uint64_t m_blocksEpoch = 0;
+    // Pre-write contents kept for the snapshot with epoch m_snapshotEpoch
+    ChunkSnapshot m_snapshot;
+    uint64_t m_snapshotEpoch = 0;
+
+    // Called before every block write
+    void prepareWrite();
+    // Sets DIRTY, adding the chunk to m_dirtyChunks when it was clean
+    void markDirty();
+    // Adds the change in usage since the last call to m_memory; called after
+    // the blocks or the mesh change
+    void countMemory() const;
     
     std::shared_ptr<GameObject> m_gameObject;
 
     std::vector<Model::Vertex> m_vertices;
     std::vector<uint32_t> m_indices;
+    std::vector<uint32_t> m_faceOffsets;
+    std::shared_ptr<Model> m_sharedModel;
+    uint64_t m_meshKey = 0;
 
     int coordsToIndex(int x, int y, int z) const;
 
     void addBlockFace(int x, int y, int z, BlockType blockType, Direction direction);
-    void processGreedyDirection(Direction direction, std::shared_ptr<Chunk> neighbor);
-    void addGreedyFace(int normal, int u, int v, int width, int height, BlockType blockType, Direction direction, int normalAxis, int uAxis, int vAxis);
-
-    Device &device;
-
-    TerrainSettings settings{0};
+    void processGreedyDirection(Direction direction, std::shared_ptr<Chunk> neighbor, const std::array<Block, CHUNK_VOLUME>& blocks);
+    void generateLodMesh(int level, const std::array<std::shared_ptr<Chunk>, 6>& neighbors, const std::array<Block, CHUNK_VOLUME>& blocks);
+    // Merges one slice's `size` x `size` mask of visible face types (-1: none) into quads
+    void emitGreedyQuads(std::vector<int>& mask, int size, int slice, Direction direction, int normalAxis, int uAxis, int vAxis, int scale);
+    // Positions are in cells of `scale` blocks
+    void addGreedyFace(int normal, int u, int v, int width, int height, BlockType blockType, Direction direction, int normalAxis, int uAxis, int vAxis, int scale = 1);
+
+    // Groups the quads of m_vertices by the face their normal points through and
+    // fills m_faceOffsets; meshes already in that order are left as they are
+    void bucketFaces();
+    // Collects the large opaque quads of m_vertices into m_occluders
+    void extractOccluders();
+
+    // ChunkLod in one int so it can be read and written without the chunk lock
+    static int packLod(ChunkLod lod) { return lod.level | (lod.seams << 2); }
+    static ChunkLod unpackLod(int packed) { return {packed & 3, packed >> 2}; }
+    std::atomic<int> m_lod{0};
+    // Level the current mesh was built at
+    std::atomic<int> m_meshLod{0};
+    std::shared_ptr<const std::vector<OccluderQuad>> m_occluders;
+    std::shared_ptr<const std::vector<OccluderQuad>> m_drawnOccluders;
+    // Read by the render thread's visibility search without the chunk lock
+    std::atomic<uint16_t> m_visibility{ALL_FACES_CONNECTED};
+
+    Device* device = nullptr;
 
     int flags = NONE;
 };
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vkengine {
+
+// Stored in every chunk payload; never renumber
+enum class ChunkCodecId : uint8_t {
+    VARINT_RLE = 1,
+    PALETTE = 2,
+    LZ = 3,
+};
+
+// Turns a chunk's 4096 block ids into bytes and back. Codecs only see block
+// ids; the payload header (magic and codec tag) is written by
+// Chunk::serialize. decode() throws std::runtime_error on malformed input.
+class ChunkCodec {
+public:
+    virtual ~ChunkCodec() = default;
+
+    virtual ChunkCodecId id() const = 0;
+    virtual const char* name() const = 0;
+
+    // Appends the encoding of `blocks` to `out`
+    virtual void encode(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) const = 0;
+    virtual void decode(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) const = 0;
+};
+
+// (type, LEB128 run length) pairs; runs may span the whole chunk
+class VarintRleCodec : public ChunkCodec {
+public:
+    ChunkCodecId id() const override { return ChunkCodecId::VARINT_RLE; }
+    const char* name() const override { return "varint RLE"; }
+    void encode(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) const override;
+    void decode(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) const override;
+};
+
+// [palette size][palette][indices at 0/1/2/4/8 bits, low bits first]
+class PaletteCodec : public ChunkCodec {
+public:
+    ChunkCodecId id() const override { return ChunkCodecId::PALETTE; }
+    const char* name() const override { return "palette"; }
+    void encode(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) const override;
+    void decode(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) const override;
+};
+
+// LZ77 over the block bytes in the LZ4 block layout: a token with literal and
+// match length nibbles, 255-continued lengths, 2-byte little-endian offsets
+class LzCodec : public ChunkCodec {
+public:
+    ChunkCodecId id() const override { return ChunkCodecId::LZ; }
+    const char* name() const override { return "LZ"; }
+    void encode(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) const override;
+    void decode(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) const override;
+};
+
+// Every codec a payload may name, in id order
+const std::vector<const ChunkCodec*>& chunkCodecs();
+
+// Throws std::runtime_error for an unknown id
+const ChunkCodec& chunkCodec(ChunkCodecId id);
+
+// Encodes with every codec and appends the shortest as [codec id][encoding]
+void encodeSmallest(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out);
+
+// Reads [codec id][encoding] as written by encodeSmallest
+void decodeTagged(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks);
+
+} // namespace vkengine
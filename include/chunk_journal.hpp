@@ -0,0 +1,44 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vkengine {
+
+class RegionStore;
+
+// Append-only log of chunk payloads that are about to be written to the
+// region files. A batch is appended and synced before any region write, and
+// the journal is emptied only after the region files are synced, so a crash
+// at any point leaves either the old or the new chunk recoverable.
+//
+// Record: [magic u32][x i32][y i32][z i32][length u32][hashBytes(payload) u64][payload]
+class ChunkJournal {
+public:
+    explicit ChunkJournal(std::string path);
+    ~ChunkJournal();
+
+    ChunkJournal(const ChunkJournal&) = delete;
+    ChunkJournal& operator=(const ChunkJournal&) = delete;
+
+    // Re-applies every intact record to `store` and empties the journal. A
+    // torn record at the end (crash mid-append) is dropped. Returns records applied.
+    size_t replay(RegionStore& store);
+
+    // Appends the whole batch with a single write and syncs it
+    void append(const std::vector<std::pair<ChunkCoord, std::string>>& batch);
+
+    // Called once every appended record is durable in the region files
+    void reset();
+
+private:
+    void openForAppend();
+
+    std::string path;
+    int fd = -1;
+};
+
+} // namespace vkengine
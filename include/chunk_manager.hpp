@@ -1,11 +1,21 @@
 #pragma once
 
 #include "chunk.hpp"
+#include "terrain_generator.hpp"
+#include "coarse_terrain.hpp"
+#include "region_file.hpp"
+#include "chunk_journal.hpp"
+#include "mesh_cache.hpp"
+#include "content_pool.hpp"
+#include "dirty_chunks.hpp"
+#include "chunk_memory.hpp"
+#include "occlusion_culler.hpp"
 #include "device.hpp"
 #include "game_object.hpp"
 
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <glm/glm.hpp>
 #include <semaphore>
 #include <thread>
@@ -13,6 +23,7 @@
 #include <shared_mutex>
 
 #include <queue>
+#include <deque>
 #include <atomic>
 #include <condition_variable>
 
@@ -24,13 +35,39 @@ public:
     ~ChunkManager();
 
     void update(const glm::vec3& playerPos, int viewDistance, GameObject::Map& gameObjects);
+    // Runs every frame so coarse tiles show up without waiting for the next update()
+    void uploadCoarseTerrain(GameObject::Map& gameObjects);
+    // Finds the chunks the camera can see into: a breadth-first search from the
+    // camera's chunk that only crosses a chunk between faces joined through air,
+    // never turns back along an axis and skips chunks behind the camera. Chunks
+    // it does not reach are culled. Cheap when nothing has moved; run every frame.
+    void updateVisibleChunks(const glm::vec3& cameraPos, const glm::vec3& viewDirection, int viewDistance, const GameObject::Map& gameObjects);
+    // Per frame after updateVisibleChunks: rasterizes the occluders of chunks within
+    // occluder_distance and hides every chunk whose box is behind them or off screen
+    void updateOcclusion(const glm::vec3& cameraPos, const glm::mat4& viewProjection, const GameObject::Map& gameObjects);
+    bool isCulled(GameObject::id_t objectId) const {
+        return culledObjects.count(objectId) > 0 || occludedObjects.count(objectId) > 0;
+    }
+    // Calls `visit` with every object isCulled() is true for
+    template <typename Visit>
+    void forEachCulled(Visit&& visit) const {
+        for (GameObject::id_t objectId : culledObjects) visit(objectId);
+        for (GameObject::id_t objectId : occludedObjects) visit(objectId);
+    }
+    // Changes whenever a chunk's model is replaced or a chunk joins or leaves the game objects
+    uint64_t getMeshGeneration() const { return meshGeneration; }
     
     ChunkCoord worldToChunkCoord(const glm::vec3& position);
     
     bool isChunkInRange(const ChunkCoord& chunkCoord, const ChunkCoord& centerChunk, int viewDistance);
+    // 0 inside `lodDistance` chunks, then one level coarser each time the distance
+    // doubles, up to MAX_LOD_LEVEL; a `lodDistance` of 0 or less turns LOD off
+    static int lodLevel(const ChunkCoord& chunkCoord, const ChunkCoord& centerChunk, int lodDistance);
     
     std::shared_ptr<Chunk> createChunk(const ChunkCoord& coord);
 
+    // Declared before m_chunks: chunks report to it until they are destroyed
+    ChunkMemory chunkMemory;
     std::unordered_map<ChunkCoord, std::shared_ptr<Chunk>, ChunkCoord::Hash> m_chunks;
 
     std::shared_ptr<Chunk> queueChunkCreation(const ChunkCoord& coord);
@@ -42,18 +79,89 @@ public:
 
     void regenerateEntireMesh();
 
-    std::string serialize() const;
-    void deserialize(const std::string& data);
-
-    int flags = ChunkManagerFlags::GENERATE_CHUNKS;
+    // Wakes the autosave thread now instead of at the next interval; never blocks
+    void requestSave();
+    // Journals and writes the chunks edited since the last save; returns the number written.
+    // `throttle` spreads the region writes over time for use while playing.
+    size_t saveDirtyChunks(bool throttle);
+    // Drops all loaded chunks so they stream back in from the region files.
+    // Never blocks: unsaved edits are flushed on the autosave thread first, and
+    // the next update() after that flush drops the chunks.
+    void loadWorld();
+    bool isLoadPending() const { return loadPending; }
+
+    int flags = ChunkManagerFlags::GENERATE_CHUNKS | ChunkManagerFlags::COARSE_TERRAIN | ChunkManagerFlags::MESH_CACHE |
+                ChunkManagerFlags::CAVE_CULLING | ChunkManagerFlags::OCCLUSION_CULLING | ChunkManagerFlags::FACE_CULLING;
+
+    size_t getChunkCount();
+    size_t getEmptyChunkCount();
+    size_t getColdChunkCount() const { return chunkMemory.coldChunks; }
+    size_t getBlockMemoryUsage() const { return chunkMemory.blockBytes; }
+    size_t getMeshMemoryUsage() const { return chunkMemory.meshBytes; }
+    size_t getCoarseTileCount() const { return coarseTerrain.getTileCount(); }
+    // Loaded chunks with a mesh, and how many of them the last visibility search kept
+    size_t getDrawableChunkCount() const { return drawableChunkCount; }
+    size_t getVisibleChunkCount() const { return visibleChunkCount; }
+    // Of the chunks left by the visibility search, as of the last updateOcclusion()
+    size_t getOccludedChunkCount() const { return occludedChunkCount; }
+    size_t getOutsideChunkCount() const { return outsideChunkCount; }
+    float getOcclusionMilliseconds() const { return occlusionMilliseconds; }
+    // Indices of the chunks drawn last frame, and how many of them the render
+    // system submitted after skipping face buckets that point away from the camera
+    void setDrawnIndexCounts(size_t drawn, size_t total) { drawnIndexCount = drawn; totalIndexCount = total; }
+    size_t getDrawnIndexCount() const { return drawnIndexCount; }
+    size_t getTotalIndexCount() const { return totalIndexCount; }
+    MeshCache& getMeshCache() { return meshCache; }
+    // Uploaded chunk models by Chunk::meshKey(); chunks with identical meshes draw one model
+    ContentPool<Model>& getModelPool() { return modelPool; }
+
+    // Last completed save
+    size_t getLastSaveChunks() const { return lastSaveChunks; }
+    size_t getLastSaveBytes() const { return lastSaveBytes; }
+    float getLastSaveMilliseconds() const { return lastSaveMilliseconds; }
 
 private:
     int currentViewDistance = 2;
     Device& device;
+
+    TerrainGenerator terrainGenerator{0};
+    DecorationBuffer decorationBuffer;
+    CoarseTerrain coarseTerrain{device, terrainGenerator};
+    RegionStore regionStore{"data/world"};
+    ChunkJournal journal{"data/world/journal.log"};
+    MeshCache meshCache{"data/mesh_cache", 0};
+    WorldSnapshots worldSnapshots;
+    DirtyChunks dirtyChunks;
+    ContentPool<Model> modelPool;
+
+    // Result of updateVisibleChunks and what it was computed for
+    std::unordered_set<GameObject::id_t> culledObjects;
+    size_t drawableChunkCount = 0;
+    size_t visibleChunkCount = 0;
+    ChunkCoord visibilityCenter{0, 0, 0};
+    glm::vec3 visibilityDirection{0.f};
+    bool visibilityCulling = false;
+    bool visibilityDirty = true;
+
+    OcclusionCuller occlusionCuller;
+    // Occluders of shared models, by the same mesh key
+    ContentPool<const std::vector<OccluderQuad>> occluderPool;
+    std::unordered_set<GameObject::id_t> occludedObjects;
+    size_t occludedChunkCount = 0;
+    size_t outsideChunkCount = 0;
+    float occlusionMilliseconds = 0.0f;
+    size_t drawnIndexCount = 0;
+    size_t totalIndexCount = 0;
+    uint64_t meshGeneration = 0;
     
     std::unordered_map<ChunkCoord, GameObject::id_t, ChunkCoord::Hash> m_activeChunks;
 
+    // Coordinates proven to be air away from any surface; never instantiated
+    std::unordered_set<ChunkCoord, ChunkCoord::Hash> m_emptyChunks;
+
     std::queue<ChunkCoord> chunksNeedingCreating;
+    std::unordered_set<ChunkCoord, ChunkCoord::Hash> chunksQueuedForCreation;
+    std::queue<std::shared_ptr<Chunk>> chunksNeedingLoad;
     std::queue<std::shared_ptr<Chunk>> chunksNeedingTerrainGeneration;
     std::queue<std::shared_ptr<Chunk>> chunksNeedingMeshUpdate;
     std::queue<std::shared_ptr<Chunk>> chunksNeedingPush;
@@ -64,27 +172,59 @@ private:
     std::shared_mutex chunksMutex;
 
     int numCreationThreads = 8;
+    int numLoadThreads = 2;
     int numTerrainThreads = 8;
     int numMeshThreads = 8;
 
     void chunksTerrainGenerationThread();
     void chunksMeshUpdateThread();
     void chunksCreationThread();
+    void chunksLoadThread();
     void chunksPushThread();
+    void autosaveThread();
+    void flushDecorations(const ChunkCoord& centerChunk, int viewDistance);
+    // Queues the chunks that left the view range and compresses a bounded
+    // number of them that have been out of range long enough
+    void compressColdChunks(const ChunkCoord& centerChunk, int viewDistance);
+    // Drops the loaded chunks once loadWorld()'s flush has finished
+    void finishLoad(GameObject::Map& gameObjects);
     void loopOverChunksThread(const glm::vec3& playerPos, int viewDistance, GameObject::Map& gameObjects);
 
     std::atomic<bool> stopThreads{false};
 
     std::counting_semaphore<1024> creationSemaphore{0};
+    std::counting_semaphore<1024> loadSemaphore{0};
     std::counting_semaphore<1024> terrainSemaphore{0};
     std::counting_semaphore<1024> meshSemaphore{0};
     std::counting_semaphore<1024> pushSemaphore{0};
     
     std::mutex creationMutex;
+    std::mutex loadMutex;
     std::mutex terrainMutex;
     std::mutex meshMutex;
     std::mutex pushMutex;
     std::mutex newChunksMutex;
+
+    // One save at a time, whether from the autosave thread, loadWorld or shutdown
+    std::mutex saveMutex;
+    std::mutex autosaveMutex;
+    std::condition_variable autosaveCondition;
+    bool saveRequested = false;
+    // Set by loadWorld(); the autosave thread flushes unthrottled and sets loadFlushed
+    std::atomic<bool> loadPending{false};
+    std::atomic<bool> loadFlushed{false};
+
+    // Loaded chunks outside the view range, each once, swept a few per update
+    // so one that a neighbour's meshing warmed goes cold again; main thread only
+    std::deque<ChunkCoord> coldCandidates;
+    std::unordered_set<ChunkCoord, ChunkCoord::Hash> queuedColdCandidates;
+    // Range the candidates were last collected for; -1 before the first update()
+    ChunkCoord coldCenter{0, 0, 0};
+    int coldViewDistance = -1;
+
+    std::atomic<size_t> lastSaveChunks{0};
+    std::atomic<size_t> lastSaveBytes{0};
+    std::atomic<float> lastSaveMilliseconds{0.0f};
     
     void stopAllThreads();
 
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace vkengine {
+
+// Running totals over the chunks that report to it. Each chunk adds the
+// change in its own usage whenever its blocks or mesh change, so reading the
+// totals never walks the loaded chunks.
+struct ChunkMemory {
+    std::atomic<size_t> coldChunks{0};
+    std::atomic<size_t> blockBytes{0};
+    std::atomic<size_t> meshBytes{0};
+};
+
+} // namespace vkengine
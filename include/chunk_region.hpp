@@ -0,0 +1,29 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace vkengine {
+
+// Offsets to the six face neighbours, in m_neighbors order
+constexpr int FACE_OFFSETS[6][3] = {
+    {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+};
+
+using ChunkMap = std::unordered_map<ChunkCoord, std::shared_ptr<Chunk>, ChunkCoord::Hash>;
+
+// The non-empty chunks ChunkManager::update keeps around the origin at this
+// render distance, in generation order. Shared by the headless tools so they
+// all measure the same region. `skipped` receives the number of empty chunks
+// in range that get no Chunk.
+std::vector<ChunkCoord> regionCoords(uint64_t seed, int renderDistance, size_t* skipped = nullptr);
+
+// Generates every chunk of regionCoords() and links their neighbours; nothing
+// is meshed. With a device the chunks can upload their meshes.
+ChunkMap buildRegion(uint64_t seed, int renderDistance, Device* device = nullptr);
+
+} // namespace vkengine
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "terrain_generator.hpp"
+#include "device.hpp"
+#include "game_object.hpp"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <semaphore>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vkengine {
+
+// A coarse tile covers COARSE_TILE_COLUMNS x COARSE_TILE_COLUMNS chunk columns
+constexpr int COARSE_TILE_COLUMNS = 8;
+// One surface sample per biome cell, so coarse heights equal the full-resolution ones at the samples
+constexpr int COARSE_SAMPLE_SPACING = BIOME_CELL_SIZE;
+constexpr int COARSE_COLUMN_SAMPLES = CHUNK_SIZE / COARSE_SAMPLE_SPACING;
+constexpr int COARSE_TILE_SAMPLES = COARSE_TILE_COLUMNS * COARSE_COLUMN_SAMPLES + 1;
+
+static_assert(COARSE_TILE_COLUMNS * COARSE_TILE_COLUMNS <= 64, "coverage is tracked in a 64-bit mask");
+
+struct CoarseTile {
+    ColumnCoord coord;
+
+    // Filled by a coarse thread, indexed [sx + sz * COARSE_TILE_SAMPLES]
+    std::vector<SurfaceSample> samples;
+    std::array<int, COARSE_TILE_COLUMNS * COARSE_TILE_COLUMNS> columnMinHeight{};
+    std::array<int, COARSE_TILE_COLUMNS * COARSE_TILE_COLUMNS> columnMaxHeight{};
+
+    std::shared_ptr<GameObject> gameObject;
+
+    // One bit per column whose full-resolution chunks are on screen
+    uint64_t coveredColumns = 0;
+    // Coverage the current model was built with
+    uint64_t meshedColumns = 0;
+    bool meshed = false;
+
+    std::atomic<bool> evicted{false};
+};
+
+// Heightmap-only stand-in for terrain that has not been generated yet. Tiles
+// are sampled nearest-first on their own threads, shown as low-detail meshes
+// and cut away column by column as the real chunks become visible.
+class CoarseTerrain {
+public:
+    CoarseTerrain(Device& deviceRef, TerrainGenerator& generator);
+    ~CoarseTerrain();
+
+    CoarseTerrain(const CoarseTerrain&) = delete;
+    CoarseTerrain& operator=(const CoarseTerrain&) = delete;
+
+    // Queue every missing tile within `radius` columns and drop tiles outside it
+    void update(const ChunkCoord& center, int radius, GameObject::Map& gameObjects);
+
+    // Rebuild tiles whose coverage changed; `isChunkShown` is called on the main thread
+    void updateCoverage(const std::function<bool(const ChunkCoord&)>& isChunkShown);
+
+    // Mesh and upload tiles sampled since the last call. Cheap when nothing arrived.
+    void uploadReadyTiles(GameObject::Map& gameObjects);
+
+    void clear(GameObject::Map& gameObjects);
+
+    size_t getTileCount() const { return m_tiles.size(); }
+
+private:
+    void sampleTile(CoarseTile& tile) const;
+    void buildModel(CoarseTile& tile);
+    void coarseThread();
+
+    Device& device;
+    TerrainGenerator& terrainGenerator;
+
+    // Main thread only
+    std::unordered_map<ColumnCoord, std::shared_ptr<CoarseTile>, ColumnCoord::Hash> m_tiles;
+
+    std::queue<std::shared_ptr<CoarseTile>> tilesNeedingSamples;
+    std::queue<std::shared_ptr<CoarseTile>> tilesReady;
+    std::mutex samplesMutex;
+    std::mutex readyMutex;
+    std::counting_semaphore<1024> samplesSemaphore{0};
+
+    int numCoarseThreads = 2;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopThreads{false};
+};
+
+} // namespace vkengine
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vkengine {
+
+// Encodes and decodes every non-empty chunk of a generated region with each
+// chunk codec, plus the smallest-per-chunk choice Chunk::serialize makes, and
+// reports compression ratio and throughput. Runs headless.
+class CodecBenchmark {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int renderDistance = 16;
+    };
+
+    explicit CodecBenchmark(Options options);
+
+    // Returns false if any codec fails to round-trip a chunk
+    bool run();
+
+private:
+    Options options;
+    std::vector<ChunkCoord> coords;
+};
+
+} // namespace vkengine
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace vkengine {
+
+// Headless subcommands of the executable, e.g. "--verify-generation --seed 4".
+// Every tool follows the same shape: a struct Options, an explicit constructor
+// taking it and a run() returning bool (pass/fail) or void. A subcommand is one
+// table entry naming the tool and binding each "--option value" to a field of
+// its Options; parsing, usage text and exit codes are shared.
+struct CommandOption {
+    std::string name;
+    // Shown in the usage line, e.g. "N" or "PATH"
+    std::string valueName;
+    // Parses the value into the options struct passed as void*; throws on a bad value
+    std::function<void(void*, const std::string&)> apply;
+};
+
+struct Subcommand {
+    std::string name;
+    std::string description;
+    std::vector<CommandOption> options;
+    // Arguments after the name in, exit code out
+    std::function<int(const std::vector<std::string>&)> run;
+};
+
+void parseOptionValue(const std::string& text, int& value);
+void parseOptionValue(const std::string& text, uint32_t& value);
+void parseOptionValue(const std::string& text, uint64_t& value);
+void parseOptionValue(const std::string& text, std::string& value);
+
+// Binds "--name value" to `field` of the tool's Options
+template <typename Options, typename T>
+CommandOption option(const char* name, const char* valueName, T Options::*field) {
+    return CommandOption{name, valueName, [field](void* options, const std::string& text) {
+        parseOptionValue(text, static_cast<Options*>(options)->*field);
+    }};
+}
+
+// Applies `args` ("--name value" pairs) to `options`; throws std::invalid_argument
+// naming the offending argument
+void applyOptions(const std::vector<CommandOption>& table, void* options, const std::vector<std::string>& args);
+
+template <typename Tool>
+Subcommand subcommand(const char* name, const char* description, std::vector<CommandOption> options) {
+    Subcommand command{name, description, options, nullptr};
+    command.run = [options](const std::vector<std::string>& args) {
+        // Option errors propagate so the caller can print this command's usage
+        typename Tool::Options parsed{};
+        applyOptions(options, &parsed, args);
+        try {
+            Tool tool(parsed);
+            if constexpr (std::is_void_v<decltype(tool.run())>) {
+                tool.run();
+                return EXIT_SUCCESS;
+            } else {
+                return tool.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    };
+    return command;
+}
+
+// Runs the first subcommand named in argv with the arguments after it. Returns
+// -1 when argv names none, so the caller starts the application instead.
+// "--help" prints every subcommand with its options; a bad option prints the
+// usage of its subcommand.
+int runSubcommand(const std::vector<Subcommand>& commands, int argc, char** argv);
+
+} // namespace vkengine
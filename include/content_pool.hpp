@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace vkengine {
+
+// Content-addressed table of shared, immutable objects. Entries are weak, so
+// an object lives exactly as long as its last user; the table never keeps
+// anything alive. Users that want to change a pooled object copy it first
+// (copy-on-write), which is what Chunk::prepareWrite already does for any
+// storage with more than one owner. Safe to call from any thread.
+template <typename T>
+class ContentPool {
+public:
+    // The live object stored under `key`, or nullptr
+    std::shared_ptr<T> find(uint64_t key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++lookups;
+        auto it = entries.find(key);
+        if (it == entries.end()) return nullptr;
+        std::shared_ptr<T> existing = it->second.lock();
+        if (existing) ++hits;
+        return existing;
+    }
+
+    // Returns the live object under `key` if `same(*existing)`, otherwise
+    // stores `value` under `key` and returns it. `same` guards against hash
+    // collisions; pass a function returning true when the key is the content.
+    template <typename Same>
+    std::shared_ptr<T> intern(uint64_t key, std::shared_ptr<T> value, Same&& same) {
+        if (!enabled || !value) return value;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++lookups;
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            std::shared_ptr<T> existing = it->second.lock();
+            if (existing && existing != value && same(*existing)) {
+                ++hits;
+                return existing;
+            }
+            // A live colliding entry stays; `value` is just not shared
+            if (existing && existing != value) return value;
+        }
+
+        entries[key] = value;
+        // Expired entries are only dropped in sweeps, when the table has doubled
+        if (entries.size() >= sweepAt) {
+            sweep();
+        }
+        return value;
+    }
+
+    // Disabled pools hand every value back unshared
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    // Objects currently shared through the pool
+    size_t liveCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t live = 0;
+        for (const auto& [key, entry] : entries) {
+            live += !entry.expired();
+        }
+        return live;
+    }
+    size_t getLookups() const { return lookups; }
+    size_t getHits() const { return hits; }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        sweepAt = MIN_SWEEP;
+    }
+
+private:
+    static constexpr size_t MIN_SWEEP = 1024;
+
+    void sweep() {
+        for (auto it = entries.begin(); it != entries.end();) {
+            it = it->second.expired() ? entries.erase(it) : std::next(it);
+        }
+        sweepAt = std::max(MIN_SWEEP, entries.size() * 2);
+    }
+
+    std::unordered_map<uint64_t, std::weak_ptr<T>> entries;
+    size_t sweepAt = MIN_SWEEP;
+    std::mutex mutex;
+
+    std::atomic<bool> enabled{true};
+    std::atomic<size_t> lookups{0};
+    std::atomic<size_t> hits{0};
+};
+
+} // namespace vkengine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vkengine {
+
+struct PendingBlock {
+    uint16_t index;     // chunkBlockIndex() inside the target chunk
+    BlockType type;
+};
+
+// Decorations only ever replace air or a weaker decoration block. Applying
+// writes with this rule gives the same result whatever order they arrive in.
+inline int decorationPriority(BlockType type) {
+    switch (type) {
+        case BlockType::AIR: return 0;
+        case BlockType::LEAVES: return 1;
+        case BlockType::WOOD: return 2;
+        default: return 3;
+    }
+}
+
+inline void applyDecorationBlock(Block& block, BlockType type) {
+    if (decorationPriority(type) > decorationPriority(block.type)) {
+        block.type = type;
+    }
+}
+
+// Returns true if any block changed
+inline bool applyPendingBlocks(std::array<Block, CHUNK_VOLUME>& blocks, const std::vector<PendingBlock>& writes) {
+    bool changed = false;
+    for (const auto& write : writes) {
+        BlockType before = blocks[write.index].type;
+        applyDecorationBlock(blocks[write.index], write.type);
+        changed |= blocks[write.index].type != before;
+    }
+    return changed;
+}
+
+// Blocks written by a decoration (trees, structures) into a chunk other than
+// the one being generated. Writers never touch the target chunk itself; the
+// writes are picked up when the target is generated or on the next flush.
+class DecorationBuffer {
+public:
+    void push(const ChunkCoord& target, const PendingBlock& block);
+
+    // Removes and returns every write queued for the target
+    std::vector<PendingBlock> take(const ChunkCoord& target);
+
+    std::vector<ChunkCoord> pendingTargets();
+
+    size_t size();
+
+private:
+    static constexpr size_t NUM_SHARDS = 16;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<ChunkCoord, std::vector<PendingBlock>, ChunkCoord::Hash> writes;
+    };
+
+    Shard& shardFor(const ChunkCoord& coord);
+
+    std::array<Shard, NUM_SHARDS> shards;
+};
+
+} // namespace vkengine
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vkengine {
+
+// Checks that trees do not grow back into saved chunks. A chunk holding leaves
+// and wood from a neighbour's tree is cleared, saved and reloaded. Its
+// neighbours are then regenerated, as they are when a world is reopened. The
+// reloaded chunk must keep no tree blocks, whether the neighbours' writes
+// arrive before or after the load. A freshly generated copy of the same chunk
+// must still get the overhang, and so must a copy edited and saved before its
+// neighbours generated, once it is saved again. Runs headless against a
+// scratch region store.
+class DecorationVerifier {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int renderDistance = 3;
+        // Scratch world, removed before and after the run
+        std::string directory = "data/verify_decorations";
+    };
+
+    explicit DecorationVerifier(Options options);
+
+    // Returns false if a tree grew back or the control chunk got no overhang
+    bool run();
+
+private:
+    Options options;
+};
+
+} // namespace vkengine
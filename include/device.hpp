@@ -30,6 +30,9 @@ class Device {
 #endif
 
     Device(Window &window);
+    // Headless: no window, surface or swap chain, e.g. for offscreen rendering
+    // on a machine without a display. The graphics queue doubles as present queue.
+    Device();
     ~Device();
 
     // Not copyable or movable
@@ -62,8 +65,14 @@ class Device {
 
     VkInstance getInstance() { return instance; }
     VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+    bool isHeadless() const { return window == nullptr; }
     uint32_t getGraphicsQueueFamily() { return findPhysicalQueueFamilies().graphicsFamily; }
 
+    // VK_KHR_draw_indirect_count with multi-draw and firstInstance in indirect
+    // commands, all enabled when the device has them; null otherwise
+    bool supportsDrawIndirectCount() const { return cmdDrawIndexedIndirectCount != nullptr; }
+    PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount = nullptr;
+
   private:
     void createInstance();
     void setupDebugMessenger();
@@ -80,20 +89,22 @@ class Device {
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
     void hasGflwRequiredInstanceExtensions();
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool hasDeviceExtension(VkPhysicalDevice device, const char *name);
+    bool hasInstanceExtension(const char *name);
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-    Window &window;
+    Window *window = nullptr;
     VkCommandPool commandPool;
 
     VkDevice device_;
-    VkSurfaceKHR surface_;
+    VkSurfaceKHR surface_ = VK_NULL_HANDLE;
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
 
     const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-    const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME};
+    const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
 } // namespace vkengine
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace vkengine {
+
+// Coordinates of the chunks with unsaved edits. A chunk adds itself when it
+// becomes dirty, so a save visits only what was edited since the last one
+// instead of scanning every loaded chunk.
+class DirtyChunks {
+public:
+    void add(const ChunkCoord& coord) {
+        std::lock_guard<std::mutex> lock(mutex);
+        coords.insert(coord);
+    }
+
+    // Empties the set; chunks still dirty after a save are added back
+    std::vector<ChunkCoord> take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<ChunkCoord> taken(coords.begin(), coords.end());
+        coords.clear();
+        return taken;
+    }
+
+    bool empty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return coords.empty();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        coords.clear();
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_set<ChunkCoord, ChunkCoord::Hash> coords;
+};
+
+} // namespace vkengine
@@ -1,3 +1,5 @@
+#pragma once
+
 namespace vkengine {
     
 // Define block types
@@ -27,11 +29,21 @@ enum ChunkFlags {
     NONE = 0,
     MESH_GENERATED = 1 << 0,
     DEFAULT_TERRAIN_GENERATED = 1 << 1,
-    UP_TO_DATE = 1 << 2
+    UP_TO_DATE = 1 << 2,
+    STORED_ON_DISK = 1 << 3,    // a saved copy exists and has not been loaded yet
+    DIRTY = 1 << 4,             // edited since it was last written to the region store
+    LOADED_FROM_DISK = 1 << 5,  // terrain came from the region store, decorations included
+    EDITED = 1 << 6             // edited this session, so a saved copy exists or is about to
 };
 
 enum ChunkManagerFlags {
     GENERATE_CHUNKS = 1 << 0,
+    COARSE_TERRAIN = 1 << 1,
+    MESH_CACHE = 1 << 2,
+    CAVE_CULLING = 1 << 3,
+    OCCLUSION_CULLING = 1 << 4,
+    FACE_CULLING = 1 << 5,
+    GPU_CULLING = 1 << 6,
 };
 
 
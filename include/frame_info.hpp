@@ -5,6 +5,9 @@
 #include "chunk_manager.hpp"
 #include "texture_manager.hpp"
 #include "descriptors.hpp"
+#include "parallel_recorder.hpp"
+#include "gpu_culler.hpp"
+#include "gpu_profiler.hpp"
 
 #include <vulkan/vulkan.h>
 
@@ -33,6 +36,12 @@ struct FrameInfo {
     ChunkManager* chunkManager = nullptr; // Pointer to the chunk manager. DO NOT REMOVE 
     std::shared_ptr<TextureManager> textureManager;
     std::shared_ptr<DescriptorPool> globalPool;
+    // Records the draws across worker threads when its thread count is above 0
+    ParallelRecorder* recorder = nullptr;
+    // Draws the chunks when it culled them this frame (isCulling())
+    GpuCuller* gpuCuller = nullptr;
+    // GPU times of the frame's passes, shown in the performance window
+    GpuProfiler* gpuProfiler = nullptr;
 };
 
 }
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vkengine {
+
+// Checks that world generation is a pure function of (seed, chunk coord):
+// the same region is generated several times with different worker counts
+// and every chunk's block hash must match across runs.
+class GenerationVerifier {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int radius = 6;             // chunks around the origin on x and z
+        int minChunkY = -6;
+        int maxChunkY = 2;
+        std::vector<int> threadCounts;  // empty: 1, 8 and hardware concurrency
+        std::string expectedDigest;     // optional hex digest from a previous build
+    };
+
+    explicit GenerationVerifier(Options options);
+
+    // Returns false on any divergence
+    bool run();
+
+    static uint64_t hashChunk(const std::array<Block, CHUNK_VOLUME>& blocks);
+
+private:
+    struct RunResult {
+        std::vector<uint64_t> hashes;   // one per interior chunk, in coord order
+        uint64_t digest = 0;
+        double milliseconds = 0.0;
+    };
+
+    RunResult generateRegion(int threadCount) const;
+    bool isInterior(const ChunkCoord& coord) const;
+
+    Options options;
+    std::vector<ChunkCoord> coords;
+};
+
+} // namespace vkengine
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "descriptors.hpp"
+#include "device.hpp"
+#include "game_object.hpp"
+#include "model.hpp"
+#include "pipeline_cache.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan_core.h>
+
+namespace vkengine {
+
+// Culls chunks on the GPU and draws the ones left without the CPU visiting
+// them each frame. Every chunk model is copied once into a shared vertex and
+// index buffer and described by a record (origin and face bucket bounds). A
+// compute pass tests each record's box against the frustum, drops the face
+// buckets pointing away from the eye and packs the remaining draws, with their
+// count, for vkCmdDrawIndexedIndirectCount.
+//
+// Records, the hidden mask and the draw buffers exist once per frame in
+// flight, so changing them never touches what the GPU is still reading.
+//
+// Drivers differ in how well they handle the compute pass and indirect count
+// draws, so the culler checks itself before it is trusted: the constructor
+// culls a synthetic set of records, and the first frames culled for real are
+// read back, and both are compared with countOnCpu(). On any mismatch the
+// culler turns itself off and every chunk goes back to the CPU draw loop.
+class GpuCuller {
+public:
+    // A record as the shaders see it (std430)
+    struct ChunkRecord {
+        glm::ivec4 origin{0};       // xyz: origin in blocks, w: 1 if the slot holds a chunk
+        uint32_t faceOffsets[7]{};  // bucket i is [faceOffsets[i], faceOffsets[i + 1]) in the shared index buffer
+        int32_t vertexOffset = 0;
+    };
+    static_assert(sizeof(ChunkRecord) == 48, "ChunkRecord must match the std430 layout");
+
+    struct Counts {
+        uint32_t draws = 0;
+        uint32_t indices = 0;
+    };
+
+    // `maxChunks` records per frame; scenes with more chunks are drawn the usual way
+    GpuCuller(Device& device, PipelineCache& pipelineCache, uint32_t maxChunks);
+    ~GpuCuller();
+
+    GpuCuller(const GpuCuller&) = delete;
+    GpuCuller& operator=(const GpuCuller&) = delete;
+
+    // False without draw-indirect-count support or after a failed self-check;
+    // nothing is culled or drawn then
+    bool isSupported() const { return supported; }
+    // Supported and every chunk got a record
+    bool isActive() const { return supported && !overflowed; }
+    // cull() was recorded this frame, so draw() must be used for the chunks
+    bool isCulling() const { return culling; }
+
+    // Binding 1 of the global set: the vertex shaders read a draw's origin from it
+    VkDescriptorBufferInfo getRecordsInfo(int frameIndex);
+
+    // Mirrors the chunks of `gameObjects`, the objects whose model has six face
+    // groups: new models are copied into the shared buffers and models no longer
+    // drawn are released. Does nothing while `generation` is unchanged.
+    void updateChunks(const GameObject::Map& gameObjects, uint64_t generation);
+    // Forgets every chunk, e.g. when GPU culling is switched off
+    void clear();
+
+    // Once per frame after its fence: uploads changed records, reads back what
+    // this frame's buffers counted last time and clears the hidden mask
+    void beginFrame(int frameIndex);
+    // Leaves a chunk out of this frame, e.g. one the visibility search culled
+    void hide(GameObject::id_t objectId);
+    // Records the culling pass; must be outside a render pass
+    void cull(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection, const glm::vec3& eye, bool faceCulling);
+    // Draws what cull() kept, with the pipeline, descriptor sets and push constants
+    // (chunkOrigin.w = 2) already bound
+    void draw(VkCommandBuffer commandBuffer);
+
+    // What cull() writes for this frame, computed on the CPU from the same records
+    Counts countOnCpu(const glm::mat4& viewProjection, const glm::vec3& eye, bool faceCulling) const;
+    // Counts written by the last cull() of `frameIndex`; only valid once it has completed
+    Counts readCounts(int frameIndex) const;
+
+    // From this frame's buffers the last time they were used, so a few frames old
+    const Counts& getLastCounts() const { return lastCounts; }
+    size_t getChunkCount() const { return slots.size(); }
+    size_t getMeshCount() const { return meshes.size(); }
+    size_t getTotalIndexCount() const { return totalIndices; }
+    VkDeviceSize getGeometryBytes() const;
+
+private:
+    // First fit over [0, capacity), in vertices or indices
+    class RangeAllocator {
+    public:
+        void reset(uint32_t capacity);
+        // Adds [from, to) at the end after the buffer grew
+        void extend(uint32_t from, uint32_t to);
+        bool allocate(uint32_t size, uint32_t& offset);
+        void release(uint32_t offset, uint32_t size);
+
+    private:
+        std::map<uint32_t, uint32_t> freeRanges;   // offset -> size
+    };
+
+    // A model in the shared buffers, kept alive while any chunk draws it
+    struct Mesh {
+        std::shared_ptr<Model> model;
+        uint32_t firstVertex = 0;
+        uint32_t firstIndex = 0;
+        uint32_t users = 0;
+    };
+    struct Slot {
+        uint32_t record = 0;
+        const Model* mesh = nullptr;
+    };
+    struct PendingCopy {
+        const Model* model;
+        uint32_t firstVertex;
+        uint32_t firstIndex;
+    };
+    struct Frame {
+        std::unique_ptr<Buffer> records;    // host visible
+        std::unique_ptr<Buffer> hidden;     // host visible, a bit per record
+        std::unique_ptr<Buffer> draws;      // VkDrawIndexedIndirectCommand, three per record at most
+        std::unique_ptr<Buffer> counts;     // Counts
+        std::unique_ptr<Buffer> readback;   // host visible copy of counts
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint64_t recordsVersion = 0;
+        // What countOnCpu() gave for the last cull() of this frame, while it is checked
+        Counts expected{};
+        bool checkPending = false;
+    };
+
+    void createPipeline(PipelineCache& pipelineCache);
+    void createGeometryBuffers(uint32_t vertexCapacity, uint32_t indexCapacity);
+    // Doubles the shared buffers until `vertices` and `indices` more fit, keeping their contents
+    void growGeometry(uint32_t vertices, uint32_t indices);
+    Mesh* acquireMesh(const std::shared_ptr<Model>& model, std::vector<PendingCopy>& copies);
+    void releaseMesh(const Model* model);
+    void writeRecord(uint32_t record, const GameObject& object, const Mesh& mesh);
+    void submitCopies(const std::vector<PendingCopy>& copies);
+    // Culls synthetic records on the GPU and compares the counts with the CPU's
+    bool selfTest();
+    // Falls back to the CPU draw loop for good
+    void disable(const std::string& reason);
+
+    Device& device;
+    bool supported = false;
+    bool overflowed = false;
+    bool culling = false;
+    // Real culling passes still to be compared with the CPU
+    int checksLeft;
+    uint32_t maxChunks;
+    uint32_t maxDraws;
+
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    std::unique_ptr<DescriptorSetLayout> setLayout;
+    std::unique_ptr<DescriptorPool> descriptorPool;
+    std::vector<Frame> frames;
+    int frameIndex = 0;
+
+    std::unique_ptr<Buffer> vertexBuffer;
+    std::unique_ptr<Buffer> indexBuffer;
+    uint32_t vertexCapacity = 0;
+    uint32_t indexCapacity = 0;
+    RangeAllocator vertexRanges;
+    RangeAllocator indexRanges;
+
+    std::unordered_map<const Model*, Mesh> meshes;
+    std::unordered_map<GameObject::id_t, Slot> slots;
+    // Up to the highest slot ever used; free ones have origin.w = 0
+    std::vector<ChunkRecord> records;
+    std::vector<uint32_t> freeRecords;
+    std::vector<uint32_t> hiddenWords;
+    uint64_t recordsVersion = 1;
+    uint64_t mirroredGeneration = UINT64_MAX;
+    size_t totalIndices = 0;
+
+    Counts lastCounts{};
+};
+
+} // namespace vkengine
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vkengine {
+
+// Uploads a generated region to the GPU culler and, for a fixed set of
+// cameras, runs the culling pass and reads back the draw and index counts it
+// wrote. Each is compared with the same culling done on the CPU over the same
+// records, with and without face culling and with some chunks hidden. Needs a
+// Vulkan device with draw-indirect-count, such as a software driver.
+class GpuCullingVerifier {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int renderDistance = 6;
+    };
+
+    explicit GpuCullingVerifier(Options options);
+
+    // Returns false on any mismatch, or if the device cannot cull on the GPU
+    bool run();
+
+private:
+    Options options;
+};
+
+} // namespace vkengine
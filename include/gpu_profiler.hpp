@@ -0,0 +1,85 @@
+#pragma once
+
+#include "device.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vkengine {
+
+// Times named stretches of a frame's command buffer on the GPU with
+// vkCmdWriteTimestamp. Each frame in flight has its own query pool, so the
+// results of a frame are read once its fence has been waited on, without
+// stalling. Every scope keeps its last HISTORY samples for a rolling average
+// with min and max.
+//
+// Devices whose graphics queue has no timestamps (timestampValidBits 0) or
+// that report no timestampPeriod get no pools; every call is a no-op then.
+class GpuProfiler {
+public:
+    static constexpr uint32_t MAX_SCOPES = 16;
+    static constexpr size_t HISTORY = 120;
+
+    struct Scope {
+        std::string name;
+        float lastMilliseconds = 0.0f;
+        float averageMilliseconds = 0.0f;
+        float minMilliseconds = 0.0f;
+        float maxMilliseconds = 0.0f;
+        // Samples in the window, up to HISTORY
+        size_t sampleCount = 0;
+    };
+
+    explicit GpuProfiler(Device& device);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    bool isSupported() const { return supported; }
+
+    // Once per frame after its fence, outside a render pass: collects what this
+    // frame's pool measured last time and resets it
+    void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+    // Reads what `frameIndex` measured; its command buffer must have completed.
+    // beginFrame() does this itself; call it directly to see a frame's times
+    // as soon as it was waited on.
+    void collect(int frameIndex);
+    // A scope is timed once per frame; both ends must go into buffers submitted
+    // in the same frame. Scopes past MAX_SCOPES are ignored.
+    void beginScope(VkCommandBuffer commandBuffer, const std::string& name);
+    void endScope(VkCommandBuffer commandBuffer, const std::string& name);
+
+    // In order of first use
+    const std::vector<Scope>& getScopes() const { return scopes; }
+
+private:
+    struct Frame {
+        VkQueryPool pool = VK_NULL_HANDLE;
+        uint32_t begun = 0;     // a bit per scope
+        uint32_t ended = 0;
+    };
+    struct History {
+        float samples[HISTORY]{};
+        size_t next = 0;
+    };
+
+    // Index of `name` in scopes, added on first use; -1 once MAX_SCOPES are taken
+    int scopeIndex(const std::string& name);
+    void addSample(int scope, float milliseconds);
+
+    Device& device;
+    bool supported = false;
+    // Nanoseconds per tick
+    float timestampPeriod = 0.0f;
+    uint64_t timestampMask = ~0ull;
+
+    std::vector<Frame> frames;
+    int frameIndex = 0;
+    std::vector<Scope> scopes;
+    std::vector<History> histories;
+};
+
+} // namespace vkengine
@@ -1,6 +1,8 @@
+#pragma once
 
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 
 // ——— Bit-interleaving to make a 3D Morton code ———
 static inline uint64_t expandBits(uint32_t v) {
@@ -26,4 +28,30 @@ static inline uint64_t splitmix64(uint64_t x) {
     x  = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
     x  = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
     return x ^ (x >> 31);
-}
\ No newline at end of file
+}
+
+// ——— Fast 64-bit hash over raw bytes (not cryptographic) ———
+// Stable across platforms of the same endianness, so it can be stored on disk.
+static inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = seed ^ (static_cast<uint64_t>(size) * 0x9e3779b97f4a7c15ULL);
+
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        word *= 0x87c37b91114253d5ULL;
+        word = (word << 31) | (word >> 33);
+        h ^= word * 0x4cf5ad432745937fULL;
+        h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+        bytes += 8;
+        size -= 8;
+    }
+
+    uint64_t tail = 0;
+    for (size_t i = 0; i < size; ++i) {
+        tail |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    h ^= tail * 0x87c37b91114253d5ULL;
+
+    return splitmix64(h);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vkengine {
+
+// Renders a generated region without a window: an offscreen image at a chosen
+// resolution, a scripted camera path sampled at a fixed 60 frames per second,
+// and the frames optionally written out as PNGs. Reports the CPU recording time
+// and GPU time of every frame, and a digest of all pixels so a render change
+// shows up as a different digest. Runs on any Vulkan device, including software
+// drivers on machines without a display.
+//
+// The digest only repeats on the same driver, so every run also checks what
+// holds on any driver: each frame is measured for drawn and sky pixels, and
+// each PNG written is decoded again and compared with its frame.
+//
+// Path file: one keyframe per line, "seconds x y z pitch yaw" with angles in
+// degrees; the camera moves linearly between keyframes and '#' starts a comment.
+// Without a file the camera circles the region once, looking at its centre.
+class HeadlessRenderer {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int renderDistance = 4;
+        uint32_t width = 1280;
+        uint32_t height = 720;
+        std::string pathFile;
+        // 0: until the path ends
+        int frames = 0;
+        // PNGs and timings.csv go here; empty writes nothing
+        std::string outputDirectory;
+        // Writes every Nth frame
+        int dumpEvery = 1;
+        // Digest from an earlier run on the same driver; run() fails if it differs
+        std::string expectedDigest;
+    };
+
+    explicit HeadlessRenderer(Options options);
+
+    // Returns false if the path is empty, frames lack terrain or sky (every frame
+    // on the default path, all of them on a given one), a PNG does not decode to
+    // its frame or the digest is not the expected one
+    bool run();
+
+private:
+    Options options;
+};
+
+} // namespace vkengine
@@ -21,14 +21,15 @@ static void check_vk_result(VkResult err) {
 
 class Imgui {
 public:
-    Imgui(Window &window, Device &device, VkRenderPass renderPass, uint32_t imageCount);
+    Imgui(Window &window, Device &device, VkRenderPass renderPass, uint32_t imageCount, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
     ~Imgui();
     void newFrame();
     void render(VkCommandBuffer commandBuffer);
 
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
     void debugWindow(FrameInfo &frameInfo);
-    void showPerformanceTab();  // New method for performance tab
+    // CPU scope timers and, when given, the GPU scopes of `gpuProfiler`
+    void showPerformanceTab(const GpuProfiler* gpuProfiler = nullptr);
 
 private:
     int numVertices = 0;
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vkengine {
+
+// Meshes a generated region at full resolution and with distance-based level
+// of detail, and compares the triangle counts against a full-resolution
+// baseline at a shorter render distance. Runs headless.
+class LodBenchmark {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int renderDistance = 32;
+        int baselineDistance = 8;
+        int lodDistance = 4;
+    };
+
+    explicit LodBenchmark(Options options);
+
+    void run();
+
+private:
+    Options options;
+    std::vector<ChunkCoord> coords;
+};
+
+} // namespace vkengine
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace vkengine {
+
+// Read-only shared mapping of a whole file. Writes made to the file through
+// other handles are visible through the mapping up to its mapped size.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Maps the current contents of the file; returns false if it cannot be opened
+    bool map(const std::string& path);
+    void unmap();
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace vkengine
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "model.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vkengine {
+
+// Finished chunk meshes on disk, one file per Chunk::meshKey() under
+// `directory`. Entries are evicted least recently used first once the total
+// size passes the capacity; recency survives restarts through the files'
+// modification times. Every failure is treated as a miss, never an error.
+//
+// Entry: [magic u32][version u32][key u64][vertex size u32][vertex count u32]
+//        [index count u32][hashBytes(body) u64][vertices][indices]
+class MeshCache {
+public:
+    MeshCache(std::string directory, size_t capacityBytes);
+
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    // Safe to call from any mesh thread
+    bool load(uint64_t key, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices);
+    void store(uint64_t key, const std::vector<Model::Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    void setCapacity(size_t capacityBytes);
+    // Deletes every entry on disk
+    void clear();
+
+    size_t getEntryCount();
+    size_t getSizeBytes();
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+
+private:
+    struct Entry {
+        size_t size;
+        std::list<uint64_t>::iterator recency;
+    };
+
+    // Builds the index from the directory on first use; caller holds `mutex`
+    void scanDirectory();
+    void evict();
+    void erase(uint64_t key);
+    std::string entryPath(uint64_t key) const;
+
+    std::string directory;
+    size_t capacity;
+
+    bool scanned = false;
+    std::list<uint64_t> recency;  // most recently used first
+    std::unordered_map<uint64_t, Entry> entries;
+    size_t totalBytes = 0;
+    std::mutex mutex;
+
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+};
+
+} // namespace vkengine
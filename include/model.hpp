@@ -35,6 +35,9 @@ class Model {
         struct Builder {
             std::vector<Vertex> vertices;
             std::vector<uint32_t> indices;
+            // Optional split of the indices into consecutive groups that
+            // drawGroups() can skip: group i is [groupOffsets[i], groupOffsets[i + 1])
+            std::vector<uint32_t> groupOffsets;
 
             void loadModel(const std::string &filepath);
         };
@@ -49,10 +52,21 @@ class Model {
 
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
+        // Draws the groups whose bit is set in `groupMask`, merging adjacent
+        // ones into one draw; a model without groups is drawn whole. Returns
+        // the number of indices drawn.
+        uint32_t drawGroups(VkCommandBuffer commandBuffer, uint32_t groupMask);
 
         int getVertexCount() const {
             return vertexCount;
         }
+        uint32_t getGroupCount() const {
+            return groupOffsets.empty() ? 0 : static_cast<uint32_t>(groupOffsets.size() - 1);
+        }
+        const std::vector<uint32_t> &getGroupOffsets() const { return groupOffsets; }
+        // Both can be copied from; the index buffer is null without indices
+        VkBuffer getVertexBuffer() const { return vertexBuffer->getBuffer(); }
+        VkBuffer getIndexBuffer() const { return hasIndexBuffer ? indexBuffer->getBuffer() : VK_NULL_HANDLE; }
         int getIndexCount() const {
             if(hasIndexBuffer) {
                 return indexCount;
@@ -73,6 +87,7 @@ class Model {
         bool hasIndexBuffer = false;
         std::unique_ptr<Buffer> indexBuffer;
         uint32_t indexCount;
+        std::vector<uint32_t> groupOffsets;
 };
 
 }
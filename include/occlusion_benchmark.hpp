@@ -0,0 +1,33 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vkengine {
+
+// Runs the occlusion culler headless over a generated region from a fixed
+// set of cameras on and above the terrain, and reports the chunks it hides and
+// its per-frame cost. Every chunk it calls occluded is checked by casting a
+// ray from each of its mesh vertices to the camera through the blocks; a ray
+// that gets through is a wrongly culled chunk.
+class OcclusionBenchmark {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int renderDistance = 8;
+        int occluderDistance = 3;
+    };
+
+    explicit OcclusionBenchmark(Options options);
+
+    // Returns false if any chunk was culled while part of it can be seen
+    bool run();
+
+private:
+    Options options;
+    std::vector<ChunkCoord> coords;
+};
+
+} // namespace vkengine
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace vkengine {
+
+// Software occlusion culling on the CPU. Each frame a few large occluder
+// quads are rasterized into a small depth buffer, then boxes are tested
+// against it. Both sides are conservative: an occluder only covers pixels it
+// covers completely, at the farthest depth it has inside them, and a box
+// counts as visible if any pixel under its screen rectangle is not nearer
+// than the box's nearest corner. Depth is Vulkan clip depth (0 near, 1 far).
+class OcclusionCuller {
+public:
+    static constexpr int DEFAULT_WIDTH = 256;
+    static constexpr int DEFAULT_HEIGHT = 128;
+
+    enum class Result {
+        VISIBLE,
+        OCCLUDED,
+        OUTSIDE,    // not on screen at all
+    };
+
+    explicit OcclusionCuller(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+    // Clears the depth buffer for a new camera
+    void beginFrame(const glm::mat4& viewProjection);
+    // `quads` are relative to `origin`; quads crossing the near plane are skipped
+    void addOccluders(const glm::vec3& origin, const std::vector<OccluderQuad>& quads);
+    Result test(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // Triangles rasterized since beginFrame()
+    size_t getTriangleCount() const { return triangleCount; }
+    const std::vector<float>& getDepth() const { return depth; }
+
+private:
+    // Screen position in pixels and clip depth
+    struct ScreenVertex {
+        float x, y, z;
+    };
+
+    bool project(const glm::vec3& position, ScreenVertex& out) const;
+    void rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c);
+
+    int width;
+    int height;
+    // Row-padded to a multiple of 4 pixels for the SIMD loops
+    int stride;
+    std::vector<float> depth;
+    glm::mat4 viewProjection{1.f};
+    size_t triangleCount = 0;
+};
+
+} // namespace vkengine
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "device.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vkengine {
+
+// A color and depth image with a render pass and framebuffer laid out like the
+// swap chain's, for rendering without a window. Each pass ends by copying the
+// color image into a host visible buffer, read with readPixels() once the
+// command buffer has completed.
+class OffscreenTarget {
+public:
+    // RGBA so the pixels can be written out as they are; sRGB like the swap chain
+    static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+    // Linear clear color; the image stores it sRGB encoded
+    static constexpr float SKY_COLOR[4] = {0.53f, 0.81f, 0.92f, 1.0f};
+
+    OffscreenTarget(Device& device, VkExtent2D extent);
+    ~OffscreenTarget();
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    VkRenderPass getRenderPass() const { return renderPass; }
+    VkExtent2D getExtent() const { return extent; }
+    float getAspectRatio() const { return static_cast<float>(extent.width) / static_cast<float>(extent.height); }
+
+    // Clears to the same sky color as the swap chain pass and sets viewport and scissor
+    void beginRenderPass(VkCommandBuffer commandBuffer);
+    // Ends the pass and records the copy into the readback buffer
+    void endRenderPass(VkCommandBuffer commandBuffer);
+
+    // Rows top to bottom, 4 bytes per pixel
+    void readPixels(std::vector<uint8_t>& pixels);
+
+private:
+    void createImages();
+    void createRenderPass();
+
+    Device& device;
+    VkExtent2D extent;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+    VkImage colorImage = VK_NULL_HANDLE;
+    VkDeviceMemory colorMemory = VK_NULL_HANDLE;
+    VkImageView colorView = VK_NULL_HANDLE;
+    VkImage depthImage = VK_NULL_HANDLE;
+    VkDeviceMemory depthMemory = VK_NULL_HANDLE;
+    VkImageView depthView = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    std::unique_ptr<Buffer> readback;
+};
+
+} // namespace vkengine
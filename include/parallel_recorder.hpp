@@ -0,0 +1,103 @@
+#pragma once
+
+#include "device.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vkengine {
+
+// Worker threads that record secondary command buffers for the swap chain
+// render pass. Every worker, and the main thread, has its own command pool
+// per frame in flight, so recording never shares a pool between threads and
+// a frame's pools are reset only once the GPU is done with that frame.
+//
+// With a thread count of 0 everything is recorded inline into the primary
+// buffer instead, and the render pass is begun with inline contents.
+class ParallelRecorder {
+public:
+    // Records the draws of one slice into `commandBuffer`; `slice` is 0..slices-1
+    using Task = std::function<void(int slice, VkCommandBuffer commandBuffer)>;
+
+    ParallelRecorder(Device& device, int maxThreads);
+    ~ParallelRecorder();
+
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+    // Clamped to [0, getMaxThreadCount()]; takes effect at the next beginFrame()
+    void setThreadCount(int count);
+    int getThreadCount() const { return threadCount; }
+    int getMaxThreadCount() const { return static_cast<int>(workers.size()); }
+    // The render pass must be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+    bool isParallel() const { return activeThreads > 0; }
+    // Slices record() runs this frame, one per worker
+    int getActiveThreadCount() const { return activeThreads; }
+
+    // Called once per frame before the render pass begins. Resets the pools of
+    // `frameIndex` and remembers what secondary buffers inherit.
+    void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+    // Runs `task` once per worker, each into a new secondary buffer begun with
+    // the render pass, viewport and scissor, and blocks until all are done.
+    // The buffers are appended to `buffers` in slice order.
+    void record(const Task& task, std::vector<VkCommandBuffer>& buffers);
+    // Runs `task` as a single slice straight into `commandBuffer` on this
+    // thread, timed the same way; used when not parallel
+    void recordInline(const Task& task, VkCommandBuffer commandBuffer);
+
+    // A secondary buffer for the calling (main) thread, e.g. for the UI overlay
+    VkCommandBuffer beginSecondary();
+    void endSecondary(VkCommandBuffer commandBuffer);
+
+    // Of the last record() or recordInline(): wall time and each slice's time
+    float getRecordMilliseconds() const { return recordMilliseconds; }
+    const std::vector<float>& getThreadMilliseconds() const { return threadMilliseconds; }
+
+private:
+    struct Pool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;
+        size_t used = 0;
+    };
+
+    // Pool of `slot` (0: main thread, 1..: workers) for the current frame
+    Pool& pool(int slot) { return pools[static_cast<size_t>(frameIndex) * (workers.size() + 1) + slot]; }
+    VkCommandBuffer beginBuffer(Pool& pool);
+    void workerLoop(int worker);
+
+    Device& device;
+    std::vector<Pool> pools;
+
+    int threadCount = 0;
+    int activeThreads = 0;   // threadCount as of beginFrame()
+    int frameIndex = 0;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkExtent2D extent{};
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    // The running record()'s task and slice count, null and 0 between calls.
+    // Workers read these, not activeThreads, which beginFrame() writes unlocked.
+    const Task* task = nullptr;
+    int slices = 0;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool stopping = false;
+    // First exception a worker threw this record(), rethrown on the main thread
+    std::exception_ptr error;
+    std::vector<VkCommandBuffer> results;
+
+    float recordMilliseconds = 0.0f;
+    std::vector<float> threadMilliseconds;
+};
+
+} // namespace vkengine
@@ -24,7 +24,7 @@ public:
     double noise(double x, double y, double z = 0.0) const;
     
     // Get noise value with octaves for more natural looking terrain
-    double octaveNoise(double x, double y, int octaves, double persistence);
+    double octaveNoise(double x, double y, int octaves, double persistence) const;
 
 private:
     double fade(double t) const;
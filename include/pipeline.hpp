@@ -28,7 +28,8 @@ struct PipelineConfigInfo {
 
 class Pipeline {
     public:
-        Pipeline(Device &device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+        // `pipelineCache` may be VK_NULL_HANDLE
+        Pipeline(Device &device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
         ~Pipeline();
 
         Pipeline(const Pipeline &) = delete;
@@ -37,10 +38,12 @@ class Pipeline {
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
         void bind(VkCommandBuffer commandBuffer);
 
-    private:
+        // Whole file, e.g. SPIR-V; throws if it cannot be opened
         static std::vector<char> readFile(const std::string& filepath);
 
-        void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+    private:
+
+        void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache);
         void createShaderModule(const std::vector<char>& code, VkShaderModule *shaderModule);
 
         Device &device;
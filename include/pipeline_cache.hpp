@@ -0,0 +1,46 @@
+#pragma once
+
+#include "device.hpp"
+
+#include <string>
+#include <vulkan/vulkan_core.h>
+
+namespace vkengine {
+
+// A VkPipelineCache kept in one file across runs, so pipelines compiled once
+// are not compiled again at the next startup. A file written by another GPU,
+// vendor or driver version, or one that fails its checksum, is ignored and
+// the cache starts empty. Every failure is treated as a miss, never an error.
+//
+// File: [magic u32][version u32][vendor id u32][device id u32][driver version u32]
+//       [pipeline cache UUID, 16 bytes][data size u64][hashBytes(data) u64][data]
+class PipelineCache {
+public:
+    PipelineCache(Device& device, std::string path);
+    // Saves if pipelines were created since the load
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    VkPipelineCache getCache() const { return cache; }
+    // True if a valid file was loaded, so pipelines should mostly come from it
+    bool isWarm() const { return warm; }
+    // Call after creating pipelines through the cache so the destructor saves it
+    void markDirty() { dirty = true; }
+
+    // Writes the cache data to the file, aside and then renamed into place
+    void save();
+
+private:
+    // Returns the driver's data if the file at `path` belongs to this device
+    std::string load();
+
+    Device& device;
+    std::string path;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    bool warm = false;
+    bool dirty = false;
+};
+
+} // namespace vkengine
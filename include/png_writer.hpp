@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vkengine {
+
+// Writes `width` x `height` 8-bit RGBA pixels, rows top to bottom, as a PNG.
+// The image data goes into stored (uncompressed) deflate blocks, so no zlib is
+// needed; files are larger than usual but identical pixels give identical bytes.
+void writePng(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba);
+
+} // namespace vkengine
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "chunk.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vkengine {
+
+// Chunks per region along each axis
+constexpr int REGION_SIZE = 32;
+constexpr int REGION_VOLUME = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+// Payloads start on sector boundaries so rewriting one chunk never moves another
+constexpr uint32_t REGION_SECTOR_SIZE = 512;
+
+// One file per REGION_SIZE^3 chunks:
+//   [magic, version, region size, sector size, header checksum u64, reserved u64]
+//   [REGION_VOLUME x {first sector, byte length, payload checksum u64}]   (0 length: chunk not stored)
+//   [sector-aligned chunk payloads]
+// Entries whose payloads are byte-identical (all-stone, all-water and other
+// repeated chunks) point at the same sectors, which are freed when the last
+// entry moves off them. All integers are little endian. Checksums are
+// hashBytes(); the header checksum covers the first four preamble fields and
+// the table, and is brought up to date by sync().
+//
+// Reads go through a shared memory mapping: opening a file only validates the
+// preamble, and a chunk read touches its own table entry and sectors and
+// checks the payload against its checksum. The sector allocation map is only
+// built on the first write.
+// What RegionFile::verify found in one file
+struct RegionReport {
+    // Local chunk index, or -1 for the file as a whole, and what is wrong
+    std::vector<std::pair<int, std::string>> problems;
+    size_t chunks = 0;
+    size_t bytesRead = 0;
+    uint32_t version = 0;   // before 3 there are no checksums and only bounds are checked
+};
+
+class RegionFile {
+public:
+    // Returns nullptr if the file does not exist and `create` is false
+    static std::unique_ptr<RegionFile> open(const std::string& path, bool create);
+
+    ~RegionFile();
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    bool hasChunk(int localIndex);
+    // Calls `visitor` with the payload while it is still in the mapping; no copy is made
+    bool visitChunk(int localIndex, const std::function<void(std::string_view)>& visitor);
+    bool readChunk(int localIndex, std::string& payload);
+    void writeChunk(int localIndex, const std::string& payload);
+
+    // Blocks until every write so far, and the header checksum covering it, is on stable storage
+    void sync();
+
+    static int localIndex(const ChunkCoord& coord);
+    static ChunkCoord regionCoord(const ChunkCoord& coord);
+    static ChunkCoord chunkCoord(const ChunkCoord& regionCoord, int localIndex);
+
+    // Checks a region file without mapping it or decoding any chunk: the
+    // preamble, the header checksum, every table entry's bounds and every
+    // payload against its checksum. Payloads are read in file order through
+    // one large buffer, so a check runs at sequential disk bandwidth.
+    static RegionReport verify(const std::string& path);
+
+private:
+    struct Entry {
+        uint32_t sector = 0;
+        uint32_t length = 0;
+        uint64_t checksum = 0;  // 0 in files older than version 3
+    };
+
+    // Sectors holding one payload and the table entries that point at them
+    struct Run {
+        uint32_t references = 0;
+        uint32_t length = 0;
+        uint64_t hash = 0;
+    };
+
+    explicit RegionFile(const std::string& path);
+
+    void validateHeader();
+    void writeHeader();
+    void writeHeaderChecksum();
+    // Rewrites an older-version file in the current layout; caller holds the unique lock
+    void upgrade();
+    Entry readEntry(int localIndex) const;
+    void writeEntry(int localIndex, const Entry& entry);
+    void remap();
+    void buildAllocationMap();
+    uint32_t allocateSectors(uint32_t count);
+    void markSectors(uint32_t first, uint32_t count, bool used);
+    // Drops one reference to the run `entry` points at, freeing it after the last
+    void releaseRun(const Entry& entry);
+
+    static uint32_t sectorsFor(uint32_t length) {
+        return (length + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+    }
+
+    std::string path;
+    MappedFile mapping;
+    uint32_t version = 0;
+    bool headerDirty = false;       // table written since the header checksum
+    std::fstream file;              // writes only, opened on the first write
+    std::vector<bool> usedSectors;  // empty until the first write
+    // Built with usedSectors: runs by first sector, and first sector by payload hash
+    std::unordered_map<uint32_t, Run> runs;
+    std::unordered_map<uint64_t, uint32_t> runsByContent;
+    std::shared_mutex mutex;
+};
+
+// Lazily opened region files under one directory
+class RegionStore {
+public:
+    explicit RegionStore(std::string directory);
+
+    bool hasChunk(const ChunkCoord& coord);
+    bool visitChunk(const ChunkCoord& coord, const std::function<void(std::string_view)>& visitor);
+    bool loadChunk(const ChunkCoord& coord, std::string& payload);
+    void saveChunk(const ChunkCoord& coord, const std::string& payload);
+    void sync();
+
+    const std::string& getDirectory() const { return directory; }
+
+private:
+    RegionFile* getRegion(const ChunkCoord& regionCoord, bool create);
+    std::string regionPath(const ChunkCoord& regionCoord) const;
+
+    std::string directory;
+
+    // nullptr entries remember regions that have no file yet
+    std::unordered_map<ChunkCoord, std::unique_ptr<RegionFile>, ChunkCoord::Hash> m_regions;
+    std::mutex regionsMutex;
+};
+
+} // namespace vkengine
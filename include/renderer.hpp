@@ -30,7 +30,8 @@ class Renderer {
         VkCommandBuffer beginFrame();
         void endFrame();
 
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // With secondary contents the viewport is left to the secondary buffers
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
         int getFrameIndex() const { 
@@ -39,6 +40,11 @@ class Renderer {
         }
 
         uint32_t getImageCount() const { return swapChain->imageCount(); }
+        VkExtent2D getSwapChainExtent() const { return swapChain->getSwapChainExtent(); }
+        VkFramebuffer getCurrentFramebuffer() const {
+            assert(isFrameStarted && "Cannot get framebuffer when frame not in progress.");
+            return swapChain->getFrameBuffer(currentImageIndex);
+        }
             
     private:
         void createCommandBuffers();
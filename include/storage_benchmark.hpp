@@ -0,0 +1,39 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace vkengine {
+
+class TerrainGenerator;
+
+// Compares the flat std::array<Block> chunk layout with BlockStorage on a
+// real generated region: generation, a face-visibility meshing pass, random
+// get/set and resident memory, then world reload meshing with a cold and a
+// warm mesh cache, then memory, mesh and region file size with and without
+// sharing identical chunks. Runs headless.
+class StorageBenchmark {
+public:
+    struct Options {
+        uint64_t seed = 0;
+        int renderDistance = 16;
+    };
+
+    explicit StorageBenchmark(Options options);
+
+    void run();
+
+private:
+    void runMeshCache(TerrainGenerator& generator, const std::vector<std::array<int, 6>>& neighbors);
+    void runDedup(TerrainGenerator& generator, const std::vector<std::array<int, 6>>& neighbors);
+
+    Options options;
+    std::vector<ChunkCoord> coords;
+    // Empty chunks in range, which get no Chunk at all
+    size_t skippedChunks = 0;
+};
+
+} // namespace vkengine
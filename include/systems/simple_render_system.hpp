@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../pipeline.hpp"
+#include "../pipeline_cache.hpp"
 #include "../device.hpp"
 #include "../game_object.hpp"
 #include "../camera.hpp"
@@ -8,7 +9,9 @@
 #include "../descriptors.hpp"     // Added for DescriptorSetLayout
 #include "../model.hpp"
 #include "../texture_manager.hpp" // Added for TextureManager
+#include "../parallel_recorder.hpp"
 
+#include <array>
 #include <memory>
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -17,7 +20,7 @@ namespace vkengine {
 
 class SimpleRenderSystem {
 public:
-    SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+    SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, PipelineCache &pipelineCache);
     ~SimpleRenderSystem();
 
     SimpleRenderSystem(const SimpleRenderSystem &) = delete;
@@ -26,20 +29,42 @@ public:
     void renderGameObjects(FrameInfo &frameInfo);
 
 private:
+    // What every command buffer recording part of the frame binds and reads
+    struct DrawState {
+        Pipeline *pipeline = nullptr;
+        VkDescriptorSet globalDescriptorSet = VK_NULL_HANDLE;
+        VkDescriptorSet textureDescriptorSet = VK_NULL_HANDLE;
+        glm::vec3 eye{0.f};
+        bool faceCulling = false;
+    };
+    struct DrawCounts {
+        size_t drawnIndices = 0;
+        size_t totalIndices = 0;
+    };
+
     void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-    void createPipelines(VkRenderPass renderPass);
+    // Records drawList[begin, end) into `commandBuffer`; safe to run on several threads at once
+    void recordDraws(VkCommandBuffer commandBuffer, const DrawState &state, size_t begin, size_t end, DrawCounts &counts);
+    // Records the chunk draws the GPU culling pass wrote this frame
+    void recordIndirectDraws(VkCommandBuffer commandBuffer, const DrawState &state, GpuCuller &gpuCuller);
+    // Pipelines are built the first time their render mode is drawn
+    Pipeline *getPipeline(RenderMode mode);
 
     Device &device;
+    PipelineCache &pipelineCache;
 
-    std::unique_ptr<Pipeline> uvPipeline;
-    std::unique_ptr<Pipeline> wireframePipeline;
-    std::unique_ptr<Pipeline> texturePipeline;
-    std::unique_ptr<Pipeline> colorPipeline;
+    // By RenderMode; null until first used
+    std::array<std::unique_ptr<Pipeline>, 4> pipelines;
+    // Referenced by the pipelines' create info, so it lives as long as they do
+    PipelineConfigInfo pipelineConfig{};
     
     VkPipelineLayout pipelineLayout;
 
     std::unique_ptr<DescriptorSetLayout> textureSetLayout; // For texture atlas
     VkDescriptorSet textureDescriptorSet = VK_NULL_HANDLE; // For storing the texture atlas descriptor set
+
+    // Objects drawn this frame, split into contiguous slices across recording threads
+    std::vector<GameObject *> drawList;
 };
 
 } // namespace vkengine
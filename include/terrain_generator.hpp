@@ -0,0 +1,168 @@
+#pragma once
+
+#include "chunk.hpp"
+#include "decoration_buffer.hpp"
+#include "hash.hpp"
+#include "perlin_noise.hpp"
+
+#include <array>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace vkengine {
+
+// Biome fields are sampled once every BIOME_CELL_SIZE blocks and bilinearly
+// interpolated in between. The grid includes the far edge so neighbouring
+// columns interpolate from identical corner samples.
+constexpr int BIOME_CELL_SIZE = 4;
+constexpr int BIOME_GRID_SIZE = CHUNK_SIZE / BIOME_CELL_SIZE + 1;
+
+// Tallest decoration above the surface block (trunk plus canopy)
+constexpr int TREE_MAX_HEIGHT = 8;
+
+struct TerrainSettings {
+    PerlinNoise temperatureNoise;
+    PerlinNoise humidityNoise;
+    PerlinNoise elevationNoise;
+    PerlinNoise riverNoise;
+    PerlinNoise caveNoise;
+    PerlinNoise oreNoise;
+
+    // -- 2D Biomes Map --
+    double temperatureFrequency = 0.001;
+    double humidityFrequency = 0.001;
+
+    // -- Heightmap Generation --
+    double elevFrequency = 0.1;
+    int elevOctaves = 4;
+    double elevPersistence = 0.5;
+    double elevHeightScale = 100.0;
+    double elevBaseHeight = 0.0;
+
+    // -- River Carving --
+    double riverFrequency = 0.001;
+    double riverThreshold = 0.3;
+    double riverBedHeight = CHUNK_SIZE * 0.25f;
+
+    // -- Caves --
+    double caveFrequency = 0.1;
+    double caveThreshold = 0.6;
+
+    // -- Soil --
+    int baseSoilDepth = 3;
+    double soilDepthVariation = 0.5;
+
+    int maxHeight = -256;
+    int minHeight = 256;
+
+    TerrainSettings(uint64_t seed = 0) :
+        temperatureNoise(seed + 1),
+        humidityNoise(seed + 2),
+        elevationNoise(seed + 3),
+        riverNoise(seed + 4),
+        caveNoise(seed + 5),
+        oreNoise(seed + 6) {}
+};
+
+struct ColumnCoord {
+    int x;
+    int z;
+
+    bool operator==(const ColumnCoord& other) const {
+        return x == other.x && z == other.z;
+    }
+
+    struct Hash {
+        std::size_t operator()(const ColumnCoord& coord) const {
+            uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.z);
+            return static_cast<std::size_t>(splitmix64(key));
+        }
+    };
+};
+
+// Everything about a 16x16 column of the world that does not depend on y.
+// Computed once and shared by every vertical chunk of the column.
+struct TerrainColumn {
+    // Coarse biome grid, indexed [gx + gz * BIOME_GRID_SIZE]
+    std::array<float, BIOME_GRID_SIZE * BIOME_GRID_SIZE> temperature{};
+    std::array<float, BIOME_GRID_SIZE * BIOME_GRID_SIZE> humidity{};
+    std::array<float, BIOME_GRID_SIZE * BIOME_GRID_SIZE> river{};
+
+    // Per-block results, indexed [x + z * CHUNK_SIZE]
+    std::array<int, CHUNK_SIZE * CHUNK_SIZE> height{};
+    std::array<int, CHUNK_SIZE * CHUNK_SIZE> waterLevel{};
+    std::array<uint8_t, CHUNK_SIZE * CHUNK_SIZE> soilDepth{};
+    std::array<BlockType, CHUNK_SIZE * CHUNK_SIZE> surfaceBlock{};
+    std::array<BlockType, CHUNK_SIZE * CHUNK_SIZE> soilBlock{};
+
+    int minHeight = 0;
+    int maxHeight = 0;
+};
+
+// Surface of a single world column: everything coarse terrain needs
+struct SurfaceSample {
+    int height = 0;
+    int waterLevel = 0;
+    uint8_t soilDepth = 0;
+    BlockType surfaceBlock = BlockType::AIR;
+    BlockType soilBlock = BlockType::AIR;
+};
+
+class TerrainGenerator {
+public:
+    TerrainGenerator(uint64_t seed = 0);
+
+    TerrainGenerator(const TerrainGenerator&) = delete;
+    TerrainGenerator& operator=(const TerrainGenerator&) = delete;
+
+    // Cached per-column data; safe to call from any terrain thread
+    std::shared_ptr<const TerrainColumn> getColumn(const ColumnCoord& coord);
+
+    void generateChunk(const ChunkCoord& coord, std::array<Block, CHUNK_VOLUME>& blocks);
+
+    // Places the decorations rooted in this chunk. Blocks that land in other
+    // chunks are queued in `decorations` instead of being written directly.
+    void decorateChunk(const ChunkCoord& coord, std::array<Block, CHUNK_VOLUME>& blocks, DecorationBuffer& decorations);
+
+    // Terrain, decorations, then every write other chunks queued for this one
+    void populateChunk(const ChunkCoord& coord, std::array<Block, CHUNK_VOLUME>& blocks, DecorationBuffer& decorations);
+
+    // True if the chunk and the layer below it are provably air, so nothing in
+    // the chunk can be visible and no surface chunk needs it as a neighbour
+    bool isChunkEmpty(const ChunkCoord& coord);
+
+    // Surface at one world position without building the whole column. On
+    // multiples of BIOME_CELL_SIZE this matches the full-resolution column exactly.
+    SurfaceSample sampleSurface(int worldX, int worldZ) const;
+
+    // Drop cached columns further than `radius` columns from the center
+    void evictColumns(const ChunkCoord& center, int radius);
+
+    // World height (up is positive) of the block at local y inside chunk layer chunkY
+    static int blockHeight(int chunkY, int localY) {
+        return (CHUNK_SIZE - 1) - (chunkY * CHUNK_SIZE + localY);
+    }
+
+    const TerrainSettings& getSettings() const { return settings; }
+
+    // Highest non-air block anywhere in the world, from the noise amplitude alone
+    int globalMaxHeight() const;
+
+private:
+    std::shared_ptr<TerrainColumn> buildColumn(const ColumnCoord& coord) const;
+    void sampleBiomeGrid(const ColumnCoord& coord, TerrainColumn& column) const;
+    void sampleBiome(double worldX, double worldZ, float& temperature, float& humidity, float& river) const;
+    SurfaceSample computeSurface(int worldX, int worldZ, float temperature, float humidity, float river) const;
+    float biomeLookup(const std::array<float, BIOME_GRID_SIZE * BIOME_GRID_SIZE>& grid, int x, int z) const;
+    void placeTree(const ChunkCoord& origin, std::array<Block, CHUNK_VOLUME>& blocks, DecorationBuffer& decorations,
+                   int worldX, int surfaceHeight, int worldZ, int trunkHeight) const;
+
+    uint64_t seed;
+    TerrainSettings settings;
+
+    std::unordered_map<ColumnCoord, std::shared_ptr<const TerrainColumn>, ColumnCoord::Hash> m_columns;
+    std::shared_mutex columnsMutex;
+};
+
+} // namespace vkengine
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace vkengine {
+
+// Epochs behind copy-on-write world snapshots. Taking a snapshot only bumps
+// the epoch; no chunk is touched. A chunk written while a snapshot is active
+// first sets its current storage aside for that snapshot and then writes to
+// a private copy (Chunk::prepareWrite), so chunks that are never written
+// during a save are never copied. One snapshot is active at a time.
+class WorldSnapshots {
+public:
+    // Returns the new snapshot's epoch
+    uint64_t begin() {
+        uint64_t snapshot = ++epoch;
+        activeEpoch = snapshot;
+        return snapshot;
+    }
+
+    void end() { activeEpoch = 0; }
+
+    // Epoch of the snapshot being read, 0 if none
+    uint64_t active() const { return activeEpoch; }
+
+private:
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<uint64_t> activeEpoch{0};
+};
+
+} // namespace vkengine
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+namespace vkengine {
+
+// Offline integrity check of a saved world: every region file's header and
+// chunk checksums (RegionFile::verify), several files at a time. No chunk is
+// decoded and the engine is not started. Prints every corrupt chunk.
+class WorldVerifier {
+public:
+    struct Options {
+        std::string directory = "data/world";
+        int threads = 0;    // 0: hardware concurrency
+    };
+
+    explicit WorldVerifier(Options options);
+
+    // Returns false if anything is corrupt
+    bool run();
+
+private:
+    Options options;
+};
+
+} // namespace vkengine
@@ -14,13 +14,26 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     vec4 ambientLightColor;
 } ubo;
 
+// Chunks drawn by the GPU culling pass; their draws carry the record index as firstInstance
+struct ChunkRecord {
+    ivec4 origin;
+    uint faceOffsets[7];
+    int vertexOffset;
+};
+
+layout(set = 0, binding = 1) readonly buffer ChunkRecords {
+    ChunkRecord records[];
+} chunkRecords;
+
 layout(push_constant) uniform Push {
+    ivec4 chunkOrigin; // w == 1: a chunk, placed by its origin; w == 2: by its record; the matrices are not set
     mat4 modelMatrix; 
     mat4 normalMatrix;
 } push;
 
 void main() {
-    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+    ivec4 origin = push.chunkOrigin.w == 2 ? chunkRecords.records[gl_InstanceIndex].origin : push.chunkOrigin;
+    vec4 positionWorld = origin.w != 0 ? vec4(position + vec3(origin.xyz), 1.0) : push.modelMatrix * vec4(position, 1.0);
     gl_Position = ubo.projection * ubo.view * positionWorld;
     fragColor = color;
 }
@@ -14,13 +14,27 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 view;       // Added view matrix
 } ubo;
 
+// Chunks drawn by the GPU culling pass; their draws carry the record index as firstInstance
+struct ChunkRecord {
+    ivec4 origin;
+    uint faceOffsets[7];
+    int vertexOffset;
+};
+
+layout(set = 0, binding = 1) readonly buffer ChunkRecords {
+    ChunkRecord records[];
+} chunkRecords;
+
 layout(push_constant) uniform PushConstantData {
+    ivec4 chunkOrigin; // w == 1: a chunk, placed by its origin; w == 2: by its record; the matrices are not set
     mat4 modelMatrix;
     mat4 normalMatrix;
 } pushConstants;
 
 void main() {
-    gl_Position = ubo.projection * ubo.view * pushConstants.modelMatrix * vec4(inPosition, 1.0); // Updated to use projection and view
+    ivec4 origin = pushConstants.chunkOrigin.w == 2 ? chunkRecords.records[gl_InstanceIndex].origin : pushConstants.chunkOrigin;
+    vec4 positionWorld = origin.w != 0 ? vec4(inPosition + vec3(origin.xyz), 1.0) : pushConstants.modelMatrix * vec4(inPosition, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld; // Updated to use projection and view
     fragTexCoord = inTexCoord;
     fragTexLayer = inBlockType; // Use inBlockType for the texture layer
 }
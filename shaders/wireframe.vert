@@ -7,7 +7,19 @@ layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 layout(location = 4) in uint block_type;
 
+// Chunks drawn by the GPU culling pass; their draws carry the record index as firstInstance
+struct ChunkRecord {
+    ivec4 origin;
+    uint faceOffsets[7];
+    int vertexOffset;
+};
+
+layout(set = 0, binding = 1) readonly buffer ChunkRecords {
+    ChunkRecord records[];
+} chunkRecords;
+
 layout(push_constant) uniform Push {
+    ivec4 chunkOrigin; // w == 1: a chunk, placed by its origin; w == 2: by its record; the matrices are not set
     mat4 modelMatrix;
     mat4 normalMatrix; // Unused in this shader, but part of the push constant block
 } push;
@@ -21,5 +33,7 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 } ubo;
 
 void main() {
-    gl_Position = ubo.projectionMatrix * ubo.viewMatrix * push.modelMatrix * vec4(position, 1.0);
+    ivec4 origin = push.chunkOrigin.w == 2 ? chunkRecords.records[gl_InstanceIndex].origin : push.chunkOrigin;
+    vec4 positionWorld = origin.w != 0 ? vec4(position + vec3(origin.xyz), 1.0) : push.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projectionMatrix * ubo.viewMatrix * positionWorld;
 }
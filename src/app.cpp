@@ -9,7 +9,10 @@
 #include "../include/chunk_manager.hpp"
 #include "../include/scope_timer.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <iostream>
+#include <thread>
 #include <vulkan/vulkan_core.h>
 
 #define GLM_FORCE_RADIANS
@@ -24,12 +27,18 @@ App::App() {
     globalPool = DescriptorPool::Builder(device)
         .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
         .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
         .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT + 1)
         .build();
     
     // Initialize chunk manager
     chunkManager = std::make_unique<ChunkManager>(device);
     textureManager = std::make_shared<TextureManager>(device);
+    // One core is left for the main thread, which waits while the workers record
+    unsigned cores = std::thread::hardware_concurrency();
+    recorder = std::make_unique<ParallelRecorder>(device, static_cast<int>(std::clamp(cores > 1 ? cores - 1 : 1u, 1u, 8u)));
+    gpuCuller = std::make_unique<GpuCuller>(device, pipelineCache, static_cast<uint32_t>(std::max(config().getInt("gpu_culling_chunks"), 1)));
+    gpuProfiler = std::make_unique<GpuProfiler>(device);
 
     textureManager->loadTextures();
     
@@ -39,7 +48,7 @@ App::App() {
 App::~App() {}
 
 void App::run() {
-    Imgui imgui{window, device, renderer.getSwapChainRenderPass(), renderer.getImageCount()};
+    Imgui imgui{window, device, renderer.getSwapChainRenderPass(), renderer.getImageCount(), pipelineCache.getCache()};
 
     std::vector<std::unique_ptr<Buffer>> uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT);
     for (size_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
@@ -54,17 +63,20 @@ void App::run() {
 
     auto globalSetLayout = DescriptorSetLayout::Builder(device)
         .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+        .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
         .build();
 
     std::vector<VkDescriptorSet> globalDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT);
     for (int i=0; i< globalDescriptorSets.size(); i++) {
         auto bufferInfo = uboBuffers[i]->descriptorInfo();
+        auto recordsInfo = gpuCuller->getRecordsInfo(i);
         DescriptorWriter(*globalSetLayout, *globalPool)
             .writeBuffer(0, &bufferInfo)
+            .writeBuffer(1, &recordsInfo)
             .build(globalDescriptorSets[i]);
     }
  
-    SimpleRenderSystem simpleRenderSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+    SimpleRenderSystem simpleRenderSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), pipelineCache};
     Camera camera{};
     camera.setViewDirection(glm::vec3(0.f), glm::vec3(0.0, 0.2f, 1.0f));
 
@@ -98,11 +110,19 @@ void App::run() {
                 if(frameCount % 20 == 0) {
                     chunkManager->update(viewerObject->transform.translation, config().getInt("render_distance"), gameObjects);
                 }   
+                chunkManager->uploadCoarseTerrain(gameObjects);
+                chunkManager->updateVisibleChunks(viewerObject->transform.translation, camera.getDirection(), config().getInt("render_distance"), gameObjects);
+                chunkManager->updateOcclusion(viewerObject->transform.translation, camera.getProjection() * camera.getView(), gameObjects);
             }
             
             imgui.newFrame();
             int frameIndex = renderer.getFrameIndex();
             FrameInfo frameInfo{frameIndex, frameTime, commandBuffer, camera, globalDescriptorSets[frameIndex], gameObjects, chunkManager.get(), textureManager, globalPool};
+            frameInfo.recorder = recorder.get();
+            frameInfo.gpuCuller = gpuCuller.get();
+            frameInfo.gpuProfiler = gpuProfiler.get();
+            recorder->setThreadCount(config().getInt("record_threads"));
+            recorder->beginFrame(frameIndex, renderer.getSwapChainRenderPass(), renderer.getCurrentFramebuffer(), renderer.getSwapChainExtent());
 
             //update
             GlobalUbo ubo{};
@@ -111,14 +131,81 @@ void App::run() {
             uboBuffers[frameIndex]->writeToBuffer(&ubo);
             uboBuffers[frameIndex]->flush();
 
+            // The culling pass goes before the render pass; the chunks it keeps are drawn inside it
+            bool gpuCulling = chunkManager->flags & ChunkManagerFlags::GPU_CULLING;
+            if (gpuCulling) {
+                gpuCuller->updateChunks(gameObjects, chunkManager->getMeshGeneration());
+            } else if (gpuCuller->getChunkCount() > 0) {
+                gpuCuller->clear();
+            }
+            gpuCuller->beginFrame(frameIndex);
+            gpuProfiler->beginFrame(commandBuffer, frameIndex);
+            gpuProfiler->beginScope(commandBuffer, "frame");
+            if (gpuCulling) {
+                chunkManager->forEachCulled([&](GameObject::id_t objectId) { gpuCuller->hide(objectId); });
+                gpuProfiler->beginScope(commandBuffer, "GPU culling");
+                gpuCuller->cull(commandBuffer, camera.getProjection() * camera.getView(), viewerObject->transform.translation,
+                                chunkManager->flags & ChunkManagerFlags::FACE_CULLING);
+                gpuProfiler->endScope(commandBuffer, "GPU culling");
+            }
+
             //render
-            renderer.beginSwapChainRenderPass(commandBuffer);
+            bool parallel = recorder->isParallel();
+            // A pass with secondary contents only takes vkCmdExecuteCommands, so
+            // there the timestamps go into a secondary buffer of their own
+            auto timestamp = [&](auto write) {
+                if (!parallel) {
+                    write(commandBuffer);
+                    return;
+                }
+                VkCommandBuffer marker = recorder->beginSecondary();
+                write(marker);
+                recorder->endSecondary(marker);
+                vkCmdExecuteCommands(commandBuffer, 1, &marker);
+            };
+            renderer.beginSwapChainRenderPass(commandBuffer, parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+            if (gpuProfiler->isSupported()) {
+                timestamp([&](VkCommandBuffer buffer) { gpuProfiler->beginScope(buffer, "terrain pass"); });
+            }
             simpleRenderSystem.renderGameObjects(frameInfo);
+            if (gpuProfiler->isSupported()) {
+                timestamp([&](VkCommandBuffer buffer) { gpuProfiler->endScope(buffer, "terrain pass"); });
+            }
             imgui.debugWindow(frameInfo);
-            imgui.render(commandBuffer);
+            if (parallel) {
+                // The overlay cannot be recorded inline into a pass with secondary contents
+                VkCommandBuffer overlay = recorder->beginSecondary();
+                gpuProfiler->beginScope(overlay, "ImGui pass");
+                imgui.render(overlay);
+                gpuProfiler->endScope(overlay, "ImGui pass");
+                recorder->endSecondary(overlay);
+                vkCmdExecuteCommands(commandBuffer, 1, &overlay);
+            } else {
+                gpuProfiler->beginScope(commandBuffer, "ImGui pass");
+                imgui.render(commandBuffer);
+                gpuProfiler->endScope(commandBuffer, "ImGui pass");
+            }
             renderer.endSwapChainRenderPass(commandBuffer); 
+            gpuProfiler->endScope(commandBuffer, "frame");
             renderer.endFrame();
 
+            if (frameCount == 0) {
+                float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                std::cout << "Startup: first frame after " << milliseconds << " ms ("
+                          << (pipelineCache.isWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+                // Saved now as well as at exit, so a crash later still keeps the next start warm
+                pipelineCache.save();
+            }
+            if (!terrainShown) {
+                // Coarse tiles and chunks only join the game objects once they have a model
+                terrainShown = std::any_of(gameObjects.begin(), gameObjects.end(), [](const auto& entry) { return entry.second->model != nullptr; });
+                if (terrainShown) {
+                    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                    bool coarse = chunkManager->flags & ChunkManagerFlags::COARSE_TERRAIN;
+                    std::cout << "Startup: terrain on screen after " << milliseconds << " ms, frame " << frameCount
+                              << (coarse ? " (coarse terrain on" : " (coarse terrain off") << ", goal 100 ms)" << std::endl;
+                }
+            }
             frameCount++;
         }
     }
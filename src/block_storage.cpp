@@ -0,0 +1,126 @@
+#include "block_storage.hpp"
+#include "chunk.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+
+namespace vkengine {
+
+static_assert(BlockStorage::VOLUME == CHUNK_VOLUME, "block storage is sized for one chunk");
+
+// Smallest supported index width that can address `paletteSize` entries
+static int bitsFor(size_t paletteSize) {
+    if (paletteSize <= 1) return 0;
+    if (paletteSize <= 2) return 1;
+    if (paletteSize <= 4) return 2;
+    if (paletteSize <= 16) return 4;
+    return 8;
+}
+
+BlockStorage::BlockStorage() : palette{BlockType::AIR} {}
+
+void BlockStorage::writeIndex(int index, uint64_t paletteIndex) {
+    unsigned bit = static_cast<unsigned>(index) * bits;
+    uint64_t& word = words[bit >> 6];
+    unsigned shift = bit & 63;
+    word = (word & ~(mask() << shift)) | (paletteIndex << shift);
+}
+
+void BlockStorage::set(int index, BlockType type) {
+    auto it = std::find(palette.begin(), palette.end(), type);
+    size_t paletteIndex = static_cast<size_t>(it - palette.begin());
+
+    if (it == palette.end()) {
+        if (bitsFor(palette.size() + 1) > bits) {
+            resize(bitsFor(palette.size() + 1));
+        }
+        palette.push_back(type);
+    }
+
+    if (bits > 0) {
+        writeIndex(index, paletteIndex);
+    }
+}
+
+void BlockStorage::fill(BlockType type) {
+    palette.assign(1, type);
+    words.clear();
+    words.shrink_to_fit();
+    bits = 0;
+}
+
+void BlockStorage::resize(int newBits) {
+    // Repack existing indices at the new width; palette order is unchanged
+    std::vector<uint64_t> newWords(static_cast<size_t>(VOLUME) * newBits / 64, 0);
+    for (int i = 0; i < VOLUME; ++i) {
+        uint64_t paletteIndex = 0;
+        if (bits > 0) {
+            unsigned bit = static_cast<unsigned>(i) * bits;
+            paletteIndex = (words[bit >> 6] >> (bit & 63)) & mask();
+        }
+        unsigned newBit = static_cast<unsigned>(i) * newBits;
+        newWords[newBit >> 6] |= paletteIndex << (newBit & 63);
+    }
+    words = std::move(newWords);
+    bits = static_cast<uint8_t>(newBits);
+}
+
+void BlockStorage::pack(const std::array<Block, VOLUME>& blocks) {
+    // Block ids are small; a direct lookup avoids searching the palette per block
+    std::array<int16_t, 256> lookup;
+    lookup.fill(-1);
+
+    palette.clear();
+    for (const Block& block : blocks) {
+        uint8_t id = static_cast<uint8_t>(block.type);
+        if (lookup[id] < 0) {
+            lookup[id] = static_cast<int16_t>(palette.size());
+            palette.push_back(block.type);
+        }
+    }
+    palette.shrink_to_fit();
+
+    bits = static_cast<uint8_t>(bitsFor(palette.size()));
+    words.assign(static_cast<size_t>(VOLUME) * bits / 64, 0);
+    words.shrink_to_fit();
+    if (bits == 0) return;
+
+    for (int i = 0; i < VOLUME; ++i) {
+        unsigned bit = static_cast<unsigned>(i) * bits;
+        words[bit >> 6] |= static_cast<uint64_t>(lookup[static_cast<uint8_t>(blocks[i].type)]) << (bit & 63);
+    }
+}
+
+void BlockStorage::unpack(std::array<Block, VOLUME>& blocks) const {
+    if (bits == 0) {
+        blocks.fill(Block(palette[0]));
+        return;
+    }
+
+    // Whole words at a time: 64 / bits entries per word, never split across words
+    int perWord = 64 / bits;
+    uint64_t entryMask = mask();
+    int index = 0;
+    for (uint64_t word : words) {
+        for (int j = 0; j < perWord; ++j) {
+            blocks[index++].type = palette[word & entryMask];
+            word >>= bits;
+        }
+    }
+}
+
+size_t BlockStorage::memoryUsage() const {
+    return sizeof(*this) + palette.capacity() * sizeof(BlockType) + words.capacity() * sizeof(uint64_t);
+}
+
+uint64_t BlockStorage::contentHash() const {
+    uint64_t hash = hashBytes(palette.data(), palette.size() * sizeof(BlockType), bits);
+    return hashBytes(words.data(), words.size() * sizeof(uint64_t), hash);
+}
+
+ContentPool<BlockStorage>& blockStoragePool() {
+    static ContentPool<BlockStorage> pool;
+    return pool;
+}
+
+} // namespace vkengine
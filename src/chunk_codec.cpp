@@ -0,0 +1,305 @@
+#include "chunk_codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace vkengine {
+
+// ——— Varint RLE ———
+
+void VarintRleCodec::encode(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) const {
+    size_t i = 0;
+    while (i < blocks.size()) {
+        BlockType type = blocks[i].type;
+        size_t run = 1;
+        while (i + run < blocks.size() && blocks[i + run].type == type) {
+            ++run;
+        }
+
+        out.push_back(static_cast<char>(type));
+        for (size_t value = run; ; value >>= 7) {
+            if (value < 0x80) {
+                out.push_back(static_cast<char>(value));
+                break;
+            }
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        }
+        i += run;
+    }
+}
+
+void VarintRleCodec::decode(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) const {
+    size_t read = 0;
+    size_t write = 0;
+    while (write < blocks.size()) {
+        if (read >= in.size()) {
+            throw std::runtime_error("Truncated varint RLE chunk");
+        }
+        BlockType type = static_cast<BlockType>(static_cast<uint8_t>(in[read++]));
+
+        size_t run = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (read >= in.size() || shift > 14) {
+                throw std::runtime_error("Malformed varint RLE run");
+            }
+            uint8_t byte = static_cast<uint8_t>(in[read++]);
+            run |= static_cast<size_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (run == 0 || write + run > blocks.size()) {
+            throw std::runtime_error("Malformed varint RLE run");
+        }
+
+        for (size_t end = write + run; write < end; ++write) {
+            blocks[write].type = type;
+        }
+    }
+}
+
+// ——— Palette + bitpack ———
+
+static int paletteBits(size_t paletteSize) {
+    if (paletteSize <= 1) return 0;
+    if (paletteSize <= 2) return 1;
+    if (paletteSize <= 4) return 2;
+    if (paletteSize <= 16) return 4;
+    return 8;
+}
+
+void PaletteCodec::encode(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) const {
+    std::array<int, 256> lookup;
+    lookup.fill(-1);
+    std::vector<uint8_t> palette;
+    for (const Block& block : blocks) {
+        uint8_t type = static_cast<uint8_t>(block.type);
+        if (lookup[type] < 0) {
+            lookup[type] = static_cast<int>(palette.size());
+            palette.push_back(type);
+        }
+    }
+
+    // A full 256-entry palette is stored as size 0
+    out.push_back(static_cast<char>(palette.size() & 0xFF));
+    out.append(reinterpret_cast<const char*>(palette.data()), palette.size());
+
+    int bits = paletteBits(palette.size());
+    if (bits == 0) return;
+
+    uint32_t accumulator = 0;
+    int filled = 0;
+    for (const Block& block : blocks) {
+        accumulator |= static_cast<uint32_t>(lookup[static_cast<uint8_t>(block.type)]) << filled;
+        filled += bits;
+        if (filled == 8) {
+            out.push_back(static_cast<char>(accumulator));
+            accumulator = 0;
+            filled = 0;
+        }
+    }
+}
+
+void PaletteCodec::decode(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) const {
+    if (in.empty()) {
+        throw std::runtime_error("Truncated palette chunk");
+    }
+    size_t paletteSize = static_cast<uint8_t>(in[0]);
+    if (paletteSize == 0) paletteSize = 256;
+    if (in.size() < 1 + paletteSize) {
+        throw std::runtime_error("Truncated palette chunk");
+    }
+    const char* palette = in.data() + 1;
+
+    int bits = paletteBits(paletteSize);
+    if (bits == 0) {
+        blocks.fill(Block(static_cast<BlockType>(static_cast<uint8_t>(palette[0]))));
+        return;
+    }
+
+    const char* packed = palette + paletteSize;
+    if (in.size() != 1 + paletteSize + blocks.size() * bits / 8) {
+        throw std::runtime_error("Truncated palette chunk");
+    }
+    uint32_t mask = (1u << bits) - 1;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        size_t bit = i * bits;
+        uint32_t index = (static_cast<uint8_t>(packed[bit >> 3]) >> (bit & 7)) & mask;
+        if (index >= paletteSize) {
+            throw std::runtime_error("Palette index out of range");
+        }
+        blocks[i].type = static_cast<BlockType>(static_cast<uint8_t>(palette[index]));
+    }
+}
+
+// ——— LZ ———
+
+static constexpr int LZ_MIN_MATCH = 4;
+static constexpr int LZ_HASH_BITS = 12;
+// The format requires the last literals to be copied, never matched
+static constexpr int LZ_LAST_LITERALS = 5;
+
+static void lzAppendLength(std::string& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+static void lzAppendSequence(std::string& out, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength >= LZ_MIN_MATCH ? matchLength - LZ_MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15));
+    out.push_back(static_cast<char>(token));
+    if (literalLength >= 15) {
+        lzAppendLength(out, literalLength - 15);
+    }
+    out.append(reinterpret_cast<const char*>(literals), literalLength);
+
+    // The final sequence is literals only
+    if (matchLength == 0) return;
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) {
+        lzAppendLength(out, matchCode - 15);
+    }
+}
+
+void LzCodec::encode(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) const {
+    std::array<uint8_t, CHUNK_VOLUME> bytes;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(blocks[i].type);
+    }
+
+    auto read32 = [&](size_t at) {
+        uint32_t value;
+        std::memcpy(&value, &bytes[at], sizeof(value));
+        return value;
+    };
+    auto hash = [](uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+    };
+
+    // Last position each 4-byte sequence was seen at, plus one (0: never)
+    std::array<uint16_t, 1 << LZ_HASH_BITS> table{};
+
+    const size_t matchLimit = bytes.size() - LZ_LAST_LITERALS;
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + LZ_MIN_MATCH <= matchLimit) {
+        uint32_t sequence = read32(pos);
+        uint32_t slot = hash(sequence);
+        size_t candidate = table[slot];
+        table[slot] = static_cast<uint16_t>(pos + 1);
+
+        if (candidate == 0 || read32(candidate - 1) != sequence) {
+            ++pos;
+            continue;
+        }
+        size_t matchStart = candidate - 1;
+
+        size_t length = LZ_MIN_MATCH;
+        while (pos + length < matchLimit && bytes[matchStart + length] == bytes[pos + length]) {
+            ++length;
+        }
+
+        lzAppendSequence(out, &bytes[anchor], pos - anchor, pos - matchStart, length);
+        pos += length;
+        anchor = pos;
+    }
+    lzAppendSequence(out, &bytes[anchor], bytes.size() - anchor, 0, 0);
+}
+
+void LzCodec::decode(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) const {
+    std::array<uint8_t, CHUNK_VOLUME> bytes;
+    size_t read = 0;
+    size_t write = 0;
+
+    auto readLength = [&](size_t length) {
+        if (length != 15) return length;
+        uint8_t byte;
+        do {
+            if (read >= in.size()) throw std::runtime_error("Truncated LZ chunk");
+            byte = static_cast<uint8_t>(in[read++]);
+            length += byte;
+        } while (byte == 255);
+        return length;
+    };
+
+    while (true) {
+        if (read >= in.size()) throw std::runtime_error("Truncated LZ chunk");
+        uint8_t token = static_cast<uint8_t>(in[read++]);
+
+        size_t literalLength = readLength(token >> 4);
+        if (read + literalLength > in.size() || write + literalLength > bytes.size()) {
+            throw std::runtime_error("Malformed LZ literals");
+        }
+        std::memcpy(&bytes[write], in.data() + read, literalLength);
+        read += literalLength;
+        write += literalLength;
+
+        if (read == in.size()) break;
+
+        if (read + 2 > in.size()) throw std::runtime_error("Truncated LZ chunk");
+        size_t offset = static_cast<uint8_t>(in[read]) | (static_cast<size_t>(static_cast<uint8_t>(in[read + 1])) << 8);
+        read += 2;
+        size_t matchLength = readLength(token & 0x0F) + LZ_MIN_MATCH;
+        if (offset == 0 || offset > write || write + matchLength > bytes.size()) {
+            throw std::runtime_error("Malformed LZ match");
+        }
+
+        // Byte by byte: matches may overlap their own output
+        for (size_t i = 0; i < matchLength; ++i, ++write) {
+            bytes[write] = bytes[write - offset];
+        }
+    }
+
+    if (write != bytes.size()) {
+        throw std::runtime_error("LZ chunk has the wrong block count");
+    }
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        blocks[i].type = static_cast<BlockType>(bytes[i]);
+    }
+}
+
+// ——— Registry ———
+
+const std::vector<const ChunkCodec*>& chunkCodecs() {
+    static const VarintRleCodec varintRle;
+    static const PaletteCodec palette;
+    static const LzCodec lz;
+    static const std::vector<const ChunkCodec*> codecs{&varintRle, &palette, &lz};
+    return codecs;
+}
+
+const ChunkCodec& chunkCodec(ChunkCodecId id) {
+    for (const ChunkCodec* codec : chunkCodecs()) {
+        if (codec->id() == id) {
+            return *codec;
+        }
+    }
+    throw std::runtime_error("Unknown chunk codec " + std::to_string(static_cast<int>(id)));
+}
+
+void encodeSmallest(const std::array<Block, CHUNK_VOLUME>& blocks, std::string& out) {
+    std::string best;
+    std::string candidate;
+    for (const ChunkCodec* codec : chunkCodecs()) {
+        candidate.clear();
+        candidate.push_back(static_cast<char>(codec->id()));
+        codec->encode(blocks, candidate);
+        if (best.empty() || candidate.size() < best.size()) {
+            std::swap(best, candidate);
+        }
+    }
+    out += best;
+}
+
+void decodeTagged(std::string_view in, std::array<Block, CHUNK_VOLUME>& blocks) {
+    if (in.empty()) {
+        throw std::runtime_error("Chunk payload has no codec tag");
+    }
+    chunkCodec(static_cast<ChunkCodecId>(static_cast<uint8_t>(in[0]))).decode(in.substr(1), blocks);
+}
+
+} // namespace vkengine
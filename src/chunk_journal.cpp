@@ -0,0 +1,111 @@
+#include "chunk_journal.hpp"
+#include "byte_io.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "region_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <stdexcept>
+
+namespace vkengine {
+
+static constexpr uint32_t JOURNAL_MAGIC = 0x524A4B56;  // "VKJR"
+static constexpr size_t JOURNAL_RECORD_HEADER = 28;
+
+ChunkJournal::ChunkJournal(std::string path) : path{std::move(path)} {}
+
+ChunkJournal::~ChunkJournal() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void ChunkJournal::openForAppend() {
+    if (fd >= 0) return;
+
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open chunk journal: " + path);
+    }
+}
+
+size_t ChunkJournal::replay(RegionStore& store) {
+    MappedFile mapping;
+    if (!mapping.map(path)) {
+        return 0;
+    }
+
+    size_t applied = 0;
+    size_t offset = 0;
+    const char* data = mapping.data();
+    while (offset + JOURNAL_RECORD_HEADER <= mapping.size()) {
+        const char* header = data + offset;
+        if (getU32(header) != JOURNAL_MAGIC) break;
+
+        ChunkCoord coord{static_cast<int32_t>(getU32(header + 4)), static_cast<int32_t>(getU32(header + 8)), static_cast<int32_t>(getU32(header + 12))};
+        uint32_t length = getU32(header + 16);
+        uint64_t checksum = getU64(header + 20);
+        if (offset + JOURNAL_RECORD_HEADER + length > mapping.size()) break;
+
+        const char* payload = header + JOURNAL_RECORD_HEADER;
+        if (hashBytes(payload, length) != checksum) break;
+
+        store.saveChunk(coord, std::string(payload, length));
+        offset += JOURNAL_RECORD_HEADER + length;
+        ++applied;
+    }
+
+    if (applied > 0) {
+        store.sync();
+    }
+    mapping.unmap();
+    reset();
+    return applied;
+}
+
+void ChunkJournal::append(const std::vector<std::pair<ChunkCoord, std::string>>& batch) {
+    if (batch.empty()) return;
+    openForAppend();
+
+    std::string records;
+    for (const auto& [coord, payload] : batch) {
+        appendU32(records, JOURNAL_MAGIC);
+        appendU32(records, static_cast<uint32_t>(coord.x));
+        appendU32(records, static_cast<uint32_t>(coord.y));
+        appendU32(records, static_cast<uint32_t>(coord.z));
+        appendU32(records, static_cast<uint32_t>(payload.size()));
+        appendU64(records, hashBytes(payload.data(), payload.size()));
+        records += payload;
+    }
+
+    size_t written = 0;
+    while (written < records.size()) {
+        ssize_t result = ::write(fd, records.data() + written, records.size() - written);
+        if (result < 0) {
+            throw std::runtime_error("Failed to append to chunk journal: " + path);
+        }
+        written += static_cast<size_t>(result);
+    }
+    if (::fsync(fd) != 0) {
+        throw std::runtime_error("Failed to sync chunk journal: " + path);
+    }
+}
+
+void ChunkJournal::reset() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (std::filesystem::exists(path)) {
+        std::filesystem::resize_file(path, 0);
+    }
+}
+
+} // namespace vkengine
@@ -2,6 +2,9 @@
 #include "../include/config.hpp"
 #include "../include/scope_timer.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <thread>
 
 using ScopeTimer = GlobalTimerData::ScopeTimer;
@@ -20,6 +23,21 @@ static int numNeighbors = sizeof(neighborOffsets) / sizeof(neighborOffsets[0]);
 namespace vkengine {
 
 ChunkManager::ChunkManager(Device& deviceRef) : device{deviceRef} {
+    meshCache.setCapacity(static_cast<size_t>(config().getInt("mesh_cache_megabytes", 256)) * 1024 * 1024);
+    if (config().getInt("coarse_terrain", 1) == 0) {
+        flags &= ~ChunkManagerFlags::COARSE_TERRAIN;
+    }
+
+    // Finish whatever the last session journaled but did not get into the region files
+    try {
+        size_t replayed = journal.replay(regionStore);
+        if (replayed > 0) {
+            std::cerr << "Recovered " << replayed << " chunks from the save journal" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to replay save journal: " << e.what() << std::endl;
+    }
+
     for (int i = 0; i < numTerrainThreads; ++i) {
         threads.emplace_back(&ChunkManager::chunksTerrainGenerationThread, this);
     }
@@ -31,30 +49,53 @@ ChunkManager::ChunkManager(Device& deviceRef) : device{deviceRef} {
     for (int i = 0; i < numCreationThreads; ++i) {
         threads.emplace_back(&ChunkManager::chunksCreationThread, this);
     }
+
+    for (int i = 0; i < numLoadThreads; ++i) {
+        threads.emplace_back(&ChunkManager::chunksLoadThread, this);
+    }
+
+    threads.emplace_back(&ChunkManager::autosaveThread, this);
 }
 
 ChunkManager::~ChunkManager() {
     waitForThreads();
+
+    // Edits made since the last autosave
+    try {
+        saveDirtyChunks(false);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save world on exit: " << e.what() << std::endl;
+    }
 }
 
 std::shared_ptr<Chunk> ChunkManager::queueChunkCreation(const ChunkCoord& coord) {  
-    std::shared_lock<std::shared_mutex> lock(chunksMutex);
-    auto it = m_chunks.find(coord);
-    lock.unlock();
-    
-    if (it == m_chunks.end()) {
-        if(flags & ChunkManagerFlags::GENERATE_CHUNKS) {
-            std::lock_guard<std::mutex> lock(creationMutex);
+    {
+        std::shared_lock<std::shared_mutex> lock(chunksMutex);
+        auto it = m_chunks.find(coord);
+        if (it != m_chunks.end()) {
+            return it->second;
+        }
+        if (m_emptyChunks.count(coord)) {
+            return nullptr;
+        }
+    }
+
+    if(flags & ChunkManagerFlags::GENERATE_CHUNKS) {
+        std::lock_guard<std::mutex> lock(creationMutex);
+        // Only queue each coordinate once until a creation thread handles it
+        if (chunksQueuedForCreation.insert(coord).second) {
             chunksNeedingCreating.push(coord);
             creationSemaphore.release();
         }
-        return nullptr;
-    } else {
-        return it->second;
     }
+    return nullptr;
 }
 bool ChunkManager::queueChunkTerrainGeneration(std::shared_ptr<Chunk> chunk) {
     ScopeTimer timer("ChunkManager::generateTerrain");
+    // Saved chunks are still waiting on the load threads
+    if(chunk->storedOnDisk()) {
+        return false;
+    }
     if(!chunk->defaultTerrainGenerated()) {
         {
             std::lock_guard<std::mutex> lock(terrainMutex);
@@ -86,6 +127,14 @@ bool ChunkManager::updateGameObject(std::shared_ptr<Chunk> chunk) {
         ScopeTimer timer("ChunkManager::updateGameObject");
         if(!chunk->upToDate()) {
             chunk->updateGameObject();
+            meshGeneration++;
+
+            // Chunks meshed at the same time as an identical one each uploaded a copy; keep one
+            auto& model = chunk->getGameObject()->model;
+            if (chunk->getMeshKey() != 0 && model) {
+                // The key hashes everything the mesh depends on; the mesh cache trusts it the same way
+                model = modelPool.intern(chunk->getMeshKey(), model, [](const Model&) { return true; });
+            }
         }
     }
     return true;
@@ -100,6 +149,7 @@ bool ChunkManager::updateActiveChunks(GameObject::Map& gameObjects, std::shared_
         newChunks.push(chunk);
         if (gameObjects.find(objectId) == gameObjects.end()) {
             gameObjects.emplace(objectId, chunk->getGameObject());
+            meshGeneration++;
         }
     }
     return true;
@@ -132,9 +182,15 @@ void ChunkManager::loopOverChunksThread(const glm::vec3& playerPos, int viewDist
 }
 
 void ChunkManager::update(const glm::vec3& playerPos, int viewDistance, GameObject::Map& gameObjects) {
+    if (loadFlushed.exchange(false)) {
+        finishLoad(gameObjects);
+    }
+
     ChunkCoord centerChunk = worldToChunkCoord(playerPos);
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
     
     int verticalViewRange = viewDistance / 2 + 1;  // Adjust as needed
+    int lodDistance = config().getInt("lod_distance", 4);
     
     for (int x = centerChunk.x - viewDistance; x <= centerChunk.x + viewDistance; x++) {
         for (int y = centerChunk.y - verticalViewRange; y <= centerChunk.y + verticalViewRange; y++) {
@@ -144,6 +200,18 @@ void ChunkManager::update(const glm::vec3& playerPos, int viewDistance, GameObje
                 if (isChunkInRange(coord, centerChunk, viewDistance)) {
                     std::shared_ptr<Chunk> chunk = queueChunkCreation(coord);
                     if(chunk == nullptr) { continue; }
+                    chunk->touch(now);
+
+                    // Faces toward a neighbour at another level are meshed as if it were air,
+                    // so the step between the two resolutions is closed by a wall instead of a crack
+                    ChunkLod lod{lodLevel(coord, centerChunk, lodDistance), 0};
+                    for (int i = 0; i < numNeighbors; i++) {
+                        ChunkCoord neighbor{x + neighborOffsets[i][0], y + neighborOffsets[i][1], z + neighborOffsets[i][2]};
+                        if (lodLevel(neighbor, centerChunk, lodDistance) != lod.level) {
+                            lod.seams |= 1 << i;
+                        }
+                    }
+                    chunk->setLod(lod);
 
                     if(!queueChunkTerrainGeneration(chunk)) { continue; }
                     if(!queueChunkMeshGeneration(chunk)) { continue; }
@@ -154,6 +222,19 @@ void ChunkManager::update(const glm::vec3& playerPos, int viewDistance, GameObje
         }
     }
 
+    flushDecorations(centerChunk, viewDistance);
+    compressColdChunks(centerChunk, viewDistance);
+
+    if (flags & ChunkManagerFlags::COARSE_TERRAIN) {
+        int coarseDistance = std::max(viewDistance, config().getInt("coarse_distance"));
+        coarseTerrain.update(centerChunk, coarseDistance, gameObjects);
+    } else if (coarseTerrain.getTileCount() > 0) {
+        coarseTerrain.clear(gameObjects);
+    }
+
+    // Columns are shared by every vertical chunk; keep a small margin so turning around does not rebuild them
+    terrainGenerator.evictColumns(centerChunk, viewDistance + 2);
+
     ScopeTimer timer("ChunkManager::updateActiveChunks");
 
     newChunksMutex.lock();
@@ -166,6 +247,7 @@ void ChunkManager::update(const glm::vec3& playerPos, int viewDistance, GameObje
             GameObject::id_t objectId = chunk->getGameObject()->getId();
             m_activeChunks[coord] = objectId;
             gameObjects[objectId] = chunk->getGameObject();
+            meshGeneration++;
         }
     }
     newChunksMutex.unlock();
@@ -183,6 +265,247 @@ void ChunkManager::update(const glm::vec3& playerPos, int viewDistance, GameObje
         GameObject::id_t objectId = m_activeChunks[coord];
         m_activeChunks.erase(coord);
         gameObjects.erase(objectId);
+        meshGeneration++;
+    }
+
+    // New meshes and connectivity since the last visibility search
+    visibilityDirty = true;
+
+    if (flags & ChunkManagerFlags::COARSE_TERRAIN) {
+        std::shared_lock<std::shared_mutex> lock(chunksMutex);
+        coarseTerrain.updateCoverage([&](const ChunkCoord& coord) {
+            return m_activeChunks.count(coord) > 0 || m_emptyChunks.count(coord) > 0;
+        });
+    }
+}
+
+void ChunkManager::updateVisibleChunks(const glm::vec3& cameraPos, const glm::vec3& viewDirection, int viewDistance, const GameObject::Map& gameObjects) {
+    ScopeTimer timer("ChunkManager::updateVisibleChunks");
+
+    // Meshes only change in update(); otherwise redo the search when the camera
+    // changes chunk or turns by more than a few degrees
+    bool culling = flags & ChunkManagerFlags::CAVE_CULLING;
+    ChunkCoord centerChunk = worldToChunkCoord(cameraPos);
+    if (!visibilityDirty && culling == visibilityCulling && centerChunk == visibilityCenter &&
+        glm::dot(viewDirection, visibilityDirection) > 0.995f) {
+        return;
+    }
+    visibilityDirty = false;
+    visibilityCulling = culling;
+    visibilityCenter = centerChunk;
+    visibilityDirection = viewDirection;
+
+    struct Step {
+        ChunkCoord coord;
+        int entryFace;      // face of `coord` the search came in through, -1 at the camera
+        int travelled;      // directions taken so far, as bits of neighborOffsets indices
+    };
+    std::unordered_set<ChunkCoord, ChunkCoord::Hash> reached{centerChunk};
+    std::queue<Step> frontier;
+    frontier.push({centerChunk, -1, 0});
+
+    // Half the diagonal of a chunk: a chunk whose centre is further behind the camera cannot be seen
+    const float chunkRadius = CHUNK_SIZE * 0.8660254f;
+
+    if (culling) {
+        std::shared_lock<std::shared_mutex> lock(chunksMutex);
+        while (!frontier.empty()) {
+            Step step = frontier.front();
+            frontier.pop();
+
+            // Sky chunks and chunks still loading are open in every direction
+            uint16_t visibility = ALL_FACES_CONNECTED;
+            auto it = m_chunks.find(step.coord);
+            if (it != m_chunks.end() && it->second) {
+                visibility = it->second->getVisibility();
+            }
+
+            for (int face = 0; face < numNeighbors; face++) {
+                // Opposite faces are adjacent indices: X+/X-, Y+/Y-, Z+/Z-
+                int opposite = face ^ 1;
+                if (step.travelled & (1 << opposite)) continue;
+                if (step.entryFace >= 0 && !facesConnected(visibility, step.entryFace, face)) continue;
+
+                ChunkCoord next{step.coord.x + neighborOffsets[face][0], step.coord.y + neighborOffsets[face][1], step.coord.z + neighborOffsets[face][2]};
+                if (!isChunkInRange(next, centerChunk, viewDistance) || reached.count(next)) continue;
+
+                glm::vec3 chunkCenter = (glm::vec3(next.x, next.y, next.z) + 0.5f) * static_cast<float>(CHUNK_SIZE);
+                if (glm::dot(chunkCenter - cameraPos, viewDirection) < -chunkRadius) continue;
+
+                reached.insert(next);
+                frontier.push({next, opposite, step.travelled | (1 << face)});
+            }
+        }
+    }
+
+    culledObjects.clear();
+    drawableChunkCount = 0;
+    for (const auto& [coord, objectId] : m_activeChunks) {
+        auto object = gameObjects.find(objectId);
+        if (object == gameObjects.end() || !object->second->model) continue;
+        drawableChunkCount++;
+        if (culling && !reached.count(coord)) {
+            culledObjects.insert(objectId);
+        }
+    }
+    visibleChunkCount = drawableChunkCount - culledObjects.size();
+}
+
+void ChunkManager::updateOcclusion(const glm::vec3& cameraPos, const glm::mat4& viewProjection, const GameObject::Map& gameObjects) {
+    ScopeTimer timer("ChunkManager::updateOcclusion");
+    occludedObjects.clear();
+    occludedChunkCount = 0;
+    outsideChunkCount = 0;
+    if (!(flags & ChunkManagerFlags::OCCLUSION_CULLING)) {
+        occlusionMilliseconds = 0.0f;
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    struct Drawn {
+        ChunkCoord coord;
+        GameObject::id_t objectId;
+        std::shared_ptr<Chunk> chunk;
+    };
+    std::vector<Drawn> drawn;
+    {
+        std::shared_lock<std::shared_mutex> lock(chunksMutex);
+        for (const auto& [coord, objectId] : m_activeChunks) {
+            if (culledObjects.count(objectId)) continue;
+            auto object = gameObjects.find(objectId);
+            if (object == gameObjects.end() || !object->second->model) continue;
+            auto it = m_chunks.find(coord);
+            if (it == m_chunks.end() || !it->second) continue;
+            drawn.push_back({coord, objectId, it->second});
+        }
+    }
+
+    ChunkCoord centerChunk = worldToChunkCoord(cameraPos);
+    int occluderDistance = config().getInt("occluder_distance", 3);
+    occlusionCuller.beginFrame(viewProjection);
+    for (const Drawn& entry : drawn) {
+        const auto& occluders = entry.chunk->getOccluders();
+        if (occluders && isChunkInRange(entry.coord, centerChunk, occluderDistance)) {
+            occlusionCuller.addOccluders(glm::vec3(entry.coord.x, entry.coord.y, entry.coord.z) * static_cast<float>(CHUNK_SIZE), *occluders);
+        }
+    }
+
+    for (const Drawn& entry : drawn) {
+        glm::vec3 boxMin = glm::vec3(entry.coord.x, entry.coord.y, entry.coord.z) * static_cast<float>(CHUNK_SIZE);
+        switch (occlusionCuller.test(boxMin, boxMin + static_cast<float>(CHUNK_SIZE))) {
+            case OcclusionCuller::Result::OCCLUDED:
+                occludedChunkCount++;
+                occludedObjects.insert(entry.objectId);
+                break;
+            case OcclusionCuller::Result::OUTSIDE:
+                outsideChunkCount++;
+                occludedObjects.insert(entry.objectId);
+                break;
+            case OcclusionCuller::Result::VISIBLE:
+                break;
+        }
+    }
+    occlusionMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ChunkManager::uploadCoarseTerrain(GameObject::Map& gameObjects) {
+    if (flags & ChunkManagerFlags::COARSE_TERRAIN) {
+        coarseTerrain.uploadReadyTiles(gameObjects);
+    }
+}
+
+void ChunkManager::compressColdChunks(const ChunkCoord& centerChunk, int viewDistance) {
+    ScopeTimer timer("ChunkManager::compressColdChunks");
+
+    // Bound the main-thread cost however many chunks are loaded
+    constexpr size_t maxChecksPerUpdate = 256;
+    constexpr int maxCompressionsPerUpdate = 128;
+
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    int64_t coldAfter = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>(config().getFloat("cold_after_seconds", 10.0f))).count();
+    int coldDistance = std::max(viewDistance + 1, config().getInt("cold_distance", 12));
+
+    std::shared_lock<std::shared_mutex> lock(chunksMutex);
+
+    // Only the chunks the range just moved off can have left it
+    if (!(centerChunk == coldCenter) || viewDistance != coldViewDistance) {
+        int r = coldViewDistance;
+        for (int x = coldCenter.x - r; x <= coldCenter.x + r; x++) {
+            for (int y = coldCenter.y - r; y <= coldCenter.y + r; y++) {
+                for (int z = coldCenter.z - r; z <= coldCenter.z + r; z++) {
+                    ChunkCoord coord{x, y, z};
+                    if (isChunkInRange(coord, coldCenter, r) && !isChunkInRange(coord, centerChunk, viewDistance) &&
+                        m_chunks.count(coord) && queuedColdCandidates.insert(coord).second) {
+                        coldCandidates.push_back(coord);
+                    }
+                }
+            }
+        }
+        coldCenter = centerChunk;
+        coldViewDistance = viewDistance;
+    }
+
+    size_t checks = std::min(coldCandidates.size(), maxChecksPerUpdate);
+    int compressions = 0;
+    for (size_t i = 0; i < checks && compressions < maxCompressionsPerUpdate; i++) {
+        ChunkCoord coord = coldCandidates.front();
+        coldCandidates.pop_front();
+
+        // Back in range: queued again when it leaves
+        auto it = m_chunks.find(coord);
+        if (it == m_chunks.end() || isChunkInRange(coord, centerChunk, viewDistance)) {
+            queuedColdCandidates.erase(coord);
+            continue;
+        }
+        coldCandidates.push_back(coord);
+
+        const auto& chunk = it->second;
+        if (chunk->isCold()) continue;
+        if (now - chunk->lastUsed() <= coldAfter && isChunkInRange(coord, centerChunk, coldDistance)) continue;
+
+        // Never wait on a worker; a busy chunk is retried on a later pass
+        std::unique_lock<std::mutex> chunkLock(chunk->m_mutex, std::try_to_lock);
+        if (chunkLock.owns_lock() && chunk->compress()) {
+            ++compressions;
+        }
+    }
+}
+
+void ChunkManager::flushDecorations(const ChunkCoord& centerChunk, int viewDistance) {
+    ScopeTimer timer("ChunkManager::flushDecorations");
+
+    // Writes for chunks that are not generated yet stay queued; the terrain
+    // thread picks them up. Everything else is applied in one batch per chunk,
+    // so a chunk is remeshed at most once per flush however many trees touch it.
+    for (const ChunkCoord& target : decorationBuffer.pendingTargets()) {
+        std::shared_ptr<Chunk> chunk;
+        bool discard = false;
+        {
+            std::shared_lock<std::shared_mutex> lock(chunksMutex);
+            auto it = m_chunks.find(target);
+            if (it != m_chunks.end()) {
+                chunk = it->second;
+            } else {
+                // Empty chunks never get a Chunk, and isChunkEmpty already leaves room for
+                // overhanging trees, so nothing would take these. Beyond the margin the target
+                // is not created either; a diagonal neighbour of an in-range chunk lies within
+                // sqrt(3) of the view distance, hence the 2.
+                discard = m_emptyChunks.count(target) > 0 || !isChunkInRange(target, centerChunk, viewDistance + 2);
+            }
+        }
+        if (discard) {
+            decorationBuffer.take(target);
+            continue;
+        }
+        if (!chunk) continue;
+
+        // Never wait on a worker; the writes stay queued and a busy chunk is retried next update
+        std::unique_lock<std::mutex> chunkLock(chunk->m_mutex, std::try_to_lock);
+        if (!chunkLock.owns_lock()) continue;
+        if (!chunk->defaultTerrainGenerated()) continue;
+        // Taken either way; a chunk loaded from disk drops them
+        chunk->applyDecorations(decorationBuffer.take(target));
     }
 }
 
@@ -206,6 +529,21 @@ bool ChunkManager::isChunkInRange(const ChunkCoord& chunkCoord, const ChunkCoord
     return squaredDistance <= viewDistance * viewDistance;
 }
 
+int ChunkManager::lodLevel(const ChunkCoord& chunkCoord, const ChunkCoord& centerChunk, int lodDistance) {
+    if (lodDistance <= 0) return 0;
+
+    int dx = chunkCoord.x - centerChunk.x;
+    int dy = chunkCoord.y - centerChunk.y;
+    int dz = chunkCoord.z - centerChunk.z;
+    int squaredDistance = dx * dx + dy * dy + dz * dz;
+
+    int level = 0;
+    for (int bound = lodDistance; level < MAX_LOD_LEVEL && squaredDistance >= bound * bound; bound *= 2) {
+        level++;
+    }
+    return level;
+}
+
 std::shared_ptr<Chunk> ChunkManager::createChunk(const ChunkCoord& coord) {
     // Create game object for chunk
     auto gameObject = GameObject::createGameObject();
@@ -218,7 +556,7 @@ std::shared_ptr<Chunk> ChunkManager::createChunk(const ChunkCoord& coord) {
     };
     
     // Create chunk
-    auto chunk = std::make_shared<Chunk>(device, gameObject);
+    auto chunk = std::make_shared<Chunk>(device, gameObject, &worldSnapshots, &dirtyChunks);
        
     return chunk;
 }
@@ -228,12 +566,17 @@ void ChunkManager::stopAllThreads() {
 }
 
 void ChunkManager::waitForThreads() {
-    stopThreads = true;
+    {
+        std::lock_guard<std::mutex> lock(autosaveMutex);
+        stopThreads = true;
+    }
+    autosaveCondition.notify_all();
     
     // Notify all semaphores to wake up threads
     terrainSemaphore.release(numTerrainThreads);
     meshSemaphore.release(numMeshThreads);
     creationSemaphore.release(numCreationThreads);
+    loadSemaphore.release(numLoadThreads);
     
     // Join all threads
     for (auto& thread : threads) {
@@ -261,8 +604,8 @@ void ChunkManager::chunksTerrainGenerationThread() {
         // Check if the chunk is still valid before using it
         if (chunk) {
             std::lock_guard<std::mutex> lock(chunk->m_mutex);
-            if(!chunk->defaultTerrainGenerated()) {
-                chunk->generateTerrain();
+            if(!chunk->defaultTerrainGenerated() && !chunk->storedOnDisk()) {
+                chunk->generateTerrain(terrainGenerator, decorationBuffer);
             }
         }
         
@@ -282,13 +625,74 @@ void ChunkManager::chunksCreationThread() {
             chunksNeedingCreating.pop();
         }
 
-        std::shared_ptr<Chunk> chunk;
+        // Sky chunks never get a Chunk or GameObject; meshing treats them as air neighbours
+        if (terrainGenerator.isChunkEmpty(chunkToGenerate)) {
+            std::unique_lock<std::shared_mutex> lock(chunksMutex);
+            m_emptyChunks.insert(chunkToGenerate);
+        } else {
+            std::shared_ptr<Chunk> chunk = createChunk(chunkToGenerate);
+
+            // Only the region's mapped table entry is read here; decoding happens on the load threads
+            bool stored = false;
+            try {
+                stored = regionStore.hasChunk(chunkToGenerate);
+            } catch (const std::exception& e) {
+                std::cerr << "Ignoring unreadable region: " << e.what() << std::endl;
+            }
+            if (stored) {
+                chunk->setStoredOnDisk(true);
+                std::lock_guard<std::mutex> lock(loadMutex);
+                chunksNeedingLoad.push(chunk);
+                loadSemaphore.release();
+            }
 
-        chunk = createChunk(chunkToGenerate);
-        {
             std::unique_lock<std::shared_mutex> lock(chunksMutex);
             m_chunks[chunkToGenerate] = chunk;
         }
+
+        std::lock_guard<std::mutex> lock(creationMutex);
+        chunksQueuedForCreation.erase(chunkToGenerate);
+    }
+}
+
+void ChunkManager::chunksLoadThread() {
+    while (!stopThreads) {
+        loadSemaphore.acquire();
+        if (stopThreads) break;
+
+        std::shared_ptr<Chunk> chunk;
+        {
+            std::lock_guard<std::mutex> lock(loadMutex);
+            if (chunksNeedingLoad.empty()) continue;
+            chunk = chunksNeedingLoad.front();
+            chunksNeedingLoad.pop();
+        }
+
+        bool loaded = false;
+        {
+            std::lock_guard<std::mutex> lock(chunk->m_mutex);
+            try {
+                // Decoded straight out of the mapping
+                loaded = regionStore.visitChunk(chunk->getChunkCoord(), [&](std::string_view data) {
+                    chunk->loadTerrain(data);
+                });
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to load chunk, regenerating: " << e.what() << std::endl;
+            }
+            if (loaded) {
+                // Writes queued by neighbours before the load; the saved blocks already have them
+                decorationBuffer.take(chunk->getChunkCoord());
+            } else {
+                chunk->setStoredOnDisk(false);
+            }
+        }
+
+        // Missing or unreadable chunks fall back to generation
+        if (!loaded) {
+            std::lock_guard<std::mutex> lock(terrainMutex);
+            chunksNeedingTerrainGeneration.push(chunk);
+            terrainSemaphore.release();
+        }
     }
 }
 
@@ -328,7 +732,8 @@ void ChunkManager::chunksMeshUpdateThread() {
                                 } else {
                                     anyNeighborMissing = true;
                                 }
-                            } else {
+                            } else if (!m_emptyChunks.count(neighborCoord)) {
+                                // Known-empty neighbours stay null, which meshes as air
                                 anyNeighborMissing = true;
                             }
                         }
@@ -344,20 +749,101 @@ void ChunkManager::chunksMeshUpdateThread() {
                 }
             }
             
+            // Border faces read the neighbours' packed storage, which a decoration flush may
+            // repack. Lock them as well, in address order; every other path holds a single
+            // chunk lock, so this cannot deadlock.
+            auto lockWithNeighbors = [&chunk]() {
+                std::vector<Chunk*> lockOrder{chunk.get()};
+                for (const auto& neighbor : chunk->m_neighbors) {
+                    if (neighbor) lockOrder.push_back(neighbor.get());
+                }
+                std::sort(lockOrder.begin(), lockOrder.end());
+                std::vector<std::unique_lock<std::mutex>> locks;
+                for (Chunk* locked : lockOrder) {
+                    locks.emplace_back(locked->m_mutex);
+                }
+                return locks;
+            };
+
+            MeshingTechnique technique = static_cast<MeshingTechnique>(config().getInt("meshing_technique"));
+            bool useCache = flags & ChunkManagerFlags::MESH_CACHE;
+            bool share = modelPool.isEnabled();
+            // Coarse levels and seams only exist in the greedy mesher
+            auto generate = [&](ChunkLod lod, uint64_t key) {
+                if(technique == MeshingTechnique::SIMPLE && lod == ChunkLod{}) {
+                    chunk->generateMesh();
+                } else {
+                    chunk->generateGreedyMesh(lod);
+                }
+                // Published for chunks that will share this mesh's model
+                if (share && chunk->getMeshOccluders()) {
+                    occluderPool.intern(key, chunk->getMeshOccluders(), [](const std::vector<OccluderQuad>&) { return true; });
+                }
+            };
+
+            ChunkLod lod;
+            uint64_t key = 0;
             {
+                auto locks = lockWithNeighbors();
+                if (chunk->meshGenerated()) continue;
+
+                // Blocks changed or were first loaded; cached and shared meshes need it too
+                chunk->updateVisibility();
+
+                // Same blocks and neighbour borders as a loaded or cached chunk: reuse its mesh
+                lod = chunk->getLod();
+                key = useCache || share ? chunk->meshKey(technique, lod) : 0;
+                chunk->setMeshKey(key);
+                if (share) {
+                    if (auto model = modelPool.find(key)) {
+                        chunk->setSharedMesh(std::move(model), lod, occluderPool.find(key));
+                        continue;
+                    }
+                }
+                if (!useCache) {
+                    generate(lod, key);
+                    continue;
+                }
+            }
+
+            // The cache reads and writes files, so no chunk lock is held around it.
+            // A block write meanwhile resets the chunk's mesh key, and the chunk is
+            // then meshed again from its new blocks instead.
+            std::vector<Model::Vertex> vertices;
+            std::vector<uint32_t> indices;
+            if (meshCache.load(key, vertices, indices)) {
                 std::lock_guard<std::mutex> lock(chunk->m_mutex);
-                if(!chunk->meshGenerated()) {
-                    if(static_cast<MeshingTechnique>(config().getInt("meshing_technique")) == MeshingTechnique::SIMPLE) {
-                        chunk->generateMesh();
-                    } else if(static_cast<MeshingTechnique>(config().getInt("meshing_technique")) == MeshingTechnique::GREEDY) {
-                        chunk->generateGreedyMesh(); // Assuming generateGreedyMesh() is a valid method
+                if (!chunk->meshGenerated() && chunk->getMeshKey() == key && chunk->getLod() == lod) {
+                    chunk->setMesh(std::move(vertices), std::move(indices), lod);
+                    if (share && chunk->getMeshOccluders()) {
+                        occluderPool.intern(key, chunk->getMeshOccluders(), [](const std::vector<OccluderQuad>&) { return true; });
                     }
                 }
+                continue;
             }
+
+            {
+                auto locks = lockWithNeighbors();
+                if (chunk->meshGenerated() || chunk->getMeshKey() != key || chunk->getLod() != lod) continue;
+                generate(lod, key);
+                vertices = chunk->getVertices();
+                indices = chunk->getIndices();
+            }
+            meshCache.store(key, vertices, indices);
         }
     }
 }
 
+size_t ChunkManager::getChunkCount() {
+    std::shared_lock<std::shared_mutex> lock(chunksMutex);
+    return m_chunks.size();
+}
+
+size_t ChunkManager::getEmptyChunkCount() {
+    std::shared_lock<std::shared_mutex> lock(chunksMutex);
+    return m_emptyChunks.size();
+}
+
 void ChunkManager::regenerateEntireMesh() {
     for (auto& chunkPair : m_chunks) {
         auto& chunk = chunkPair.second;
@@ -367,27 +853,153 @@ void ChunkManager::regenerateEntireMesh() {
     }
 }
 
-std::string ChunkManager::serialize() const {
-    std::string data;
-    for (const auto& chunkPair : m_chunks) {
-        data += chunkPair.second->serialize() + "\n";
+void ChunkManager::requestSave() {
+    {
+        std::lock_guard<std::mutex> lock(autosaveMutex);
+        saveRequested = true;
     }
-    return data;
+    autosaveCondition.notify_all();
 }
 
-void ChunkManager::deserialize(const std::string& data) {
-    // Clear existing chunks
-    m_chunks.clear();
-    m_activeChunks.clear();
-    std::istringstream iss(data);
-    std::string line;
-    
-    while (std::getline(iss, line)) {
-        if (!line.empty()) {
-            auto chunk = std::make_shared<Chunk>(device, GameObject::createGameObject());
-            chunk->deserialize(line);
-            m_chunks[chunk->getChunkCoord()] = chunk;
+void ChunkManager::autosaveThread() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(autosaveMutex);
+            auto interval = std::chrono::duration<float>(config().getFloat("autosave_interval", 5.0f));
+            autosaveCondition.wait_for(lock, interval, [this] { return stopThreads || saveRequested; });
+            if (stopThreads) break;
+            saveRequested = false;
+        }
+
+        // The destructor retries anything left dirty here
+        bool load = loadPending;
+        try {
+            saveDirtyChunks(!load);
+        } catch (const std::exception& e) {
+            std::cerr << "Autosave failed: " << e.what() << std::endl;
+            // Dropping the chunks now would lose the edits; a pending load waits for the next save
+            continue;
+        }
+        if (load) {
+            loadFlushed = true;
+        }
+    }
+}
+
+size_t ChunkManager::saveDirtyChunks(bool throttle) {
+    std::lock_guard<std::mutex> saveLock(saveMutex);
+    auto start = std::chrono::steady_clock::now();
+
+    // Constant time: from here on, a chunk's first write sets its old blocks
+    // aside for this save, so nothing waits for the saver
+    uint64_t epoch = worldSnapshots.begin();
+
+    // Only chunks edited since the last save, so the cost follows the edits and
+    // not the size of the world. Taken after the snapshot began: every chunk
+    // dirtied before it is in the set.
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    {
+        std::vector<ChunkCoord> coords = dirtyChunks.take();
+        std::shared_lock<std::shared_mutex> lock(chunksMutex);
+        chunks.reserve(coords.size());
+        for (const ChunkCoord& coord : coords) {
+            auto it = m_chunks.find(coord);
+            if (it != m_chunks.end()) {
+                chunks.push_back(it->second);
+            }
         }
     }
+
+    // Each chunk's lock is held only to pick up its snapshot storage; serializing happens outside it
+    std::vector<std::shared_ptr<Chunk>> saved;
+    std::vector<std::pair<ChunkCoord, std::string>> batch;
+    for (auto& chunk : chunks) {
+        ChunkSnapshot snapshot;
+        {
+            std::lock_guard<std::mutex> lock(chunk->m_mutex);
+            bool existed = chunk->readSnapshot(epoch, snapshot);
+            if (existed) {
+                chunk->releaseSnapshot(epoch);
+                // Edited after the snapshot: stays dirty for the next save
+                if ((snapshot.flags & ChunkFlags::DIRTY) && snapshot.current) {
+                    chunk->setDirty(false);
+                }
+            }
+            // Dirty chunks this save does not clean go back into the set
+            if (chunk->dirty()) {
+                dirtyChunks.add(chunk->getChunkCoord());
+            }
+            if (!existed || !(snapshot.flags & ChunkFlags::DIRTY)) continue;
+        }
+        batch.emplace_back(chunk->getChunkCoord(), Chunk::serialize(*snapshot.blocks));
+        saved.push_back(chunk);
+    }
+    worldSnapshots.end();
+
+    if (batch.empty()) {
+        return 0;
+    }
+
+    size_t bytes = 0;
+    try {
+        // Journal first, so a crash during the region writes below is recovered on the next start
+        journal.append(batch);
+
+        int bytesPerSecond = std::max(1, config().getInt("autosave_bytes_per_second", 4 * 1024 * 1024));
+        auto writeStart = std::chrono::steady_clock::now();
+        for (const auto& [coord, payload] : batch) {
+            regionStore.saveChunk(coord, payload);
+            bytes += payload.size();
+
+            // Stay within the write budget; shutdown saves, and a save a world load waits on, run flat out
+            if (throttle && !stopThreads && !loadPending) {
+                auto due = writeStart + std::chrono::duration<double>(static_cast<double>(bytes) / bytesPerSecond);
+                std::this_thread::sleep_until(std::chrono::time_point_cast<std::chrono::steady_clock::duration>(due));
+            }
+        }
+
+        regionStore.sync();
+        journal.reset();
+    } catch (...) {
+        for (auto& chunk : saved) {
+            std::lock_guard<std::mutex> lock(chunk->m_mutex);
+            chunk->setDirty(true);
+        }
+        throw;
+    }
+
+    lastSaveChunks = batch.size();
+    lastSaveBytes = bytes;
+    lastSaveMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return batch.size();
+}
+
+void ChunkManager::loadWorld() {
+    // Unsaved edits would otherwise be dropped with the chunks. The autosave
+    // thread writes them; a save it is already running stops throttling.
+    loadPending = true;
+    requestSave();
+}
+
+void ChunkManager::finishLoad(GameObject::Map& gameObjects) {
+    // Edited again since the flush: flush once more before dropping anything
+    if (!dirtyChunks.empty()) {
+        requestSave();
+        return;
+    }
+
+    for (const auto& [coord, objectId] : m_activeChunks) {
+        gameObjects.erase(objectId);
+    }
+    meshGeneration++;
+
+    std::unique_lock<std::shared_mutex> lock(chunksMutex);
+    m_chunks.clear();
+    m_activeChunks.clear();
+    m_emptyChunks.clear();
+    dirtyChunks.clear();
+    coldCandidates.clear();
+    queuedColdCandidates.clear();
+    loadPending = false;
+}
 }
-}
\ No newline at end of file
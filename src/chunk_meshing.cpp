@@ -1,6 +1,7 @@
 #include "chunk.hpp"
 #include "game_object.hpp"
-#include "perlin_noise.hpp"
+
+#include <algorithm>
 
 namespace vkengine {
 
@@ -8,6 +9,9 @@ namespace vkengine {
 void Chunk::generateMesh() {
     m_vertices.clear();
     m_indices.clear();
+    m_sharedModel.reset();
+    m_occluders.reset();
+    m_meshLod = 0;
 
     glm::vec3 chunkPos = m_gameObject->transform.translation;
     int chunkX = static_cast<int>(chunkPos.x / CHUNK_SIZE);
@@ -21,17 +25,22 @@ void Chunk::generateMesh() {
     std::shared_ptr<Chunk> neighborZPos = m_neighbors[4];
     std::shared_ptr<Chunk> neighborZNeg = m_neighbors[5];
 
+    // One bulk unpack instead of a palette lookup per neighbour test
+    std::array<Block, CHUNK_VOLUME> blocks;
+    storage().unpack(blocks);
+    auto blockAt = [&](int bx, int by, int bz) { return blocks[chunkBlockIndex(bx, by, bz)]; };
+
     for (int x = 0; x < CHUNK_SIZE; x++) {
         for (int y = 0; y < CHUNK_SIZE; y++) {
             for (int z = 0; z < CHUNK_SIZE; z++) {
-                Block block = getBlock(x, y, z);
+                Block block = blockAt(x, y, z);
                 
                 if (block.type == BlockType::AIR) {
                     continue;
                 }
                 
                 if (y < CHUNK_SIZE - 1) {
-                    if (getBlock(x, y + 1, z).type == BlockType::AIR) {
+                    if (blockAt(x, y + 1, z).type == BlockType::AIR) {
                         addBlockFace(x, y, z, block.type, Direction::TOP);
                     }
                 } else if (neighborYPos) {
@@ -43,7 +52,7 @@ void Chunk::generateMesh() {
                 }
                 
                 if (y > 0) {
-                    if (getBlock(x, y - 1, z).type == BlockType::AIR) {
+                    if (blockAt(x, y - 1, z).type == BlockType::AIR) {
                         addBlockFace(x, y, z, block.type, Direction::BOTTOM);
                     }
                 } else if (neighborYNeg) {
@@ -55,7 +64,7 @@ void Chunk::generateMesh() {
                 }
                 
                 if (z > 0) {
-                    if (getBlock(x, y, z - 1).type == BlockType::AIR) {
+                    if (blockAt(x, y, z - 1).type == BlockType::AIR) {
                         addBlockFace(x, y, z, block.type, Direction::FRONT);
                     }
                 } else if (neighborZNeg) {
@@ -67,7 +76,7 @@ void Chunk::generateMesh() {
                 }
                 
                 if (z < CHUNK_SIZE - 1) {
-                    if (getBlock(x, y, z + 1).type == BlockType::AIR) {
+                    if (blockAt(x, y, z + 1).type == BlockType::AIR) {
                         addBlockFace(x, y, z, block.type, Direction::BACK);
                     }
                 } else if (neighborZPos) {
@@ -79,7 +88,7 @@ void Chunk::generateMesh() {
                 }
 
                 if (x > 0) {
-                    if (getBlock(x - 1, y, z).type == BlockType::AIR) {
+                    if (blockAt(x - 1, y, z).type == BlockType::AIR) {
                         addBlockFace(x, y, z, block.type, Direction::LEFT);
                     }
                 } else if (neighborXNeg) {
@@ -91,7 +100,7 @@ void Chunk::generateMesh() {
                 }
                 
                 if (x < CHUNK_SIZE - 1) {
-                    if (getBlock(x + 1, y, z).type == BlockType::AIR) {
+                    if (blockAt(x + 1, y, z).type == BlockType::AIR) {
                         addBlockFace(x, y, z, block.type, Direction::RIGHT);
                     }
                 } else if (neighborXPos) {
@@ -104,48 +113,126 @@ void Chunk::generateMesh() {
             }
         }
     }
+    bucketFaces();
+    countMemory();
 
     flags |= ChunkFlags::MESH_GENERATED;
     flags &= ~ChunkFlags::UP_TO_DATE;
 }
 
-void Chunk::generateGreedyMesh() {
+void Chunk::generateGreedyMesh(ChunkLod lod) {
     m_vertices.clear();
     m_indices.clear();
+    m_sharedModel.reset();
 
     m_vertices.reserve(CHUNK_SIZE * CHUNK_SIZE * 6);
     m_indices.reserve(CHUNK_SIZE * CHUNK_SIZE * 6);
-    
-    glm::vec3 chunkPos = m_gameObject->transform.translation;
-    int chunkX = static_cast<int>(chunkPos.x / CHUNK_SIZE);
-    int chunkY = static_cast<int>(chunkPos.y / CHUNK_SIZE);
-    int chunkZ = static_cast<int>(chunkPos.z / CHUNK_SIZE);
-    
-    std::shared_ptr<Chunk> neighborXPos = m_neighbors[0];
-    std::shared_ptr<Chunk> neighborXNeg = m_neighbors[1];
-    std::shared_ptr<Chunk> neighborYPos = m_neighbors[2];
-    std::shared_ptr<Chunk> neighborYNeg = m_neighbors[3];
-    std::shared_ptr<Chunk> neighborZPos = m_neighbors[4];
-    std::shared_ptr<Chunk> neighborZNeg = m_neighbors[5];
 
-    // Temporary arrays to store visibility and block type information
-    // Each entry will store -1 for empty/hidden faces, or a value >=0 representing the block type
-    std::vector<int> visibilityMask(CHUNK_SIZE * CHUNK_SIZE, -1);
-    
-    // Process each of the 6 face directions
-    processGreedyDirection(Direction::TOP, neighborYPos);
-    processGreedyDirection(Direction::BOTTOM, neighborYNeg);
-    processGreedyDirection(Direction::FRONT, neighborZNeg);
-    processGreedyDirection(Direction::BACK, neighborZPos);
-    processGreedyDirection(Direction::LEFT, neighborXNeg);
-    processGreedyDirection(Direction::RIGHT, neighborXPos);
+    // Neighbours at another level mesh as air, so this side of the seam is closed
+    std::array<std::shared_ptr<Chunk>, 6> neighbors = m_neighbors;
+    for (int i = 0; i < 6; ++i) {
+        if (lod.seams & (1 << i)) neighbors[i] = nullptr;
+    }
+
+    // Unpacked once and shared by all six directions
+    std::array<Block, CHUNK_VOLUME> blocks;
+    storage().unpack(blocks);
 
+    if (lod.level > 0) {
+        generateLodMesh(lod.level, neighbors, blocks);
+    } else {
+        // One direction at a time, in m_neighbors order, so each lands in its own bucket
+        processGreedyDirection(Direction::RIGHT, neighbors[0], blocks);
+        processGreedyDirection(Direction::LEFT, neighbors[1], blocks);
+        processGreedyDirection(Direction::TOP, neighbors[2], blocks);
+        processGreedyDirection(Direction::BOTTOM, neighbors[3], blocks);
+        processGreedyDirection(Direction::BACK, neighbors[4], blocks);
+        processGreedyDirection(Direction::FRONT, neighbors[5], blocks);
+    }
+    bucketFaces();
+
+    // Downsampled geometry is not inside the real blocks, so it cannot occlude
+    if (lod.level == 0) {
+        extractOccluders();
+    } else {
+        m_occluders.reset();
+    }
+
+    m_meshLod = packLod(lod);
+    countMemory();
     flags |= ChunkFlags::MESH_GENERATED;
     flags &= ~ChunkFlags::UP_TO_DATE;
 }
 
+// Face of a chunk, numbered like m_neighbors, that a quad with this normal looks through
+static int normalFace(const glm::vec3& normal) {
+    if (normal.x != 0.0f) return normal.x > 0.0f ? 0 : 1;
+    if (normal.y != 0.0f) return normal.y > 0.0f ? 2 : 3;
+    return normal.z > 0.0f ? 4 : 5;
+}
+
+void Chunk::bucketFaces() {
+    // Every quad is 4 consecutive vertices and 6 consecutive indices
+    size_t quads = m_vertices.size() / 4;
+    if (m_vertices.size() % 4 != 0 || m_indices.size() != quads * 6) {
+        m_faceOffsets.clear();
+        return;
+    }
+
+    std::array<uint32_t, 7> starts{};
+    bool ordered = true;
+    int previous = 0;
+    for (size_t quad = 0; quad < quads; ++quad) {
+        int face = normalFace(m_vertices[quad * 4].normal);
+        starts[face + 1]++;
+        ordered &= face >= previous;
+        previous = face;
+    }
+    for (int face = 0; face < 6; ++face) {
+        starts[face + 1] += starts[face];
+    }
+
+    if (!ordered) {
+        // Stable counting sort; indices move with their quad and are rebased
+        std::vector<Model::Vertex> vertices(m_vertices.size());
+        std::vector<uint32_t> indices(m_indices.size());
+        std::array<uint32_t, 7> next = starts;
+        for (size_t quad = 0; quad < quads; ++quad) {
+            uint32_t target = next[normalFace(m_vertices[quad * 4].normal)]++;
+            std::copy_n(m_vertices.begin() + quad * 4, 4, vertices.begin() + target * 4);
+            for (int i = 0; i < 6; ++i) {
+                indices[target * 6 + i] = m_indices[quad * 6 + i] - static_cast<uint32_t>(quad * 4) + target * 4;
+            }
+        }
+        m_vertices = std::move(vertices);
+        m_indices = std::move(indices);
+    }
+
+    m_faceOffsets.resize(7);
+    for (int face = 0; face < 7; ++face) {
+        m_faceOffsets[face] = starts[face] * 6;
+    }
+}
+
+void Chunk::extractOccluders() {
+    // Every quad is 4 consecutive vertices, in greedy and simple meshes alike
+    std::vector<OccluderQuad> quads;
+    for (size_t i = 0; i + 3 < m_vertices.size(); i += 4) {
+        // Leaves and water may be drawn see-through later; only solid blocks hide things
+        BlockType type = static_cast<BlockType>(m_vertices[i].block_type);
+        if (type == BlockType::WATER || type == BlockType::LEAVES) continue;
+
+        const glm::vec3& origin = m_vertices[i].position;
+        float area = glm::length(glm::cross(m_vertices[i + 1].position - origin, m_vertices[i + 3].position - origin));
+        if (area < OCCLUDER_MIN_AREA) continue;
+
+        quads.push_back({{m_vertices[i].position, m_vertices[i + 1].position, m_vertices[i + 2].position, m_vertices[i + 3].position}});
+    }
+    m_occluders = quads.empty() ? nullptr : std::make_shared<const std::vector<OccluderQuad>>(std::move(quads));
+}
+
 // Helper method to process greedy meshing for a specific direction
-void Chunk::processGreedyDirection(Direction direction, std::shared_ptr<Chunk> neighbor) {
+void Chunk::processGreedyDirection(Direction direction, std::shared_ptr<Chunk> neighbor, const std::array<Block, CHUNK_VOLUME>& blocks) {
     // Arrays to store visibility and block type information
     // Each entry will store -1 for empty/hidden faces, or a value >=0 representing the block type
     std::vector<int> visibilityMask(CHUNK_SIZE * CHUNK_SIZE, -1);
@@ -190,7 +277,7 @@ void Chunk::processGreedyDirection(Direction direction, std::shared_ptr<Chunk> n
                 int z = (normalAxis == 2) ? n : ((uAxis == 2) ? u : v);
                 
                 // Check if this face needs to be rendered
-                Block block = getBlock(x, y, z);
+                Block block = blocks[chunkBlockIndex(x, y, z)];
                 
                 if (block.type != BlockType::AIR) {
                     // Calculate the coordinates of the adjacent block
@@ -203,7 +290,7 @@ void Chunk::processGreedyDirection(Direction direction, std::shared_ptr<Chunk> n
                     
                     if (isInBounds(nx, ny, nz)) {
                         // Adjacent block is within this chunk
-                        faceVisible = (getBlock(nx, ny, nz).type == BlockType::AIR);
+                        faceVisible = (blocks[chunkBlockIndex(nx, ny, nz)].type == BlockType::AIR);
                     } else {
                         // Adjacent block is in a neighboring chunk
                         if (neighbor) {
@@ -227,57 +314,237 @@ void Chunk::processGreedyDirection(Direction direction, std::shared_ptr<Chunk> n
             }
         }
         
-        // Apply greedy meshing to this slice
-        // This loop continues until all visible faces in this slice have been processed
-        for (int v = 0; v < CHUNK_SIZE; v++) {
-            for (int u = 0; u < CHUNK_SIZE; u++) {
-                int blockTypeValue = visibilityMask[u + v * CHUNK_SIZE];
-                
-                // Skip if this face is hidden or already processed
-                if (blockTypeValue == -1) continue;
-                
-                // Convert back to block type
-                BlockType blockType = static_cast<BlockType>(blockTypeValue);
-                
-                // Find the width of this quad (how far it extends in the u direction)
-                int width = 1;
-                while (u + width < CHUNK_SIZE && visibilityMask[u + width + v * CHUNK_SIZE] == blockTypeValue) {
-                    width++;
-                }
-                
-                // Find the height of this quad (how far it extends in the v direction)
-                int height = 1;
-                bool canExtendHeight = true;
-                
-                while (canExtendHeight && v + height < CHUNK_SIZE) {
-                    // Check if we can extend by one row
-                    for (int du = 0; du < width; du++) {
-                        if (visibilityMask[(u + du) + (v + height) * CHUNK_SIZE] != blockTypeValue) {
-                            canExtendHeight = false;
-                            break;
-                        }
+        emitGreedyQuads(visibilityMask, CHUNK_SIZE, n, direction, normalAxis, uAxis, vAxis, 1);
+    }
+}
+
+void Chunk::emitGreedyQuads(std::vector<int>& mask, int size, int slice, Direction direction, int normalAxis, int uAxis, int vAxis, int scale) {
+    // Apply greedy meshing to this slice
+    // This loop continues until all visible faces in this slice have been processed
+    for (int v = 0; v < size; v++) {
+        for (int u = 0; u < size; u++) {
+            int blockTypeValue = mask[u + v * size];
+
+            // Skip if this face is hidden or already processed
+            if (blockTypeValue == -1) continue;
+
+            // Convert back to block type
+            BlockType blockType = static_cast<BlockType>(blockTypeValue);
+
+            // Find the width of this quad (how far it extends in the u direction)
+            int width = 1;
+            while (u + width < size && mask[u + width + v * size] == blockTypeValue) {
+                width++;
+            }
+
+            // Find the height of this quad (how far it extends in the v direction)
+            int height = 1;
+            bool canExtendHeight = true;
+
+            while (canExtendHeight && v + height < size) {
+                // Check if we can extend by one row
+                for (int du = 0; du < width; du++) {
+                    if (mask[(u + du) + (v + height) * size] != blockTypeValue) {
+                        canExtendHeight = false;
+                        break;
                     }
-                    
-                    if (canExtendHeight) height++;
                 }
-                
-                // Mark these faces as processed
-                for (int dv = 0; dv < height; dv++) {
-                    for (int du = 0; du < width; du++) {
-                        visibilityMask[(u + du) + (v + dv) * CHUNK_SIZE] = -1;
+
+                if (canExtendHeight) height++;
+            }
+
+            // Mark these faces as processed
+            for (int dv = 0; dv < height; dv++) {
+                for (int du = 0; du < width; du++) {
+                    mask[(u + du) + (v + dv) * size] = -1;
+                }
+            }
+
+            // Add the quad to the mesh
+            addGreedyFace(slice, u, v, width, height, blockType, direction, normalAxis, uAxis, vAxis, scale);
+        }
+    }
+}
+
+// A cell of `scale`^3 blocks at cell coordinates (cx, cy, cz). It is solid when
+// at least half its blocks are, and takes the most common block of its topmost
+// non-air layer (up is -y) so grass stays on top of dirt. `blockAt` takes
+// block coordinates local to the chunk being sampled.
+template <typename BlockAt>
+static BlockType downsampleCell(int cx, int cy, int cz, int scale, BlockAt&& blockAt) {
+    constexpr int typeCount = static_cast<int>(BlockType::LEAVES) + 1;
+    int solid = 0;
+    BlockType surface = BlockType::AIR;
+    for (int dy = 0; dy < scale; ++dy) {
+        std::array<int, typeCount> counts{};
+        int layerSolid = 0;
+        for (int dz = 0; dz < scale; ++dz) {
+            for (int dx = 0; dx < scale; ++dx) {
+                BlockType type = blockAt(cx * scale + dx, cy * scale + dy, cz * scale + dz);
+                if (type == BlockType::AIR) continue;
+                counts[static_cast<int>(type)]++;
+                layerSolid++;
+            }
+        }
+        if (layerSolid > 0 && surface == BlockType::AIR) {
+            surface = static_cast<BlockType>(std::max_element(counts.begin(), counts.end()) - counts.begin());
+        }
+        solid += layerSolid;
+    }
+    return solid * 2 >= scale * scale * scale ? surface : BlockType::AIR;
+}
+
+void Chunk::generateLodMesh(int level, const std::array<std::shared_ptr<Chunk>, 6>& neighbors, const std::array<Block, CHUNK_VOLUME>& blocks) {
+    const int scale = 1 << level;
+    const int cells = CHUNK_SIZE / scale;
+    auto cellIndex = [cells](const std::array<int, 3>& cell) {
+        return cell[0] + (cell[1] + cell[2] * cells) * cells;
+    };
+
+    std::vector<BlockType> grid(static_cast<size_t>(cells) * cells * cells);
+    for (int z = 0; z < cells; ++z) {
+        for (int y = 0; y < cells; ++y) {
+            for (int x = 0; x < cells; ++x) {
+                grid[cellIndex({x, y, z})] = downsampleCell(x, y, z, scale, [&](int bx, int by, int bz) {
+                    return blocks[chunkBlockIndex(bx, by, bz)].type;
+                });
+            }
+        }
+    }
+
+    // Same axes and neighbours as the full-resolution directions, in m_neighbors order
+    struct Face {
+        Direction direction;
+        int neighbor;
+        int normalAxis, uAxis, vAxis;
+        int normalDirection;
+    };
+    static const Face faces[6] = {
+        {Direction::RIGHT, 0, 0, 1, 2, 1},
+        {Direction::LEFT, 1, 0, 1, 2, -1},
+        {Direction::TOP, 2, 1, 0, 2, 1},
+        {Direction::BOTTOM, 3, 1, 0, 2, -1},
+        {Direction::BACK, 4, 2, 0, 1, 1},
+        {Direction::FRONT, 5, 2, 0, 1, -1},
+    };
+
+    std::vector<BlockType> border(static_cast<size_t>(cells) * cells);
+    std::vector<int> mask(static_cast<size_t>(cells) * cells);
+    for (const Face& face : faces) {
+        // The neighbour's touching cell layer, downsampled the same way, so both
+        // sides of a same-level border agree on which faces are hidden
+        std::fill(border.begin(), border.end(), BlockType::AIR);
+        if (const auto& neighbor = neighbors[face.neighbor]) {
+            std::array<int, 3> cell;
+            cell[face.normalAxis] = face.normalDirection > 0 ? 0 : cells - 1;
+            for (int v = 0; v < cells; ++v) {
+                for (int u = 0; u < cells; ++u) {
+                    cell[face.uAxis] = u;
+                    cell[face.vAxis] = v;
+                    border[u + v * cells] = downsampleCell(cell[0], cell[1], cell[2], scale, [&](int bx, int by, int bz) {
+                        return neighbor->getBlock(bx, by, bz).type;
+                    });
+                }
+            }
+        }
+
+        for (int n = 0; n < cells; ++n) {
+            std::fill(mask.begin(), mask.end(), -1);
+            for (int v = 0; v < cells; ++v) {
+                for (int u = 0; u < cells; ++u) {
+                    std::array<int, 3> cell;
+                    cell[face.normalAxis] = n;
+                    cell[face.uAxis] = u;
+                    cell[face.vAxis] = v;
+                    BlockType type = grid[cellIndex(cell)];
+                    if (type == BlockType::AIR) continue;
+
+                    int adjacent = n + face.normalDirection;
+                    BlockType next;
+                    if (adjacent >= 0 && adjacent < cells) {
+                        cell[face.normalAxis] = adjacent;
+                        next = grid[cellIndex(cell)];
+                    } else {
+                        next = border[u + v * cells];
+                    }
+                    if (next == BlockType::AIR) {
+                        mask[u + v * cells] = static_cast<int>(type);
                     }
                 }
-                
-                // Add the quad to the mesh
-                addGreedyFace(n, u, v, width, height, blockType, direction, normalAxis, uAxis, vAxis);
+            }
+            emitGreedyQuads(mask, cells, n, face.direction, face.normalAxis, face.uAxis, face.vAxis, scale);
+        }
+    }
+}
+
+void Chunk::updateVisibility() {
+    // Uniform chunks need no fill: all air joins every face, anything else none
+    if (storage().paletteSize() == 1) {
+        m_visibility = storage().get(0) == BlockType::AIR ? ALL_FACES_CONNECTED : 0;
+        return;
+    }
+
+    std::array<Block, CHUNK_VOLUME> blocks;
+    storage().unpack(blocks);
+
+    // Flood fill each air region, collect the faces it touches, and join them pairwise
+    std::array<bool, CHUNK_VOLUME> visited{};
+    std::vector<int> stack;
+    stack.reserve(CHUNK_VOLUME);
+    uint16_t visibility = 0;
+    for (int start = 0; start < CHUNK_VOLUME && visibility != ALL_FACES_CONNECTED; ++start) {
+        if (visited[start] || blocks[start].type != BlockType::AIR) continue;
+
+        int faces = 0;
+        visited[start] = true;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int index = stack.back();
+            stack.pop_back();
+            int x = index % CHUNK_SIZE;
+            int y = (index / CHUNK_SIZE) % CHUNK_SIZE;
+            int z = index / (CHUNK_SIZE * CHUNK_SIZE);
+
+            // Same face order as m_neighbors
+            const int coords[3] = {x, y, z};
+            const int strides[3] = {1, CHUNK_SIZE, CHUNK_SIZE * CHUNK_SIZE};
+            for (int axis = 0; axis < 3; ++axis) {
+                if (coords[axis] == CHUNK_SIZE - 1) {
+                    faces |= 1 << (axis * 2);
+                } else if (!visited[index + strides[axis]] && blocks[index + strides[axis]].type == BlockType::AIR) {
+                    visited[index + strides[axis]] = true;
+                    stack.push_back(index + strides[axis]);
+                }
+                if (coords[axis] == 0) {
+                    faces |= 1 << (axis * 2 + 1);
+                } else if (!visited[index - strides[axis]] && blocks[index - strides[axis]].type == BlockType::AIR) {
+                    visited[index - strides[axis]] = true;
+                    stack.push_back(index - strides[axis]);
+                }
+            }
+        }
+
+        for (int a = 0; a < 6; ++a) {
+            for (int b = a + 1; b < 6; ++b) {
+                if ((faces >> a & 1) && (faces >> b & 1)) {
+                    visibility |= 1 << facePairBit(a, b);
+                }
             }
         }
     }
+    m_visibility = visibility;
 }
 
 // Helper method to add a greedy face to the mesh
 void Chunk::addGreedyFace(int normal, int u, int v, int width, int height, BlockType blockType, Direction direction, 
-                           int normalAxis, int uAxis, int vAxis) {
+                           int normalAxis, int uAxis, int vAxis, int scale) {
+    // Everything below is in blocks
+    normal *= scale;
+    u *= scale;
+    v *= scale;
+    width *= scale;
+    height *= scale;
+
     uint32_t vertexOffset = static_cast<uint32_t>(m_vertices.size());
     
     // Determine color based on block type (same as in addBlockFace)
@@ -328,7 +595,7 @@ void Chunk::addGreedyFace(int normal, int u, int v, int width, int height, Block
     // Set position for base corner
     pos[normalAxis] = static_cast<float>(normal);
     if (direction == Direction::RIGHT || direction == Direction::TOP || direction == Direction::BACK) {
-        pos[normalAxis] += 1.0f;
+        pos[normalAxis] += static_cast<float>(scale);
     }
     pos[uAxis] = static_cast<float>(u);
     pos[vAxis] = static_cast<float>(v);
@@ -393,12 +660,108 @@ void Chunk::addGreedyFace(int normal, int u, int v, int width, int height, Block
     m_indices.push_back(vertexOffset + 3);
 }
 
+uint64_t Chunk::meshKey(MeshingTechnique technique, ChunkLod lod) const {
+    // Bump when the mesher or Model::Vertex changes so old cache entries stop matching
+    static constexpr uint64_t MESH_FORMAT_VERSION = 1;
+
+    // Coarse levels are always meshed greedily
+    if (lod.level > 0) technique = MeshingTechnique::GREEDY;
+    const int scale = 1 << lod.level;
+
+    // One byte per own block, then the air-ness of each neighbour's blocks in
+    // m_neighbors order: the slab of `scale` layers that touches this chunk.
+    // A missing or seam neighbour meshes exactly like an air one.
+    std::vector<uint8_t> bytes(CHUNK_VOLUME + 6 * CHUNK_SIZE * CHUNK_SIZE * scale);
+    std::array<Block, CHUNK_VOLUME> blocks;
+    storage().unpack(blocks);
+    for (int i = 0; i < CHUNK_VOLUME; ++i) {
+        bytes[i] = static_cast<uint8_t>(blocks[i].type);
+    }
+
+    size_t write = CHUNK_VOLUME;
+    for (int face = 0; face < 6; ++face) {
+        const std::shared_ptr<Chunk>& neighbor = (lod.seams & (1 << face)) ? nullptr : m_neighbors[face];
+        int axis = face / 2;
+        for (int layer = 0; layer < scale; ++layer) {
+            // The neighbour's slices that touch this chunk: x+ neighbour's x = 0, x- neighbour's x = 15, ...
+            int slice = (face % 2 == 0) ? layer : CHUNK_SIZE - 1 - layer;
+            for (int v = 0; v < CHUNK_SIZE; ++v) {
+                for (int u = 0; u < CHUNK_SIZE; ++u) {
+                    bool air = true;
+                    if (neighbor) {
+                        int x = axis == 0 ? slice : u;
+                        int y = axis == 1 ? slice : (axis == 0 ? u : v);
+                        int z = axis == 2 ? slice : v;
+                        air = neighbor->getBlock(x, y, z).type == BlockType::AIR;
+                    }
+                    bytes[write++] = air ? 0 : 1;
+                }
+            }
+        }
+    }
+
+    // Level 0 keeps the seed it always had, so existing cache entries still match
+    uint64_t seed = splitmix64(MESH_FORMAT_VERSION * 16 + static_cast<uint64_t>(technique));
+    if (lod.level > 0) {
+        seed = splitmix64(seed ^ static_cast<uint64_t>(lod.level));
+    }
+    return hashBytes(bytes.data(), bytes.size(), seed);
+}
+
+void Chunk::setMesh(std::vector<Model::Vertex> vertices, std::vector<uint32_t> indices, ChunkLod lod) {
+    m_vertices = std::move(vertices);
+    m_indices = std::move(indices);
+    m_sharedModel.reset();
+    m_meshLod = packLod(lod);
+    // Meshes cached before they were bucketed are sorted here
+    bucketFaces();
+    if (lod.level == 0) {
+        extractOccluders();
+    } else {
+        m_occluders.reset();
+    }
+    countMemory();
+
+    flags |= ChunkFlags::MESH_GENERATED;
+    flags &= ~ChunkFlags::UP_TO_DATE;
+}
+
+void Chunk::setSharedMesh(std::shared_ptr<Model> model, ChunkLod lod, std::shared_ptr<const std::vector<OccluderQuad>> occluders) {
+    m_vertices.clear();
+    m_indices.clear();
+    m_faceOffsets.clear();
+    m_sharedModel = std::move(model);
+    m_occluders = std::move(occluders);
+    m_meshLod = packLod(lod);
+    countMemory();
+
+    flags |= ChunkFlags::MESH_GENERATED;
+    flags &= ~ChunkFlags::UP_TO_DATE;
+}
+
+void Chunk::setLod(ChunkLod lod) {
+    int packed = packLod(lod);
+    m_lod = packed;
+    // A mesh built for another level or seam set is rebuilt; the old one stays
+    // on screen until the new one is uploaded
+    if (meshGenerated() && m_meshLod != packed) {
+        flags &= ~ChunkFlags::MESH_GENERATED;
+    }
+}
+
 void Chunk::updateGameObject() {
-    if (m_gameObject && !m_vertices.empty() && !m_indices.empty()) {
+    m_drawnOccluders = m_occluders;
+    if (m_gameObject && m_sharedModel) {
+        m_gameObject->model = std::move(m_sharedModel);
+    } else if (m_gameObject && !m_vertices.empty() && !m_indices.empty()) {
+        if (device == nullptr) {
+            throw std::runtime_error("Headless chunk cannot upload its mesh");
+        }
         Model::Builder builder{};
         builder.vertices = m_vertices;
         builder.indices = m_indices;
-        m_gameObject->model = std::make_shared<Model>(device, builder);
+        builder.groupOffsets = m_faceOffsets;
+        m_gameObject->model = std::make_shared<Model>(*device, builder);
     } else {
         if (m_gameObject.get() == nullptr) {
             throw std::runtime_error("GameObject is null");
@@ -0,0 +1,50 @@
+#include "chunk_region.hpp"
+#include "decoration_buffer.hpp"
+#include "terrain_generator.hpp"
+
+namespace vkengine {
+
+std::vector<ChunkCoord> regionCoords(uint64_t seed, int renderDistance, size_t* skipped) {
+    // Same bounds, range test and sky culling as ChunkManager::update
+    TerrainGenerator generator{seed};
+    int verticalRange = renderDistance / 2 + 1;
+    std::vector<ChunkCoord> coords;
+    size_t empty = 0;
+    for (int x = -renderDistance; x <= renderDistance; ++x) {
+        for (int y = -verticalRange; y <= verticalRange; ++y) {
+            for (int z = -renderDistance; z <= renderDistance; ++z) {
+                if (x * x + y * y + z * z > renderDistance * renderDistance) continue;
+                ChunkCoord coord{x, y, z};
+                if (generator.isChunkEmpty(coord)) {
+                    empty++;
+                } else {
+                    coords.push_back(coord);
+                }
+            }
+        }
+    }
+    if (skipped) *skipped = empty;
+    return coords;
+}
+
+ChunkMap buildRegion(uint64_t seed, int renderDistance, Device* device) {
+    TerrainGenerator generator{seed};
+    DecorationBuffer decorations;
+    ChunkMap chunks;
+    for (const ChunkCoord& coord : regionCoords(seed, renderDistance)) {
+        auto gameObject = GameObject::createGameObject();
+        gameObject->transform.translation = glm::vec3(coord.x, coord.y, coord.z) * static_cast<float>(CHUNK_SIZE);
+        auto chunk = device ? std::make_shared<Chunk>(*device, gameObject) : std::make_shared<Chunk>(gameObject);
+        chunk->generateTerrain(generator, decorations);
+        chunks[coord] = chunk;
+    }
+    for (auto& [coord, chunk] : chunks) {
+        for (int f = 0; f < 6; ++f) {
+            auto it = chunks.find({coord.x + FACE_OFFSETS[f][0], coord.y + FACE_OFFSETS[f][1], coord.z + FACE_OFFSETS[f][2]});
+            chunk->m_neighbors[f] = it == chunks.end() ? nullptr : it->second;
+        }
+    }
+    return chunks;
+}
+
+} // namespace vkengine
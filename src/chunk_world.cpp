@@ -1,63 +1,212 @@
 #include "chunk.hpp"
 #include "game_object.hpp"
-#include "perlin_noise.hpp"
+#include "terrain_generator.hpp"
+#include "chunk_codec.hpp"
+#include "byte_io.hpp"
+#include "dirty_chunks.hpp"
+#include "chunk_memory.hpp"
 #include <algorithm> // added for std::clamp
+#include <cstring>
 #include <iostream> // added for std::cout
 #include <string>
 #include <sstream>
 
 namespace vkengine {
 
-Chunk::Chunk(Device &deviceRef, std::shared_ptr<GameObject> gameObject) 
-    : device{deviceRef}, m_gameObject(gameObject) {
+Chunk::Chunk(Device &deviceRef, std::shared_ptr<GameObject> gameObject, WorldSnapshots* snapshots, DirtyChunks* dirtyChunks,
+             ChunkMemory* memory)
+    : m_blocks(std::make_shared<BlockStorage>()), m_snapshots(snapshots), m_dirtyChunks(dirtyChunks), m_memory(memory),
+      m_gameObject(gameObject), device{&deviceRef} {
+    // Created during a snapshot: not part of it
+    m_blocksEpoch = m_snapshots ? m_snapshots->active() : 0;
+    initialize();
+}
+
+Chunk::Chunk(std::shared_ptr<GameObject> gameObject)
+    : m_blocks(std::make_shared<BlockStorage>()), m_gameObject(gameObject) {
     initialize();
 }
 
 Chunk::~Chunk() {
+    if (m_memory) {
+        m_memory->blockBytes -= m_countedBlockBytes;
+        m_memory->meshBytes -= m_countedMeshBytes;
+        m_memory->coldChunks -= m_countedCold;
+    }
 }
 
 void Chunk::initialize() {
-    fill(0, 0, 0, CHUNK_SIZE - 1, CHUNK_SIZE - 1, CHUNK_SIZE - 1, BlockType::AIR);
-}
-
-
-void Chunk::generateTerrain() {
-    // Basic elevation-based terrain using Perlin noise
-    ChunkCoord coord = getChunkCoord();
-    int worldOffsetX = coord.x * CHUNK_SIZE;
-    int worldOffsetZ = coord.z * CHUNK_SIZE;
-
-    for (int x = 0; x < CHUNK_SIZE; ++x) {
-        for (int z = 0; z < CHUNK_SIZE; ++z) {
-            // Get elevation from perlin noise.
-            double nx = (worldOffsetX + x) * settings.elevFrequency;
-            double nz = (worldOffsetZ + z) * settings.elevFrequency;
-            double e = settings.elevationNoise.octaveNoise(nx, nz, settings.elevOctaves, settings.elevPersistence);
-            int height = static_cast<int>(e * settings.elevHeightScale + settings.elevBaseHeight);
-            height = std::clamp(height, 0, CHUNK_SIZE - 1);
-
-            // Fill column by global world height
-            for (int y = 0; y < CHUNK_SIZE; ++y) {
-                // account for negative-y-up: flip local y so y=0 is top
-                int worldY = coord.y * CHUNK_SIZE + (CHUNK_SIZE - 1 - y);
-                if (worldY < height - settings.baseSoilDepth) {
-                    setBlock(x, y, z, BlockType::STONE);
-                } else if (worldY < height) {
-                    setBlock(x, y, z, BlockType::DIRT);
-                } else if (worldY == height) {
-                    setBlock(x, y, z, BlockType::GRASS);
-                } else {
-                    setBlock(x, y, z, BlockType::AIR);
-                }
-            }
-        }
+    // Not fill(): a fresh chunk is not an edit
+    prepareWrite();
+    storage().fill(BlockType::AIR);
+    flags &= ~ChunkFlags::MESH_GENERATED;
+    countMemory();
+}
+
+
+void Chunk::prepareWrite() {
+    storage();
+    // A mesh built from the old blocks must not be installed after this write
+    m_meshKey = 0;
+
+    uint64_t active = m_snapshots ? m_snapshots->active() : 0;
+    if (active == 0) {
+        m_snapshot = {};
+    } else if (m_blocksEpoch < active) {
+        // First write since the snapshot: keep what it saw. A clean chunk is not
+        // saved, so only its flags are kept and nothing outlives the snapshot.
+        m_snapshot = {(flags & ChunkFlags::DIRTY) ? m_blocks : nullptr, flags, false};
+        m_snapshotEpoch = active;
+        m_blocksEpoch = active;
     }
 
+    // Also covers storage a finished snapshot's reader still holds
+    if (m_blocks.use_count() > 1) {
+        m_blocks = std::make_shared<BlockStorage>(storage());
+    }
+}
+
+bool Chunk::readSnapshot(uint64_t epoch, ChunkSnapshot& snapshot) {
+    if (m_snapshotEpoch == epoch) {
+        snapshot = m_snapshot;
+        return true;
+    }
+    if (m_blocksEpoch >= epoch) {
+        return false;
+    }
+    // Unchanged since the snapshot. A clean chunk is not saved, so its storage
+    // is left alone and a cold chunk stays cold.
+    snapshot = {nullptr, flags, true};
+    if (!(flags & ChunkFlags::DIRTY)) {
+        return true;
+    }
+    // A cold chunk is decoded into storage of the snapshot's own; otherwise
+    // sharing the storage makes the next write copy it
+    snapshot.blocks = m_cold ? decodeCompressed() : m_blocks;
+    return true;
+}
+
+void Chunk::releaseSnapshot(uint64_t epoch) {
+    m_snapshot = {};
+    // The snapshot is done with this chunk; later writes need not set anything aside
+    m_blocksEpoch = std::max(m_blocksEpoch, epoch);
+}
+
+bool Chunk::compress() {
+    if (m_cold) return true;
+    // Not generated yet, a snapshot reader still holds the storage, or identical
+    // chunks share it and it costs nothing extra
+    if (!defaultTerrainGenerated() || m_snapshot.blocks || m_blocks.use_count() > 1) {
+        return false;
+    }
+
+    std::array<Block, CHUNK_VOLUME> unpacked;
+    m_blocks->unpack(unpacked);
+    std::string compressed;
+    chunkCodec(ChunkCodecId::VARINT_RLE).encode(unpacked, compressed);
+    compressed.shrink_to_fit();
+
+    m_compressed = std::move(compressed);
+    m_blocks.reset();
+    m_cold = true;
+
+    // The GPU model has the mesh; the CPU copy is only needed until upload
+    if (upToDate()) {
+        std::vector<Model::Vertex>().swap(m_vertices);
+        std::vector<uint32_t>().swap(m_indices);
+        std::vector<uint32_t>().swap(m_faceOffsets);
+    }
+    countMemory();
+    return true;
+}
+
+std::shared_ptr<BlockStorage> Chunk::decodeCompressed() const {
+    std::array<Block, CHUNK_VOLUME> unpacked;
+    chunkCodec(ChunkCodecId::VARINT_RLE).decode(m_compressed, unpacked);
+
+    auto storage = std::make_shared<BlockStorage>();
+    storage->pack(unpacked);
+    return storage;
+}
+
+void Chunk::decompress() const {
+    m_blocks = decodeCompressed();
+    shareStorage();
+    std::string().swap(m_compressed);
+    m_cold = false;
+    countMemory();
+}
+
+void Chunk::shareStorage() const {
+    const BlockStorage& packed = *m_blocks;
+    m_blocks = blockStoragePool().intern(packed.contentHash(), m_blocks, [&](const BlockStorage& other) {
+        return other == packed;
+    });
+}
+
+size_t Chunk::blockMemoryUsage() const {
+    if (m_cold) {
+        return m_compressed.capacity();
+    }
+    return m_blocks->memoryUsage();
+}
+
+size_t Chunk::meshMemoryUsage() const {
+    return m_vertices.capacity() * sizeof(Model::Vertex) + m_indices.capacity() * sizeof(uint32_t);
+}
+
+void Chunk::generateTerrain(TerrainGenerator& generator, DecorationBuffer& decorations) {
+    // Generated flat, then packed once
+    static thread_local std::array<Block, CHUNK_VOLUME> blocks;
+    blocks.fill(Block(BlockType::AIR));
+    generator.populateChunk(getChunkCoord(), blocks, decorations);
+    prepareWrite();
+    storage().pack(blocks);
+    shareStorage();
+    countMemory();
+
     flags |= ChunkFlags::DEFAULT_TERRAIN_GENERATED;
+    flags &= ~ChunkFlags::LOADED_FROM_DISK;
+    flags &= ~ChunkFlags::DIRTY;
     flags &= ~ChunkFlags::MESH_GENERATED;
     flags &= ~ChunkFlags::UP_TO_DATE;
 }
 
+void Chunk::loadTerrain(std::string_view data) {
+    deserialize(data);
+
+    flags |= ChunkFlags::DEFAULT_TERRAIN_GENERATED | ChunkFlags::LOADED_FROM_DISK;
+    flags &= ~ChunkFlags::STORED_ON_DISK;
+    flags &= ~ChunkFlags::DIRTY;
+    flags &= ~ChunkFlags::MESH_GENERATED;
+    flags &= ~ChunkFlags::UP_TO_DATE;
+}
+
+bool Chunk::applyDecorations(const std::vector<PendingBlock>& writes) {
+    if (flags & ChunkFlags::LOADED_FROM_DISK) {
+        return false;
+    }
+    bool changed = false;
+    for (const auto& write : writes) {
+        if (decorationPriority(write.type) > decorationPriority(storage().get(write.index))) {
+            prepareWrite();
+            storage().set(write.index, write.type);
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return false;
+    }
+    countMemory();
+    flags &= ~ChunkFlags::MESH_GENERATED;
+    // The saved copy predates this overhang, and loading it drops late writes;
+    // only saving the chunk again keeps the tree whole
+    if (flags & ChunkFlags::EDITED) {
+        markDirty();
+    }
+    return true;
+}
+
 void Chunk::fill(int x1, int y1, int z1, int x2, int y2, int z2, BlockType blockType) {
     if (x1 > x2) std::swap(x1, x2);
     if (y1 > y2) std::swap(y1, y2);
@@ -69,6 +218,15 @@ void Chunk::fill(int x1, int y1, int z1, int x2, int y2, int z2, BlockType block
     x2 = std::max(0, std::min(x2, CHUNK_SIZE - 1));
     y2 = std::max(0, std::min(y2, CHUNK_SIZE - 1));
     z2 = std::max(0, std::min(z2, CHUNK_SIZE - 1));
+
+    if (x1 == 0 && y1 == 0 && z1 == 0 && x2 == CHUNK_SIZE - 1 && y2 == CHUNK_SIZE - 1 && z2 == CHUNK_SIZE - 1) {
+        prepareWrite();
+        storage().fill(blockType);
+        countMemory();
+        flags &= ~ChunkFlags::MESH_GENERATED;
+        markDirty();
+        return;
+    }
     
     for (int x = x1; x <= x2; x++) {
         for (int y = y1; y <= y2; y++) {
@@ -85,9 +243,12 @@ void Chunk::setBlock(int x, int y, int z, BlockType blockType) {
     if (isInBounds(x, y, z)) {
         int index = coordsToIndex(x, y, z);
         
-        if (m_blocks[index].type != blockType) {
-            m_blocks[index].type = blockType;
+        if (storage().get(index) != blockType) {
+            prepareWrite();
+            storage().set(index, blockType);
+            countMemory();
             flags &= ~ChunkFlags::MESH_GENERATED;
+            markDirty();
         }
     }
 }
@@ -95,7 +256,7 @@ void Chunk::setBlock(int x, int y, int z, BlockType blockType) {
 Block Chunk::getBlock(int x, int y, int z) const {
     if (isInBounds(x, y, z)) {
         int index = coordsToIndex(x, y, z);
-        return m_blocks[index];
+        return Block(storage().get(index));
     }
     
     return Block(BlockType::AIR);
@@ -108,78 +269,83 @@ bool Chunk::isInBounds(int x, int y, int z) const {
 }
 
 int Chunk::coordsToIndex(int x, int y, int z) const {
-    return x + (y * CHUNK_SIZE) + (z * CHUNK_SIZE * CHUNK_SIZE);
+    return chunkBlockIndex(x, y, z);
 }
 
+// Payload: [magic][codec id][codec data]. Nothing in it depends on where the
+// chunk is, so identical chunks serialize to identical bytes and region files
+// can store them once; the region table already says which chunk it is. The
+// magic's first byte keeps it apart from the legacy payload, which starts with
+// a world x that is always a multiple of CHUNK_SIZE.
+static constexpr char CHUNK_PAYLOAD_MAGIC[4] = {'V', 'K', 'C', 'B'};
+// Earlier payloads also carried the chunk coordinates: [magic][x, y, z as int32][codec id][codec data]
+static constexpr char CHUNK_PAYLOAD_MAGIC_WITH_COORDS[4] = {'V', 'K', 'C', 'K'};
+static constexpr size_t CHUNK_PAYLOAD_COORDS_HEADER = sizeof(CHUNK_PAYLOAD_MAGIC_WITH_COORDS) + 3 * sizeof(int32_t);
+
 std::string Chunk::serialize() const {
-    std::string out;
-    // reserve header + worst-case RLE (2 bytes per block)
-    out.reserve(3 * sizeof(int32_t) + 2 * m_blocks.size());
-
-    // 1) Write X,Y,Z as 32-bit ints
-    int32_t xi = static_cast<int32_t>(m_gameObject->transform.translation.x);
-    int32_t yi = static_cast<int32_t>(m_gameObject->transform.translation.y);
-    int32_t zi = static_cast<int32_t>(m_gameObject->transform.translation.z);
-    out.append(reinterpret_cast<const char*>(&xi), sizeof(xi));
-    out.append(reinterpret_cast<const char*>(&yi), sizeof(yi));
-    out.append(reinterpret_cast<const char*>(&zi), sizeof(zi));
-
-    // 2) RLE-encode block types
-    if (!m_blocks.empty()) {
-        uint8_t runType  = uint8_t(m_blocks[0].type);
-        uint8_t runCount = 1;
-        for (size_t i = 1; i < m_blocks.size(); ++i) {
-            uint8_t t = uint8_t(m_blocks[i].type);
-            if (t == runType && runCount < 255) {
-                ++runCount;
-            } else {
-                out.push_back(static_cast<char>(runType));
-                out.push_back(static_cast<char>(runCount));
-                runType  = t;
-                runCount = 1;
-            }
-        }
-        // flush final run
-        out.push_back(static_cast<char>(runType));
-        out.push_back(static_cast<char>(runCount));
-    }
+    return serialize(storage());
+}
 
+std::string Chunk::serialize(const BlockStorage& storage) {
+    std::array<Block, CHUNK_VOLUME> blocks;
+    storage.unpack(blocks);
+
+    std::string out(CHUNK_PAYLOAD_MAGIC, sizeof(CHUNK_PAYLOAD_MAGIC));
+    // Whichever codec is smallest for this chunk
+    encodeSmallest(blocks, out);
     return out;
 }
 
-void Chunk::deserialize(const std::string& in) {
-    // 1) Must be at least 12 bytes for X,Y,Z
+// Byte-pair RLE behind a native-endian world position, written before codecs existed
+static void decodeLegacyPayload(std::string_view in, glm::vec3& translation, std::array<Block, CHUNK_VOLUME>& blocks) {
     constexpr size_t HEADER = 3 * sizeof(int32_t);
     if (in.size() < HEADER)
         throw std::runtime_error("Chunk data too short");
 
-    // 2) Read X,Y,Z
     int32_t xi, yi, zi;
     std::memcpy(&xi, in.data() +   0, sizeof(xi));
     std::memcpy(&yi, in.data() +   4, sizeof(yi));
     std::memcpy(&zi, in.data() +   8, sizeof(zi));
+    translation = {float(xi), float(yi), float(zi)};
 
-    // Apply to existing GameObject
-    m_gameObject->transform.translation.x = float(xi);
-    m_gameObject->transform.translation.y = float(yi);
-    m_gameObject->transform.translation.z = float(zi);
-
-    // 3) Clear existing blocks: fill with air
-    fill(0, 0, 0, CHUNK_SIZE - 1, CHUNK_SIZE - 1, CHUNK_SIZE - 1, BlockType::AIR);
-
-    // 4) RLE-decode blocks into the vector
     size_t idx = HEADER;
     size_t write = 0;
-    while (idx + 2 <= in.size() && write < m_blocks.size()) {
+    while (idx + 2 <= in.size() && write < blocks.size()) {
         uint8_t t     = static_cast<uint8_t>(in[idx]);
         uint8_t count = static_cast<uint8_t>(in[idx+1]);
         idx += 2;
-        for (uint8_t c = 0; c < count && write < m_blocks.size(); ++c) {
-            m_blocks[write++].type = BlockType(t);
+        for (uint8_t c = 0; c < count && write < blocks.size(); ++c) {
+            blocks[write++].type = BlockType(t);
         }
     }
 }
 
+void Chunk::deserialize(std::string_view in) {
+    std::array<Block, CHUNK_VOLUME> blocks;
+
+    if (in.size() >= sizeof(CHUNK_PAYLOAD_MAGIC) && std::memcmp(in.data(), CHUNK_PAYLOAD_MAGIC, sizeof(CHUNK_PAYLOAD_MAGIC)) == 0) {
+        decodeTagged(in.substr(sizeof(CHUNK_PAYLOAD_MAGIC)), blocks);
+    } else if (in.size() >= CHUNK_PAYLOAD_COORDS_HEADER && std::memcmp(in.data(), CHUNK_PAYLOAD_MAGIC_WITH_COORDS, sizeof(CHUNK_PAYLOAD_MAGIC_WITH_COORDS)) == 0) {
+        const char* header = in.data() + sizeof(CHUNK_PAYLOAD_MAGIC_WITH_COORDS);
+        ChunkCoord coord{static_cast<int32_t>(getU32(header)), static_cast<int32_t>(getU32(header + 4)), static_cast<int32_t>(getU32(header + 8))};
+        decodeTagged(in.substr(CHUNK_PAYLOAD_COORDS_HEADER), blocks);
+
+        m_gameObject->transform.translation = {
+            static_cast<float>(coord.x * CHUNK_SIZE),
+            static_cast<float>(coord.y * CHUNK_SIZE),
+            static_cast<float>(coord.z * CHUNK_SIZE)
+        };
+    } else {
+        decodeLegacyPayload(in, m_gameObject->transform.translation, blocks);
+    }
+
+    prepareWrite();
+    storage().pack(blocks);
+    shareStorage();
+    countMemory();
+    flags &= ~ChunkFlags::MESH_GENERATED;
+}
+
 bool Chunk::allNeighborsLoaded() const {
     for (const auto& neighbor : m_neighbors) {
         if (!neighbor) return false;
@@ -190,7 +356,11 @@ bool Chunk::allNeighborsLoaded() const {
 void Chunk::clearMesh() {
     m_vertices.clear();
     m_indices.clear();
+    m_faceOffsets.clear();
+    m_sharedModel.reset();
+    m_occluders.reset();
     flags &= ~ChunkFlags::MESH_GENERATED;
+    countMemory();
 }
 
 ChunkCoord Chunk::getChunkCoord() const {
@@ -214,4 +384,41 @@ void Chunk::setUpToDate(bool upToDate) {
     }
 }
 
+void Chunk::setStoredOnDisk(bool stored) {
+    if (stored) {
+        flags |= ChunkFlags::STORED_ON_DISK;
+    } else {
+        flags &= ~ChunkFlags::STORED_ON_DISK;
+    }
+}
+
+void Chunk::markDirty() {
+    if (!(flags & ChunkFlags::DIRTY) && m_dirtyChunks) {
+        m_dirtyChunks->add(getChunkCoord());
+    }
+    flags |= ChunkFlags::DIRTY | ChunkFlags::EDITED;
+}
+
+void Chunk::countMemory() const {
+    if (!m_memory) return;
+    size_t blockBytes = blockMemoryUsage();
+    size_t meshBytes = meshMemoryUsage();
+    bool cold = m_cold;
+    // Unsigned wrap-around turns a shrink into a subtraction
+    m_memory->blockBytes += blockBytes - m_countedBlockBytes;
+    m_memory->meshBytes += meshBytes - m_countedMeshBytes;
+    m_memory->coldChunks += static_cast<size_t>(cold) - static_cast<size_t>(m_countedCold);
+    m_countedBlockBytes = blockBytes;
+    m_countedMeshBytes = meshBytes;
+    m_countedCold = cold;
+}
+
+void Chunk::setDirty(bool dirty) {
+    if (dirty) {
+        markDirty();
+    } else {
+        flags &= ~ChunkFlags::DIRTY;
+    }
+}
+
 } // namespace vkengine
\ No newline at end of file
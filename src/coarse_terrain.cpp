@@ -0,0 +1,282 @@
+#include "coarse_terrain.hpp"
+#include "scope_timer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using ScopeTimer = GlobalTimerData::ScopeTimer;
+
+namespace vkengine {
+
+static glm::vec3 coarseColor(BlockType blockType) {
+    switch (blockType) {
+        case BlockType::GRASS: return {0.0f, 0.8f, 0.0f};
+        case BlockType::DIRT: return {0.6f, 0.3f, 0.0f};
+        case BlockType::STONE: return {0.5f, 0.5f, 0.5f};
+        case BlockType::SAND: return {0.9f, 0.8f, 0.6f};
+        case BlockType::WATER: return {0.0f, 0.0f, 0.8f};
+        default: return {1.0f, 1.0f, 1.0f};
+    }
+}
+
+CoarseTerrain::CoarseTerrain(Device& deviceRef, TerrainGenerator& generator)
+    : device{deviceRef}, terrainGenerator{generator} {
+    for (int i = 0; i < numCoarseThreads; ++i) {
+        threads.emplace_back(&CoarseTerrain::coarseThread, this);
+    }
+}
+
+CoarseTerrain::~CoarseTerrain() {
+    stopThreads = true;
+    samplesSemaphore.release(numCoarseThreads);
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void CoarseTerrain::update(const ChunkCoord& center, int radius, GameObject::Map& gameObjects) {
+    ScopeTimer timer("CoarseTerrain::update");
+
+    int minTileX = floorDiv(center.x - radius, COARSE_TILE_COLUMNS);
+    int maxTileX = floorDiv(center.x + radius, COARSE_TILE_COLUMNS);
+    int minTileZ = floorDiv(center.z - radius, COARSE_TILE_COLUMNS);
+    int maxTileZ = floorDiv(center.z + radius, COARSE_TILE_COLUMNS);
+
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        const ColumnCoord& coord = it->first;
+        if (coord.x < minTileX || coord.x > maxTileX || coord.z < minTileZ || coord.z > maxTileZ) {
+            it->second->evicted = true;
+            gameObjects.erase(it->second->gameObject->getId());
+            it = m_tiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::vector<std::shared_ptr<CoarseTile>> missing;
+    for (int tz = minTileZ; tz <= maxTileZ; ++tz) {
+        for (int tx = minTileX; tx <= maxTileX; ++tx) {
+            ColumnCoord coord{tx, tz};
+            if (m_tiles.count(coord)) continue;
+
+            auto tile = std::make_shared<CoarseTile>();
+            tile->coord = coord;
+            tile->gameObject = GameObject::createGameObject();
+            tile->gameObject->transform.translation = {
+                static_cast<float>(tx * COARSE_TILE_COLUMNS * CHUNK_SIZE),
+                0.0f,
+                static_cast<float>(tz * COARSE_TILE_COLUMNS * CHUNK_SIZE)
+            };
+            m_tiles.emplace(coord, tile);
+            missing.push_back(tile);
+        }
+    }
+
+    if (missing.empty()) return;
+
+    // Nearest tiles first so the area around the camera fills in before the horizon
+    auto distance = [&](const std::shared_ptr<CoarseTile>& tile) {
+        int dx = tile->coord.x * COARSE_TILE_COLUMNS + COARSE_TILE_COLUMNS / 2 - center.x;
+        int dz = tile->coord.z * COARSE_TILE_COLUMNS + COARSE_TILE_COLUMNS / 2 - center.z;
+        return dx * dx + dz * dz;
+    };
+    std::sort(missing.begin(), missing.end(), [&](const auto& a, const auto& b) {
+        return distance(a) < distance(b);
+    });
+
+    std::lock_guard<std::mutex> lock(samplesMutex);
+    for (auto& tile : missing) {
+        tilesNeedingSamples.push(tile);
+        samplesSemaphore.release();
+    }
+}
+
+void CoarseTerrain::updateCoverage(const std::function<bool(const ChunkCoord&)>& isChunkShown) {
+    ScopeTimer timer("CoarseTerrain::updateCoverage");
+
+    for (auto& [coord, tile] : m_tiles) {
+        if (!tile->meshed) continue;
+
+        uint64_t covered = 0;
+        for (int cz = 0; cz < COARSE_TILE_COLUMNS; ++cz) {
+            for (int cx = 0; cx < COARSE_TILE_COLUMNS; ++cx) {
+                int column = cx + cz * COARSE_TILE_COLUMNS;
+
+                // Every chunk layer the sampled surface passes through must be on screen
+                int topLayer = floorDiv((CHUNK_SIZE - 1) - tile->columnMaxHeight[column], CHUNK_SIZE);
+                int bottomLayer = floorDiv((CHUNK_SIZE - 1) - tile->columnMinHeight[column], CHUNK_SIZE);
+                int chunkX = coord.x * COARSE_TILE_COLUMNS + cx;
+                int chunkZ = coord.z * COARSE_TILE_COLUMNS + cz;
+
+                bool shown = true;
+                for (int y = topLayer; y <= bottomLayer && shown; ++y) {
+                    shown = isChunkShown({chunkX, y, chunkZ});
+                }
+                if (shown) {
+                    covered |= uint64_t{1} << column;
+                }
+            }
+        }
+
+        tile->coveredColumns = covered;
+        if (covered != tile->meshedColumns) {
+            buildModel(*tile);
+        }
+    }
+}
+
+void CoarseTerrain::uploadReadyTiles(GameObject::Map& gameObjects) {
+    std::queue<std::shared_ptr<CoarseTile>> ready;
+    {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        if (tilesReady.empty()) return;
+        std::swap(ready, tilesReady);
+    }
+
+    ScopeTimer timer("CoarseTerrain::uploadReadyTiles");
+    while (!ready.empty()) {
+        auto tile = ready.front();
+        ready.pop();
+
+        // Evicted while it was being sampled
+        auto it = m_tiles.find(tile->coord);
+        if (it == m_tiles.end() || it->second != tile) continue;
+
+        buildModel(*tile);
+        tile->meshed = true;
+        gameObjects[tile->gameObject->getId()] = tile->gameObject;
+    }
+}
+
+void CoarseTerrain::clear(GameObject::Map& gameObjects) {
+    for (auto& [coord, tile] : m_tiles) {
+        tile->evicted = true;
+        gameObjects.erase(tile->gameObject->getId());
+    }
+    m_tiles.clear();
+}
+
+void CoarseTerrain::sampleTile(CoarseTile& tile) const {
+    int originX = tile.coord.x * COARSE_TILE_COLUMNS * CHUNK_SIZE;
+    int originZ = tile.coord.z * COARSE_TILE_COLUMNS * CHUNK_SIZE;
+
+    tile.samples.resize(COARSE_TILE_SAMPLES * COARSE_TILE_SAMPLES);
+    for (int sz = 0; sz < COARSE_TILE_SAMPLES; ++sz) {
+        for (int sx = 0; sx < COARSE_TILE_SAMPLES; ++sx) {
+            tile.samples[sx + sz * COARSE_TILE_SAMPLES] = terrainGenerator.sampleSurface(
+                originX + sx * COARSE_SAMPLE_SPACING, originZ + sz * COARSE_SAMPLE_SPACING);
+        }
+    }
+
+    // Column extents include the shared edge samples of the neighbouring columns
+    for (int cz = 0; cz < COARSE_TILE_COLUMNS; ++cz) {
+        for (int cx = 0; cx < COARSE_TILE_COLUMNS; ++cx) {
+            int minHeight = std::numeric_limits<int>::max();
+            int maxHeight = std::numeric_limits<int>::min();
+            for (int sz = 0; sz <= COARSE_COLUMN_SAMPLES; ++sz) {
+                for (int sx = 0; sx <= COARSE_COLUMN_SAMPLES; ++sx) {
+                    const SurfaceSample& sample = tile.samples[(cx * COARSE_COLUMN_SAMPLES + sx) + (cz * COARSE_COLUMN_SAMPLES + sz) * COARSE_TILE_SAMPLES];
+                    minHeight = std::min(minHeight, sample.height);
+                    maxHeight = std::max(maxHeight, std::max(sample.height, sample.waterLevel));
+                }
+            }
+            tile.columnMinHeight[cx + cz * COARSE_TILE_COLUMNS] = minHeight;
+            tile.columnMaxHeight[cx + cz * COARSE_TILE_COLUMNS] = maxHeight;
+        }
+    }
+}
+
+void CoarseTerrain::buildModel(CoarseTile& tile) {
+    Model::Builder builder{};
+
+    // Surface vertex in tile space, half a block below the real top face so
+    // full-resolution chunks win the depth test wherever both are drawn
+    auto surfacePoint = [&](int sx, int sz, BlockType& blockType) {
+        const SurfaceSample& sample = tile.samples[sx + sz * COARSE_TILE_SAMPLES];
+        int height = sample.height;
+        blockType = sample.surfaceBlock;
+        if (sample.waterLevel >= sample.height) {
+            height = sample.waterLevel;
+            blockType = BlockType::WATER;
+        }
+        return glm::vec3{
+            static_cast<float>(sx * COARSE_SAMPLE_SPACING),
+            static_cast<float>((CHUNK_SIZE - 1) - height) + 0.5f,
+            static_cast<float>(sz * COARSE_SAMPLE_SPACING)
+        };
+    };
+
+    for (int cz = 0; cz < COARSE_TILE_COLUMNS; ++cz) {
+        for (int cx = 0; cx < COARSE_TILE_COLUMNS; ++cx) {
+            if (tile.coveredColumns & (uint64_t{1} << (cx + cz * COARSE_TILE_COLUMNS))) continue;
+
+            for (int qz = 0; qz < COARSE_COLUMN_SAMPLES; ++qz) {
+                for (int qx = 0; qx < COARSE_COLUMN_SAMPLES; ++qx) {
+                    int sx = cx * COARSE_COLUMN_SAMPLES + qx;
+                    int sz = cz * COARSE_COLUMN_SAMPLES + qz;
+
+                    BlockType blockType, unused;
+                    glm::vec3 p0 = surfacePoint(sx, sz, blockType);
+                    glm::vec3 p1 = surfacePoint(sx + 1, sz, unused);
+                    glm::vec3 p2 = surfacePoint(sx + 1, sz + 1, unused);
+                    glm::vec3 p3 = surfacePoint(sx, sz + 1, unused);
+
+                    // Up is -y in world space
+                    glm::vec3 normal = glm::normalize(glm::cross(p3 - p0, p1 - p0));
+                    if (normal.y > 0.0f) normal = -normal;
+
+                    glm::vec3 color = coarseColor(blockType);
+                    uint32_t type = static_cast<uint32_t>(blockType);
+                    float span = static_cast<float>(COARSE_SAMPLE_SPACING);
+
+                    uint32_t vertexOffset = static_cast<uint32_t>(builder.vertices.size());
+                    builder.vertices.push_back({p0, color, normal, {0.0f, span}, type});
+                    builder.vertices.push_back({p1, color, normal, {span, span}, type});
+                    builder.vertices.push_back({p2, color, normal, {span, 0.0f}, type});
+                    builder.vertices.push_back({p3, color, normal, {0.0f, 0.0f}, type});
+
+                    builder.indices.push_back(vertexOffset);
+                    builder.indices.push_back(vertexOffset + 1);
+                    builder.indices.push_back(vertexOffset + 2);
+                    builder.indices.push_back(vertexOffset);
+                    builder.indices.push_back(vertexOffset + 2);
+                    builder.indices.push_back(vertexOffset + 3);
+                }
+            }
+        }
+    }
+
+    // Fully replaced tiles keep their game object but draw nothing
+    if (builder.vertices.empty()) {
+        tile.gameObject->model = nullptr;
+    } else {
+        tile.gameObject->model = std::make_shared<Model>(device, builder);
+    }
+    tile.meshedColumns = tile.coveredColumns;
+}
+
+void CoarseTerrain::coarseThread() {
+    while (!stopThreads) {
+        samplesSemaphore.acquire();
+        if (stopThreads) break;
+
+        std::shared_ptr<CoarseTile> tile;
+        {
+            std::lock_guard<std::mutex> lock(samplesMutex);
+            if (tilesNeedingSamples.empty()) continue;
+            tile = tilesNeedingSamples.front();
+            tilesNeedingSamples.pop();
+        }
+
+        if (tile->evicted) continue;
+        sampleTile(*tile);
+
+        std::lock_guard<std::mutex> lock(readyMutex);
+        tilesReady.push(tile);
+    }
+}
+
+} // namespace vkengine
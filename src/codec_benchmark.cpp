@@ -0,0 +1,134 @@
+#include "codec_benchmark.hpp"
+#include "chunk_codec.hpp"
+#include "chunk_region.hpp"
+#include "decoration_buffer.hpp"
+#include "terrain_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+namespace vkengine {
+
+using FlatBlocks = std::array<Block, CHUNK_VOLUME>;
+
+static double elapsedSeconds(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool sameBlocks(const FlatBlocks& a, const FlatBlocks& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].type != b[i].type) return false;
+    }
+    return true;
+}
+
+CodecBenchmark::CodecBenchmark(Options opts) : options{opts} {
+    coords = regionCoords(options.seed, options.renderDistance);
+}
+
+bool CodecBenchmark::run() {
+    std::cout << "Chunk codec benchmark: render distance " << options.renderDistance << ", "
+              << coords.size() << " non-empty chunks" << std::endl;
+
+    TerrainGenerator generator{options.seed};
+    DecorationBuffer decorations;
+    std::vector<FlatBlocks> chunks(coords.size());
+    for (size_t i = 0; i < coords.size(); ++i) {
+        generator.populateChunk(coords[i], chunks[i], decorations);
+    }
+
+    // Throughput is quoted against one byte per block
+    double rawMegabytes = static_cast<double>(coords.size()) * CHUNK_VOLUME / 1048576.0;
+    std::printf("  %-12s %8s %10s %12s %12s\n", "codec", "ratio", "bytes/chk", "encode MB/s", "decode MB/s");
+
+    bool ok = true;
+    std::vector<std::string> encoded(coords.size());
+    FlatBlocks decoded;
+
+    auto report = [&](const char* name, double encodeSeconds, double decodeSeconds) {
+        size_t bytes = 0;
+        for (const auto& data : encoded) bytes += data.size();
+        std::printf("  %-12s %7.1fx %10.1f %12.1f %12.1f\n", name,
+                    static_cast<double>(coords.size()) * CHUNK_VOLUME / std::max<size_t>(1, bytes),
+                    static_cast<double>(bytes) / std::max<size_t>(1, coords.size()),
+                    rawMegabytes / encodeSeconds, rawMegabytes / decodeSeconds);
+    };
+
+    // Per codec: chunks for which it gives the smallest encoding
+    std::vector<size_t> wins(chunkCodecs().size(), 0);
+    std::vector<std::vector<size_t>> sizes(chunkCodecs().size());
+
+    for (size_t c = 0; c < chunkCodecs().size(); ++c) {
+        const ChunkCodec& codec = *chunkCodecs()[c];
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            encoded[i].clear();
+            codec.encode(chunks[i], encoded[i]);
+        }
+        double encodeSeconds = elapsedSeconds(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            codec.decode(encoded[i], decoded);
+        }
+        double decodeSeconds = elapsedSeconds(start);
+
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            codec.decode(encoded[i], decoded);
+            if (!sameBlocks(decoded, chunks[i])) {
+                std::cout << "  MISMATCH: " << codec.name() << " does not round-trip chunk " << coords[i].x << ","
+                          << coords[i].y << "," << coords[i].z << std::endl;
+                ok = false;
+                break;
+            }
+            sizes[c].push_back(encoded[i].size());
+        }
+        report(codec.name(), encodeSeconds, decodeSeconds);
+    }
+
+    for (size_t i = 0; i < chunks.size() && ok; ++i) {
+        size_t best = 0;
+        for (size_t c = 1; c < sizes.size(); ++c) {
+            if (sizes[c][i] < sizes[best][i]) best = c;
+        }
+        wins[best]++;
+    }
+
+    // What Chunk::serialize stores: every codec tried, smallest kept, tag included
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        encoded[i].clear();
+        encodeSmallest(chunks[i], encoded[i]);
+    }
+    double encodeSeconds = elapsedSeconds(start);
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        decodeTagged(encoded[i], decoded);
+    }
+    double decodeSeconds = elapsedSeconds(start);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        decodeTagged(encoded[i], decoded);
+        if (!sameBlocks(decoded, chunks[i])) {
+            std::cout << "  MISMATCH: smallest-codec payload does not round-trip" << std::endl;
+            ok = false;
+            break;
+        }
+    }
+    report("smallest", encodeSeconds, decodeSeconds);
+
+    if (ok) {
+        std::cout << "  smallest codec per chunk:";
+        for (size_t c = 0; c < chunkCodecs().size(); ++c) {
+            std::cout << " " << chunkCodecs()[c]->name() << " " << wins[c];
+        }
+        std::cout << std::endl;
+    }
+    return ok;
+}
+
+} // namespace vkengine
@@ -0,0 +1,111 @@
+#include "command_line.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace vkengine {
+
+namespace {
+
+// Whole-string integer parse; "12abc" and out-of-range values are errors rather than 12 or 0
+template <typename T>
+T parseInteger(const std::string& text) {
+    size_t used = 0;
+    long long value = 0;
+    try {
+        value = std::stoll(text, &used, 10);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.size() || value < static_cast<long long>(std::numeric_limits<T>::min())) {
+        throw std::runtime_error("'" + text + "' is not a valid number");
+    }
+    if constexpr (sizeof(T) < sizeof(long long)) {
+        if (value > static_cast<long long>(std::numeric_limits<T>::max())) {
+            throw std::runtime_error("'" + text + "' is out of range");
+        }
+    }
+    return static_cast<T>(value);
+}
+
+void printUsage(const Subcommand& command) {
+    std::cout << "  " << command.name;
+    for (const CommandOption& option : command.options) {
+        std::cout << " [" << option.name << " " << option.valueName << "]";
+    }
+    std::cout << std::endl << "      " << command.description << std::endl;
+}
+
+} // namespace
+
+void parseOptionValue(const std::string& text, int& value) {
+    value = parseInteger<int>(text);
+}
+
+void parseOptionValue(const std::string& text, uint32_t& value) {
+    value = parseInteger<uint32_t>(text);
+}
+
+void parseOptionValue(const std::string& text, uint64_t& value) {
+    // Seeds use the full 64 bits, past what stoll reads
+    size_t used = 0;
+    try {
+        if (!text.empty() && text[0] != '-') value = std::stoull(text, &used, 10);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.size()) {
+        throw std::runtime_error("'" + text + "' is not a valid number");
+    }
+}
+
+void parseOptionValue(const std::string& text, std::string& value) {
+    value = text;
+}
+
+void applyOptions(const std::vector<CommandOption>& table, void* options, const std::vector<std::string>& args) {
+    for (size_t i = 0; i < args.size(); i += 2) {
+        const CommandOption* match = nullptr;
+        for (const CommandOption& option : table) {
+            if (option.name == args[i]) match = &option;
+        }
+        if (match == nullptr) {
+            throw std::invalid_argument("Unknown option " + args[i]);
+        }
+        if (i + 1 >= args.size()) {
+            throw std::invalid_argument(args[i] + " needs a value (" + match->valueName + ")");
+        }
+        try {
+            match->apply(options, args[i + 1]);
+        } catch (const std::exception& e) {
+            throw std::invalid_argument(args[i] + ": " + e.what());
+        }
+    }
+}
+
+int runSubcommand(const std::vector<Subcommand>& commands, int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: VoxelWorld [SUBCOMMAND [OPTIONS]]" << std::endl;
+            std::cout << "Without a subcommand the application starts." << std::endl << std::endl;
+            for (const Subcommand& command : commands) {
+                printUsage(command);
+            }
+            return EXIT_SUCCESS;
+        }
+        for (const Subcommand& command : commands) {
+            if (command.name != arg) continue;
+            try {
+                return command.run(std::vector<std::string>(argv + i + 1, argv + argc));
+            } catch (const std::invalid_argument& e) {
+                std::cerr << e.what() << std::endl;
+                printUsage(command);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    return -1;
+}
+
+} // namespace vkengine
@@ -144,6 +144,17 @@ bool Config::saveToFile(const std::string& filename) const {
 void Config::initDefaults() {
     // Graphics settings
     setInt("render_distance", 6);
+    setInt("coarse_distance", 24); // chunk columns covered by coarse terrain
+    setInt("coarse_terrain", 1); // heightmap tiles until full chunks arrive (0: off, e.g. to compare startup)
+    setInt("lod_distance", 4); // chunks meshed at full resolution; each doubling of distance halves it (0: off)
+    setInt("occluder_distance", 3); // chunks whose large faces are rasterized for occlusion culling
+    setInt("record_threads", 0); // worker threads recording draw commands (0: main thread only)
+    setInt("gpu_culling_chunks", 32768); // chunks the GPU culling pass has records for
+    setFloat("autosave_interval", 5.0f); // seconds between background saves of edited chunks
+    setInt("autosave_bytes_per_second", 4 * 1024 * 1024); // region write budget while playing
+    setFloat("cold_after_seconds", 10.0f); // out-of-range chunks are compressed after this long
+    setInt("cold_distance", 12); // ...or at once when further than this many chunks
+    setInt("mesh_cache_megabytes", 256); // on-disk mesh cache size before LRU eviction
     setInt("meshing_technique", static_cast<int>(MeshingTechnique::GREEDY)); // 0: Simple, 1: Greedy
     setFloat("player_speed", 30.0f);
     setFloat("fov", 60.0f);
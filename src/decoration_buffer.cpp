@@ -0,0 +1,49 @@
+#include "decoration_buffer.hpp"
+
+namespace vkengine {
+
+DecorationBuffer::Shard& DecorationBuffer::shardFor(const ChunkCoord& coord) {
+    return shards[ChunkCoord::Hash{}(coord) % NUM_SHARDS];
+}
+
+void DecorationBuffer::push(const ChunkCoord& target, const PendingBlock& block) {
+    Shard& shard = shardFor(target);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.writes[target].push_back(block);
+}
+
+std::vector<PendingBlock> DecorationBuffer::take(const ChunkCoord& target) {
+    Shard& shard = shardFor(target);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.writes.find(target);
+    if (it == shard.writes.end()) {
+        return {};
+    }
+    std::vector<PendingBlock> writes = std::move(it->second);
+    shard.writes.erase(it);
+    return writes;
+}
+
+std::vector<ChunkCoord> DecorationBuffer::pendingTargets() {
+    std::vector<ChunkCoord> targets;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [coord, writes] : shard.writes) {
+            targets.push_back(coord);
+        }
+    }
+    return targets;
+}
+
+size_t DecorationBuffer::size() {
+    size_t total = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [coord, writes] : shard.writes) {
+            total += writes.size();
+        }
+    }
+    return total;
+}
+
+} // namespace vkengine
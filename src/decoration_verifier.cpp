@@ -0,0 +1,201 @@
+#include "decoration_verifier.hpp"
+#include "chunk_region.hpp"
+#include "decoration_buffer.hpp"
+#include "region_file.hpp"
+#include "terrain_generator.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace vkengine {
+
+static std::shared_ptr<Chunk> makeChunk(const ChunkCoord& coord) {
+    auto gameObject = GameObject::createGameObject();
+    gameObject->transform.translation = glm::vec3(coord.x, coord.y, coord.z) * static_cast<float>(CHUNK_SIZE);
+    return std::make_shared<Chunk>(gameObject);
+}
+
+static bool isTreeBlock(BlockType type) {
+    return type == BlockType::LEAVES || type == BlockType::WOOD;
+}
+
+static int countTreeBlocks(const Chunk& chunk) {
+    int count = 0;
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                count += isTreeBlock(chunk.getBlock(x, y, z).type);
+            }
+        }
+    }
+    return count;
+}
+
+DecorationVerifier::DecorationVerifier(Options opts) : options{std::move(opts)} {}
+
+bool DecorationVerifier::run() {
+    std::vector<ChunkCoord> coords = regionCoords(options.seed, options.renderDistance);
+    std::cout << "Verifying decorations on saved chunks: seed " << options.seed << ", " << coords.size() << " chunks" << std::endl;
+    std::filesystem::remove_all(options.directory);
+
+    // The world as first played: every chunk generated, then the late writes
+    // flushed the way ChunkManager::flushDecorations does
+    TerrainGenerator generator{options.seed};
+    DecorationBuffer decorations;
+    ChunkMap world;
+    for (const ChunkCoord& coord : coords) {
+        world[coord] = makeChunk(coord);
+        world[coord]->generateTerrain(generator, decorations);
+    }
+    for (const ChunkCoord& target : decorations.pendingTargets()) {
+        auto it = world.find(target);
+        if (it != world.end()) it->second->applyDecorations(decorations.take(target));
+    }
+
+    // A chunk holding part of a neighbour's tree has more tree blocks than it generates alone
+    ChunkCoord target{};
+    int treeBlocks = 0;
+    int overhang = 0;
+    for (const ChunkCoord& coord : coords) {
+        DecorationBuffer own;
+        auto alone = makeChunk(coord);
+        alone->generateTerrain(generator, own);
+        treeBlocks = countTreeBlocks(*world[coord]);
+        overhang = treeBlocks - countTreeBlocks(*alone);
+        if (overhang > 0) {
+            target = coord;
+            break;
+        }
+    }
+    if (overhang <= 0) {
+        std::cout << "  no chunk in range holds a neighbour's tree; try another seed or a larger distance" << std::endl;
+        return false;
+    }
+    std::cout << "  chunk (" << target.x << ", " << target.y << ", " << target.z << "): " << treeBlocks
+              << " tree blocks, " << overhang << " from neighbours" << std::endl;
+
+    // The player clears every tree block, and the chunk is saved
+    std::shared_ptr<Chunk> edited = world[target];
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                if (isTreeBlock(edited->getBlock(x, y, z).type)) edited->setBlock(x, y, z, BlockType::AIR);
+            }
+        }
+    }
+    if (!edited->dirty()) {
+        std::cout << "  clearing the trees did not mark the chunk dirty" << std::endl;
+        return false;
+    }
+    {
+        RegionStore store{options.directory};
+        store.saveChunk(target, edited->serialize());
+        store.sync();
+    }
+
+    // The world reopened: the saved chunk is loaded and its neighbours are
+    // regenerated, which queues their trees' writes into it again
+    bool ok = true;
+    auto reopen = [&](bool neighboursFirst) {
+        TerrainGenerator regenerated{options.seed};
+        DecorationBuffer pending;
+        RegionStore store{options.directory};
+        auto loaded = makeChunk(target);
+
+        auto regenerateNeighbours = [&]() {
+            for (const ChunkCoord& coord : coords) {
+                if (!(coord == target)) makeChunk(coord)->generateTerrain(regenerated, pending);
+            }
+        };
+        // As chunksLoadThread
+        auto load = [&]() {
+            bool found = store.visitChunk(target, [&](std::string_view data) { loaded->loadTerrain(data); });
+            if (found) pending.take(target);
+            return found;
+        };
+
+        bool found;
+        if (neighboursFirst) {
+            regenerateNeighbours();
+            found = load();
+        } else {
+            found = load();
+            regenerateNeighbours();
+        }
+        // As flushDecorations
+        bool applied = loaded->applyDecorations(pending.take(target));
+
+        int regrown = countTreeBlocks(*loaded);
+        std::cout << (neighboursFirst ? "  reloaded, neighbours first: " : "  reloaded, neighbours last:  ") << regrown << " tree blocks" << std::endl;
+        if (!found || !loaded->loadedFromDisk() || applied || regrown != 0 || loaded->dirty()) {
+            if (!found) std::cout << "    the saved chunk was not found" << std::endl;
+            if (applied || regrown != 0) std::cout << "    trees grew back into the saved chunk" << std::endl;
+            if (loaded->dirty()) std::cout << "    the reloaded chunk is dirty" << std::endl;
+            ok = false;
+        }
+    };
+    reopen(true);
+    reopen(false);
+
+    // Control: the same chunk generated instead of loaded still gets the whole overhang
+    {
+        TerrainGenerator regenerated{options.seed};
+        DecorationBuffer pending;
+        auto fresh = makeChunk(target);
+        for (const ChunkCoord& coord : coords) {
+            if (!(coord == target)) makeChunk(coord)->generateTerrain(regenerated, pending);
+        }
+        fresh->generateTerrain(regenerated, pending);
+        fresh->applyDecorations(pending.take(target));
+        int generated = countTreeBlocks(*fresh);
+        std::cout << "  regenerated instead:        " << generated << " tree blocks" << std::endl;
+        if (generated != treeBlocks) {
+            std::cout << "    expected " << treeBlocks << "; decorations no longer reach generated chunks" << std::endl;
+            ok = false;
+        }
+    }
+
+    // Edited and saved before its neighbours generated: their trees reach it
+    // afterwards, and the saved copy must be rewritten to include them
+    {
+        TerrainGenerator regenerated{options.seed};
+        DecorationBuffer pending;
+        auto early = makeChunk(target);
+        early->generateTerrain(regenerated, pending);
+        // An edit that leaves the blocks as they were, away from any tree
+        Block original = early->getBlock(0, 0, 0);
+        early->setBlock(0, 0, 0, original.type == BlockType::STONE ? BlockType::DIRT : BlockType::STONE);
+        early->setBlock(0, 0, 0, original.type);
+        RegionStore store{options.directory};
+        store.saveChunk(target, early->serialize());
+        early->setDirty(false);
+
+        for (const ChunkCoord& coord : coords) {
+            if (!(coord == target)) makeChunk(coord)->generateTerrain(regenerated, pending);
+        }
+        early->applyDecorations(pending.take(target));
+        bool redirtied = early->dirty();
+        if (redirtied) {
+            store.saveChunk(target, early->serialize());
+        }
+        store.sync();
+
+        auto loaded = makeChunk(target);
+        store.visitChunk(target, [&](std::string_view data) { loaded->loadTerrain(data); });
+        int reloaded = countTreeBlocks(*loaded);
+        std::cout << "  edited before neighbours:   " << reloaded << " tree blocks after reload" << std::endl;
+        if (!redirtied || reloaded != treeBlocks) {
+            if (!redirtied) std::cout << "    the overhang did not mark the edited chunk dirty" << std::endl;
+            std::cout << "    expected " << treeBlocks << "; trees are cut at the border of the saved chunk" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::filesystem::remove_all(options.directory);
+    std::cout << (ok ? "Saved chunks keep their edits" : "Decoration verification FAILED") << std::endl;
+    return ok;
+}
+
+} // namespace vkengine
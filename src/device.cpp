@@ -47,7 +47,7 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-Device::Device(Window &window) : window{window} {
+Device::Device(Window &window) : window{&window} {
   createInstance();
   setupDebugMessenger();
   createSurface();
@@ -56,6 +56,14 @@ Device::Device(Window &window) : window{window} {
   createCommandPool();
 }
 
+Device::Device() {
+  createInstance();
+  setupDebugMessenger();
+  pickPhysicalDevice();
+  createLogicalDevice();
+  createCommandPool();
+}
+
 Device::~Device() {
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
@@ -64,7 +72,9 @@ Device::~Device() {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (surface_ != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -101,8 +111,10 @@ void Device::createInstance() {
     createInfo.pNext = nullptr;
   }
 
-  // Manually added to bug fix
-  createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+  // Manually added to bug fix; only there when the loader has the extension
+  if (hasInstanceExtension(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME)) {
+    createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+  }
 
   if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
     throw std::runtime_error("failed to create instance!");
@@ -155,6 +167,28 @@ void Device::createLogicalDevice() {
   deviceFeatures.samplerAnisotropy = VK_TRUE;
   deviceFeatures.fillModeNonSolid = VK_TRUE; // Enable fillModeNonSolid
 
+  // Without a surface there is nothing to present to
+  std::vector<const char *> enabledExtensions;
+  if (!isHeadless()) {
+    enabledExtensions = deviceExtensions;
+  }
+  // Must be enabled where the implementation has it (MoltenVK); other devices lack it
+  if (hasDeviceExtension(physicalDevice, VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME)) {
+    enabledExtensions.push_back(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME);
+  }
+
+  // GPU culling draws with a count written by a compute pass; optional, so the
+  // device is still used without it
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+  bool drawIndirectCount = hasDeviceExtension(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) &&
+                           supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance;
+  if (drawIndirectCount) {
+    enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    deviceFeatures.multiDrawIndirect = VK_TRUE;
+    deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+  }
+
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
@@ -162,8 +196,8 @@ void Device::createLogicalDevice() {
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -180,6 +214,11 @@ void Device::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+  if (drawIndirectCount) {
+    cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+  }
 }
 
 void Device::createCommandPool() {
@@ -196,15 +235,15 @@ void Device::createCommandPool() {
   }
 }
 
-void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
+void Device::createSurface() { window->createWindowSurface(instance, &surface_); }
 
 bool Device::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
-  bool extensionsSupported = checkDeviceExtensionSupport(device);
+  bool extensionsSupported = isHeadless() || checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  bool swapChainAdequate = isHeadless();
+  if (extensionsSupported && !isHeadless()) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
@@ -264,18 +303,24 @@ bool Device::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> Device::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  // GLFW is never initialised without a window
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
 
-  // Manually added to bug fix
-  extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
+  // Manually added to bug fix. Older loaders, as shipped with some software
+  // drivers, lack portability enumeration; it is only needed on MoltenVK.
+  if (hasInstanceExtension(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME)) {
+    extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
+  }
   extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 
   return extensions;
@@ -321,6 +366,31 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+bool Device::hasInstanceExtension(const char *name) {
+  uint32_t extensionCount = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+  for (const auto &extension : extensions) {
+    if (std::strcmp(extension.extensionName, name) == 0) return true;
+  }
+  return false;
+}
+
+bool Device::hasDeviceExtension(VkPhysicalDevice device, const char *name) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+  for (const auto &extension : availableExtensions) {
+    if (std::strcmp(extension.extensionName, name) == 0) return true;
+  }
+  return false;
+}
+
 QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -337,7 +407,12 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
       indices.graphicsFamilyHasValue = true;
     }
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    if (isHeadless()) {
+      // Nothing is presented; any graphics family will do
+      presentSupport = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+    } else {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    }
     if (queueFamily.queueCount > 0 && presentSupport) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
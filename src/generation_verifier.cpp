@@ -0,0 +1,137 @@
+#include "generation_verifier.hpp"
+#include "terrain_generator.hpp"
+#include "decoration_buffer.hpp"
+#include "hash.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+namespace vkengine {
+
+GenerationVerifier::GenerationVerifier(Options opts) : options{std::move(opts)} {
+    if (options.threadCounts.empty()) {
+        int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        options.threadCounts = {1, 8, hardwareThreads};
+    }
+
+    for (int x = -options.radius; x <= options.radius; ++x) {
+        for (int y = options.minChunkY; y <= options.maxChunkY; ++y) {
+            for (int z = -options.radius; z <= options.radius; ++z) {
+                coords.push_back({x, y, z});
+            }
+        }
+    }
+}
+
+uint64_t GenerationVerifier::hashChunk(const std::array<Block, CHUNK_VOLUME>& blocks) {
+    // Hash the block ids as bytes so the result does not depend on sizeof(BlockType)
+    std::array<uint8_t, CHUNK_VOLUME> ids;
+    for (int i = 0; i < CHUNK_VOLUME; ++i) {
+        ids[i] = static_cast<uint8_t>(blocks[i].type);
+    }
+    return hashBytes(ids.data(), ids.size());
+}
+
+bool GenerationVerifier::isInterior(const ChunkCoord& coord) const {
+    // Border chunks may still be missing decorations rooted outside the region
+    return std::abs(coord.x) < options.radius && std::abs(coord.z) < options.radius &&
+           coord.y > options.minChunkY && coord.y < options.maxChunkY;
+}
+
+GenerationVerifier::RunResult GenerationVerifier::generateRegion(int threadCount) const {
+    TerrainGenerator generator{options.seed};
+    DecorationBuffer decorations;
+    std::vector<std::array<Block, CHUNK_VOLUME>> blocks(coords.size());
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < coords.size(); i = next++) {
+            generator.populateChunk(coords[i], blocks[i], decorations);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    // Same as ChunkManager::flushDecorations: late writes into generated chunks
+    std::unordered_map<ChunkCoord, size_t, ChunkCoord::Hash> indices;
+    for (size_t i = 0; i < coords.size(); ++i) {
+        indices[coords[i]] = i;
+    }
+    for (const ChunkCoord& target : decorations.pendingTargets()) {
+        auto it = indices.find(target);
+        if (it != indices.end()) {
+            applyPendingBlocks(blocks[it->second], decorations.take(target));
+        }
+    }
+
+    RunResult result;
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    for (size_t i = 0; i < coords.size(); ++i) {
+        if (isInterior(coords[i])) {
+            result.hashes.push_back(hashChunk(blocks[i]));
+        }
+    }
+    result.digest = hashBytes(result.hashes.data(), result.hashes.size() * sizeof(uint64_t), options.seed);
+    return result;
+}
+
+bool GenerationVerifier::run() {
+    std::cout << "Verifying world generation: seed " << options.seed << ", " << coords.size() << " chunks" << std::endl;
+
+    bool ok = true;
+    std::vector<ChunkCoord> interior;
+    for (const auto& coord : coords) {
+        if (isInterior(coord)) interior.push_back(coord);
+    }
+
+    RunResult reference;
+    for (size_t run = 0; run < options.threadCounts.size(); ++run) {
+        int threadCount = options.threadCounts[run];
+        RunResult result = generateRegion(threadCount);
+
+        char digest[17];
+        std::snprintf(digest, sizeof(digest), "%016llx", static_cast<unsigned long long>(result.digest));
+        std::cout << "  " << threadCount << " thread(s): " << result.milliseconds << " ms, digest " << digest << std::endl;
+
+        if (run == 0) {
+            reference = std::move(result);
+            if (!options.expectedDigest.empty() && options.expectedDigest != digest) {
+                std::cout << "  digest differs from expected " << options.expectedDigest << std::endl;
+                ok = false;
+            }
+            continue;
+        }
+
+        int mismatches = 0;
+        for (size_t i = 0; i < interior.size(); ++i) {
+            if (result.hashes[i] != reference.hashes[i]) {
+                if (mismatches < 10) {
+                    std::cout << "  chunk (" << interior[i].x << ", " << interior[i].y << ", " << interior[i].z
+                              << ") diverges with " << threadCount << " thread(s)" << std::endl;
+                }
+                ++mismatches;
+            }
+        }
+        if (mismatches > 0) {
+            std::cout << "  " << mismatches << " of " << interior.size() << " chunks diverged" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << (ok ? "World generation is deterministic" : "World generation verification FAILED") << std::endl;
+    return ok;
+}
+
+} // namespace vkengine
@@ -0,0 +1,612 @@
+#include "gpu_culler.hpp"
+#include "camera.hpp"
+#include "chunk.hpp"
+#include "pipeline.hpp"
+#include "swapchain.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace vkengine {
+
+// Starting size of the shared buffers, grown by doubling: about 48 MB of vertices
+static constexpr uint32_t INITIAL_VERTEX_CAPACITY = 1u << 20;
+static constexpr uint32_t INITIAL_INDEX_CAPACITY = 3u << 19;
+static constexpr uint32_t CULL_GROUP_SIZE = 64;   // local_size_x of chunk_cull.comp
+// Real culling passes read back and compared with the CPU before the culler is trusted
+static constexpr int CHECKED_FRAMES = 8;
+
+struct CullPushConstants {
+    glm::vec4 planes[6];
+    glm::vec4 eye;          // w: 1 to skip face buckets that point away from the eye
+    uint32_t recordCount;
+    uint32_t maxDraws;
+    float chunkSize;
+};
+
+// Inward facing planes of the clip volume (depth 0..1): left, right, bottom, top, near, far
+static void frustumPlanes(const glm::mat4& m, glm::vec4 planes[6]) {
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[2];
+    planes[5] = rows[3] - rows[2];
+}
+
+void GpuCuller::RangeAllocator::reset(uint32_t capacity) {
+    freeRanges.clear();
+    if (capacity > 0) {
+        freeRanges[0] = capacity;
+    }
+}
+
+void GpuCuller::RangeAllocator::extend(uint32_t from, uint32_t to) {
+    release(from, to - from);
+}
+
+bool GpuCuller::RangeAllocator::allocate(uint32_t size, uint32_t& offset) {
+    if (size == 0) {
+        offset = 0;
+        return true;
+    }
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+        if (it->second < size) continue;
+        offset = it->first;
+        uint32_t remaining = it->second - size;
+        freeRanges.erase(it);
+        if (remaining > 0) {
+            freeRanges[offset + size] = remaining;
+        }
+        return true;
+    }
+    return false;
+}
+
+void GpuCuller::RangeAllocator::release(uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+    // Merged with the free ranges on either side, so space does not fragment over time
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        next = freeRanges.erase(next);
+    }
+    if (next != freeRanges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+    freeRanges.emplace(offset, size);
+}
+
+GpuCuller::GpuCuller(Device& device, PipelineCache& pipelineCache, uint32_t chunks)
+    : device{device}, checksLeft{CHECKED_FRAMES}, maxChunks{std::max(chunks, 1u)}, maxDraws{std::max(chunks, 1u) * 3} {
+    supported = device.supportsDrawIndirectCount();
+
+    frames.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for (Frame& frame : frames) {
+        // The vertex shaders bind the records even when nothing is culled on the GPU
+        frame.records = std::make_unique<Buffer>(device, sizeof(ChunkRecord), supported ? maxChunks : 1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        frame.records->map();
+    }
+    if (!supported) {
+        std::cout << "GPU culling: unavailable, the device lacks " << VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
+                  << " or multi-draw indirect" << std::endl;
+        return;
+    }
+
+    setLayout = DescriptorSetLayout::Builder(device)
+        .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+        .build();
+    descriptorPool = DescriptorPool::Builder(device)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .build();
+
+    for (Frame& frame : frames) {
+        frame.hidden = std::make_unique<Buffer>(device, sizeof(uint32_t), (maxChunks + 31) / 32,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        frame.hidden->map();
+        frame.draws = std::make_unique<Buffer>(device, sizeof(VkDrawIndexedIndirectCommand), maxDraws,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.counts = std::make_unique<Buffer>(device, sizeof(Counts), 1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.readback = std::make_unique<Buffer>(device, sizeof(Counts), 1,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        frame.readback->map();
+        Counts zero{};
+        frame.readback->writeToBuffer(&zero);
+
+        auto recordsInfo = frame.records->descriptorInfo();
+        auto hiddenInfo = frame.hidden->descriptorInfo();
+        auto drawsInfo = frame.draws->descriptorInfo();
+        auto countsInfo = frame.counts->descriptorInfo();
+        bool built = DescriptorWriter(*setLayout, *descriptorPool)
+            .writeBuffer(0, &recordsInfo)
+            .writeBuffer(1, &hiddenInfo)
+            .writeBuffer(2, &drawsInfo)
+            .writeBuffer(3, &countsInfo)
+            .build(frame.descriptorSet);
+        if (!built) {
+            throw std::runtime_error("Failed to build GPU culling descriptor set");
+        }
+    }
+
+    createPipeline(pipelineCache);
+    createGeometryBuffers(INITIAL_VERTEX_CAPACITY, INITIAL_INDEX_CAPACITY);
+    vertexRanges.reset(vertexCapacity);
+    indexRanges.reset(indexCapacity);
+
+    if (selfTest()) {
+        std::cout << "GPU culling: self-test passed" << std::endl;
+    }
+}
+
+GpuCuller::~GpuCuller() {
+    vkDestroyPipeline(device.device(), pipeline, nullptr);
+    vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+}
+
+void GpuCuller::disable(const std::string& reason) {
+    clear();
+    supported = false;
+    culling = false;
+    lastCounts = {};
+    std::cout << "GPU culling: disabled, " << reason << "; chunks are drawn on the CPU" << std::endl;
+}
+
+bool GpuCuller::selfTest() {
+    // A block of chunks around the camera with uneven, partly empty face buckets,
+    // so frustum, face and hidden-mask culling and the merging of buckets all count
+    const int side = 6;
+    uint32_t recordCount = std::min<uint32_t>(maxChunks, side * side * 2);
+    records.assign(recordCount, ChunkRecord{});
+    for (uint32_t i = 0; i < recordCount; ++i) {
+        ChunkRecord& record = records[i];
+        int x = static_cast<int>(i % side) - side / 2;
+        int z = static_cast<int>(i / side % side) - side / 2;
+        int y = static_cast<int>(i / (side * side)) - 1;
+        record.origin = glm::ivec4(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE, i % 7 == 6 ? 0 : 1);
+        uint32_t offset = i * 64;
+        for (uint32_t face = 0; face < 7; ++face) {
+            record.faceOffsets[face] = offset;
+            offset += ((face + i) % 4) * 3;
+        }
+        record.vertexOffset = static_cast<int32_t>(i * 16);
+    }
+    recordsVersion++;
+    // The passes below are compared here, not by beginFrame()
+    checksLeft = 0;
+
+    struct Pass {
+        glm::vec3 eye;
+        glm::vec3 rotation;
+        bool faceCulling;
+        bool hide;
+    };
+    const float chunk = static_cast<float>(CHUNK_SIZE);
+    const Pass passes[] = {
+        {{0.5f * chunk, 0.5f * chunk, 0.5f * chunk}, {0.0f, 0.0f, 0.0f}, false, false},
+        {{0.5f * chunk, 0.5f * chunk, 0.5f * chunk}, {0.0f, glm::radians(135.0f), 0.0f}, true, false},
+        {{0.3f * chunk, -0.7f * chunk, 0.2f * chunk}, {glm::radians(-50.0f), glm::radians(30.0f), 0.0f}, true, true},
+    };
+    std::string failure;
+    bool anyDrawn = false;
+    for (const Pass& pass : passes) {
+        Camera camera;
+        camera.setViewYXZ(pass.eye, pass.rotation);
+        camera.setPerspectiveProjection(glm::radians(50.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        glm::mat4 viewProjection = camera.getProjection() * camera.getView();
+
+        beginFrame(0);
+        if (pass.hide) {
+            for (uint32_t i = 0; i < recordCount; i += 3) hiddenWords[i / 32] |= 1u << (i % 32);
+        }
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        cull(commandBuffer, viewProjection, pass.eye, pass.faceCulling);
+        device.endSingleTimeCommands(commandBuffer);
+
+        Counts gpu = readCounts(0);
+        Counts cpu = countOnCpu(viewProjection, pass.eye, pass.faceCulling);
+        anyDrawn = anyDrawn || cpu.draws > 0;
+        if (gpu.draws != cpu.draws || gpu.indices != cpu.indices) {
+            failure = "the self-test culled " + std::to_string(gpu.draws) + " draws (" + std::to_string(gpu.indices) +
+                      " indices) where the CPU counts " + std::to_string(cpu.draws) + " (" + std::to_string(cpu.indices) + ")";
+            break;
+        }
+    }
+    if (failure.empty() && !anyDrawn) {
+        failure = "the self-test cameras saw no chunk";
+    }
+
+    // Leave nothing of the test behind for the first real frame
+    Counts zero{};
+    frames[0].readback->writeToBuffer(&zero);
+    clear();
+    culling = false;
+    lastCounts = {};
+    checksLeft = CHECKED_FRAMES;
+    if (!failure.empty()) {
+        disable(failure);
+        return false;
+    }
+    return true;
+}
+
+void GpuCuller::createPipeline(PipelineCache& pipelineCache) {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CullPushConstants);
+
+    VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create GPU culling pipeline layout");
+    }
+
+    std::vector<char> code = Pipeline::readFile("shaders/chunk_cull.comp.spv");
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = code.size();
+    moduleInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(device.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create shader module");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+    VkResult result = vkCreateComputePipelines(device.device(), pipelineCache.getCache(), 1, &pipelineInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(device.device(), shaderModule, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create GPU culling pipeline");
+    }
+    pipelineCache.markDirty();
+}
+
+void GpuCuller::createGeometryBuffers(uint32_t vertices, uint32_t indices) {
+    vertexBuffer = std::make_unique<Buffer>(device, sizeof(Model::Vertex), vertices,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    indexBuffer = std::make_unique<Buffer>(device, sizeof(uint32_t), indices,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vertexCapacity = vertices;
+    indexCapacity = indices;
+}
+
+void GpuCuller::growGeometry(uint32_t vertices, uint32_t indices) {
+    uint32_t oldVertexCapacity = vertexCapacity;
+    uint32_t oldIndexCapacity = indexCapacity;
+    uint32_t newVertexCapacity = vertices > 0 ? std::max(vertexCapacity * 2, vertexCapacity + vertices) : vertexCapacity;
+    uint32_t newIndexCapacity = indices > 0 ? std::max(indexCapacity * 2, indexCapacity + indices) : indexCapacity;
+
+    // Frames in flight still draw from the old buffers
+    vkDeviceWaitIdle(device.device());
+    std::unique_ptr<Buffer> oldVertices = std::move(vertexBuffer);
+    std::unique_ptr<Buffer> oldIndices = std::move(indexBuffer);
+    createGeometryBuffers(newVertexCapacity, newIndexCapacity);
+
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+    VkBufferCopy vertexRegion{0, 0, static_cast<VkDeviceSize>(oldVertexCapacity) * sizeof(Model::Vertex)};
+    vkCmdCopyBuffer(commandBuffer, oldVertices->getBuffer(), vertexBuffer->getBuffer(), 1, &vertexRegion);
+    VkBufferCopy indexRegion{0, 0, static_cast<VkDeviceSize>(oldIndexCapacity) * sizeof(uint32_t)};
+    vkCmdCopyBuffer(commandBuffer, oldIndices->getBuffer(), indexBuffer->getBuffer(), 1, &indexRegion);
+    device.endSingleTimeCommands(commandBuffer);
+
+    vertexRanges.extend(oldVertexCapacity, newVertexCapacity);
+    indexRanges.extend(oldIndexCapacity, newIndexCapacity);
+    std::cout << "GPU culling: chunk geometry grown to " << (getGeometryBytes() >> 20) << " MB" << std::endl;
+}
+
+VkDeviceSize GpuCuller::getGeometryBytes() const {
+    return static_cast<VkDeviceSize>(vertexCapacity) * sizeof(Model::Vertex) + static_cast<VkDeviceSize>(indexCapacity) * sizeof(uint32_t);
+}
+
+VkDescriptorBufferInfo GpuCuller::getRecordsInfo(int index) {
+    return frames[index].records->descriptorInfo();
+}
+
+GpuCuller::Mesh* GpuCuller::acquireMesh(const std::shared_ptr<Model>& model, std::vector<PendingCopy>& copies) {
+    auto existing = meshes.find(model.get());
+    if (existing != meshes.end()) {
+        existing->second.users++;
+        return &existing->second;
+    }
+
+    uint32_t vertices = static_cast<uint32_t>(model->getVertexCount());
+    uint32_t indices = static_cast<uint32_t>(model->getIndexCount());
+    Mesh mesh{model, 0, 0, 1};
+    if (!vertexRanges.allocate(vertices, mesh.firstVertex)) {
+        growGeometry(vertices, 0);
+        vertexRanges.allocate(vertices, mesh.firstVertex);
+    }
+    if (!indexRanges.allocate(indices, mesh.firstIndex)) {
+        growGeometry(0, indices);
+        indexRanges.allocate(indices, mesh.firstIndex);
+    }
+    copies.push_back({model.get(), mesh.firstVertex, mesh.firstIndex});
+    return &meshes.emplace(model.get(), std::move(mesh)).first->second;
+}
+
+void GpuCuller::releaseMesh(const Model* model) {
+    auto it = meshes.find(model);
+    if (it == meshes.end() || --it->second.users > 0) return;
+    vertexRanges.release(it->second.firstVertex, static_cast<uint32_t>(model->getVertexCount()));
+    indexRanges.release(it->second.firstIndex, static_cast<uint32_t>(model->getIndexCount()));
+    meshes.erase(it);
+}
+
+void GpuCuller::writeRecord(uint32_t record, const GameObject& object, const Mesh& mesh) {
+    // The same origin a chunk draw pushes in SimpleRenderSystem
+    ChunkRecord& entry = records[record];
+    entry.origin = glm::ivec4(glm::ivec3(object.transform.translation), 1);
+    const std::vector<uint32_t>& groups = mesh.model->getGroupOffsets();
+    for (int i = 0; i < 7; ++i) {
+        entry.faceOffsets[i] = mesh.firstIndex + groups[i];
+    }
+    entry.vertexOffset = static_cast<int32_t>(mesh.firstVertex);
+}
+
+void GpuCuller::submitCopies(const std::vector<PendingCopy>& copies) {
+    if (copies.empty()) return;
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+
+    // Space released this update may still be read by frames in flight
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    for (const PendingCopy& copy : copies) {
+        VkBufferCopy vertexRegion{0, static_cast<VkDeviceSize>(copy.firstVertex) * sizeof(Model::Vertex),
+                                  static_cast<VkDeviceSize>(copy.model->getVertexCount()) * sizeof(Model::Vertex)};
+        vkCmdCopyBuffer(commandBuffer, copy.model->getVertexBuffer(), vertexBuffer->getBuffer(), 1, &vertexRegion);
+        if (copy.model->getIndexCount() > 0) {
+            VkBufferCopy indexRegion{0, static_cast<VkDeviceSize>(copy.firstIndex) * sizeof(uint32_t),
+                                     static_cast<VkDeviceSize>(copy.model->getIndexCount()) * sizeof(uint32_t)};
+            vkCmdCopyBuffer(commandBuffer, copy.model->getIndexBuffer(), indexBuffer->getBuffer(), 1, &indexRegion);
+        }
+    }
+    device.endSingleTimeCommands(commandBuffer);
+}
+
+void GpuCuller::updateChunks(const GameObject::Map& gameObjects, uint64_t generation) {
+    if (!supported || generation == mirroredGeneration) return;
+    mirroredGeneration = generation;
+    overflowed = false;
+
+    // Chunks that are gone or have another model go first, so their space is reused
+    for (auto it = slots.begin(); it != slots.end();) {
+        auto object = gameObjects.find(it->first);
+        if (object != gameObjects.end() && object->second->model.get() == it->second.mesh) {
+            ++it;
+            continue;
+        }
+        records[it->second.record] = ChunkRecord{};
+        freeRecords.push_back(it->second.record);
+        totalIndices -= it->second.mesh->getIndexCount();
+        releaseMesh(it->second.mesh);
+        it = slots.erase(it);
+    }
+
+    std::vector<PendingCopy> copies;
+    for (const auto& [objectId, object] : gameObjects) {
+        const std::shared_ptr<Model>& model = object->model;
+        if (!model || model->getGroupCount() != 6 || slots.count(objectId) > 0) continue;
+
+        uint32_t record;
+        if (!freeRecords.empty()) {
+            record = freeRecords.back();
+            freeRecords.pop_back();
+        } else if (records.size() < maxChunks) {
+            record = static_cast<uint32_t>(records.size());
+            records.emplace_back();
+        } else {
+            overflowed = true;
+            break;
+        }
+        Mesh* mesh = acquireMesh(model, copies);
+        writeRecord(record, *object, *mesh);
+        slots[objectId] = {record, model.get()};
+        totalIndices += model->getIndexCount();
+    }
+    submitCopies(copies);
+    recordsVersion++;
+
+    if (overflowed) {
+        std::cout << "GPU culling: more than " << maxChunks << " chunks, drawing them on the CPU instead" << std::endl;
+    }
+}
+
+void GpuCuller::clear() {
+    slots.clear();
+    meshes.clear();
+    records.clear();
+    freeRecords.clear();
+    hiddenWords.clear();
+    totalIndices = 0;
+    vertexRanges.reset(vertexCapacity);
+    indexRanges.reset(indexCapacity);
+    recordsVersion++;
+    mirroredGeneration = UINT64_MAX;
+    overflowed = false;
+}
+
+void GpuCuller::beginFrame(int index) {
+    frameIndex = index;
+    culling = false;
+    if (!supported) return;
+
+    Frame& frame = frames[frameIndex];
+    lastCounts = readCounts(frameIndex);
+    if (frame.checkPending) {
+        frame.checkPending = false;
+        if (lastCounts.draws != frame.expected.draws || lastCounts.indices != frame.expected.indices) {
+            disable("a frame culled " + std::to_string(lastCounts.draws) + " draws where the CPU counts " +
+                    std::to_string(frame.expected.draws));
+            return;
+        }
+    }
+    if (frame.recordsVersion != recordsVersion) {
+        if (!records.empty()) {
+            frame.records->writeToBuffer(records.data(), records.size() * sizeof(ChunkRecord));
+        }
+        frame.recordsVersion = recordsVersion;
+    }
+    hiddenWords.assign((records.size() + 31) / 32, 0);
+}
+
+void GpuCuller::hide(GameObject::id_t objectId) {
+    auto it = slots.find(objectId);
+    if (it == slots.end()) return;
+    uint32_t record = it->second.record;
+    if (record / 32 < hiddenWords.size()) {
+        hiddenWords[record / 32] |= 1u << (record % 32);
+    }
+}
+
+void GpuCuller::cull(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection, const glm::vec3& eye, bool faceCulling) {
+    if (!isActive()) return;
+    Frame& frame = frames[frameIndex];
+    if (!hiddenWords.empty()) {
+        frame.hidden->writeToBuffer(hiddenWords.data(), hiddenWords.size() * sizeof(uint32_t));
+    }
+
+    vkCmdFillBuffer(commandBuffer, frame.counts->getBuffer(), 0, sizeof(Counts), 0);
+
+    // The cleared counts, and geometry copied in by updateChunks(), before the pass and the draws read them
+    VkMemoryBarrier cleared{};
+    cleared.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cleared.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    cleared.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         0, 1, &cleared, 0, nullptr, 0, nullptr);
+
+    CullPushConstants push{};
+    frustumPlanes(viewProjection, push.planes);
+    push.eye = glm::vec4(eye, faceCulling ? 1.0f : 0.0f);
+    push.recordCount = static_cast<uint32_t>(records.size());
+    push.maxDraws = maxDraws;
+    push.chunkSize = static_cast<float>(CHUNK_SIZE);
+
+    if (push.recordCount > 0) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &push);
+        vkCmdDispatch(commandBuffer, (push.recordCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    }
+
+    VkMemoryBarrier written{};
+    written.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    written.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    written.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &written, 0, nullptr, 0, nullptr);
+
+    // Read on the CPU when this frame's buffers come round again
+    VkBufferCopy region{0, 0, sizeof(Counts)};
+    vkCmdCopyBuffer(commandBuffer, frame.counts->getBuffer(), frame.readback->getBuffer(), 1, &region);
+    VkMemoryBarrier copied{};
+    copied.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    copied.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    copied.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &copied, 0, nullptr, 0, nullptr);
+
+    // Checked against the readback when this frame's buffers come round again
+    if (checksLeft > 0 && !records.empty()) {
+        checksLeft--;
+        frame.expected = countOnCpu(viewProjection, eye, faceCulling);
+        frame.checkPending = true;
+    }
+    culling = true;
+}
+
+void GpuCuller::draw(VkCommandBuffer commandBuffer) {
+    if (!culling) return;
+    Frame& frame = frames[frameIndex];
+    VkBuffer buffers[] = {vertexBuffer->getBuffer()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    device.cmdDrawIndexedIndirectCount(commandBuffer, frame.draws->getBuffer(), 0, frame.counts->getBuffer(), 0, maxDraws,
+                                       sizeof(VkDrawIndexedIndirectCommand));
+}
+
+GpuCuller::Counts GpuCuller::readCounts(int index) const {
+    Counts counts{};
+    if (!supported) return counts;
+    std::memcpy(&counts, frames[index].readback->getMappedMemory(), sizeof(Counts));
+    return counts;
+}
+
+GpuCuller::Counts GpuCuller::countOnCpu(const glm::mat4& viewProjection, const glm::vec3& eye, bool faceCulling) const {
+    glm::vec4 planes[6];
+    frustumPlanes(viewProjection, planes);
+
+    Counts counts{};
+    for (uint32_t index = 0; index < records.size(); ++index) {
+        const ChunkRecord& record = records[index];
+        if (record.origin.w == 0) continue;
+        if (index / 32 < hiddenWords.size() && (hiddenWords[index / 32] & (1u << (index % 32)))) continue;
+
+        glm::vec3 boxMin = glm::vec3(record.origin);
+        glm::vec3 boxMax = boxMin + glm::vec3(static_cast<float>(CHUNK_SIZE));
+        bool inside = true;
+        for (const glm::vec4& plane : planes) {
+            glm::vec3 corner{plane.x >= 0.0f ? boxMax.x : boxMin.x, plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                             plane.z >= 0.0f ? boxMax.z : boxMin.z};
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+                inside = false;
+                break;
+            }
+        }
+        if (!inside) continue;
+
+        uint32_t faces = faceCulling ? frontFacingFaces(eye, boxMin, boxMax) : 0x3F;
+        for (uint32_t face = 0; face < 6;) {
+            if (!(faces & (1u << face))) {
+                face++;
+                continue;
+            }
+            uint32_t first = record.faceOffsets[face];
+            while (face < 6 && (faces & (1u << face))) {
+                face++;
+            }
+            uint32_t count = record.faceOffsets[face] - first;
+            if (count == 0) continue;
+            if (counts.draws++ < maxDraws) {
+                counts.indices += count;
+            }
+        }
+    }
+    return counts;
+}
+
+} // namespace vkengine
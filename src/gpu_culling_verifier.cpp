@@ -0,0 +1,141 @@
+#include "gpu_culling_verifier.hpp"
+#include "camera.hpp"
+#include "chunk_region.hpp"
+#include "device.hpp"
+#include "gpu_culler.hpp"
+#include "pipeline_cache.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vkengine {
+
+static bool isSolid(const ChunkMap& chunks, int x, int y, int z) {
+    ChunkCoord coord{floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE)};
+    auto it = chunks.find(coord);
+    if (it == chunks.end()) return false;
+    return it->second->getBlock(x - coord.x * CHUNK_SIZE, y - coord.y * CHUNK_SIZE, z - coord.z * CHUNK_SIZE).type != BlockType::AIR;
+}
+
+GpuCullingVerifier::GpuCullingVerifier(Options opts) : options{opts} {}
+
+bool GpuCullingVerifier::run() {
+    // Nothing is shown, so no window is needed
+    Device device{};
+    PipelineCache pipelineCache{device, "data/pipeline_cache.bin"};
+    // Room for every chunk in range, so the culler never falls back to the CPU
+    int distance = options.renderDistance;
+    int verticalRange = distance / 2 + 1;
+    uint32_t capacity = static_cast<uint32_t>((2 * distance + 1) * (2 * distance + 1) * (2 * verticalRange + 1));
+    GpuCuller culler{device, pipelineCache, capacity};
+    if (!culler.isSupported()) {
+        std::cout << "GPU culling verification: the device cannot cull on the GPU, or the culler failed its self-test" << std::endl;
+        return false;
+    }
+
+    ChunkMap chunks = buildRegion(options.seed, distance, &device);
+    GameObject::Map gameObjects;
+    for (auto& [coord, chunk] : chunks) {
+        chunk->generateGreedyMesh();
+        chunk->updateGameObject();
+        if (chunk->getGameObject()->model) {
+            gameObjects[chunk->getGameObject()->getId()] = chunk->getGameObject();
+        }
+    }
+    culler.updateChunks(gameObjects, 1);
+    std::cout << "GPU culling verification: render distance " << distance << ", " << culler.getChunkCount() << " chunks, "
+              << culler.getMeshCount() << " meshes, " << culler.getTotalIndexCount() / 3 << " triangles" << std::endl;
+
+    // Cameras at fixed columns, on the ground and above the hills, looking level in
+    // four directions and down at the terrain (up is -y)
+    struct Scene {
+        glm::vec3 eye;
+        glm::vec3 rotation;
+        std::string name;
+    };
+    static const int columns[][2] = {{8, 8}, {40, -24}, {-56, 40}};
+    static const int heights[] = {2, 24};
+    static const int yawDegrees[] = {0, 90, 180, 270};
+    std::vector<Scene> scenes;
+    for (const auto& column : columns) {
+        int surface = distance * CHUNK_SIZE;
+        for (int y = -distance * CHUNK_SIZE; y < distance * CHUNK_SIZE; ++y) {
+            if (isSolid(chunks, column[0], y, column[1])) {
+                surface = y;
+                break;
+            }
+        }
+        for (int height : heights) {
+            glm::vec3 eye{column[0] + 0.5f, static_cast<float>(surface - height), column[1] + 0.5f};
+            for (int yaw : yawDegrees) {
+                char name[48];
+                std::snprintf(name, sizeof(name), "(%d,%d)+%d yaw %d", column[0], column[1], height, yaw);
+                scenes.push_back({eye, {0.0f, glm::radians(static_cast<float>(yaw)), 0.0f}, name});
+            }
+            char name[48];
+            std::snprintf(name, sizeof(name), "(%d,%d)+%d down", column[0], column[1], height);
+            scenes.push_back({eye, {glm::radians(-60.0f), 0.0f, 0.0f}, name});
+        }
+    }
+
+    // Every fourth chunk stands in for what the visibility search would hide
+    std::vector<GameObject::id_t> hiddenObjects;
+    size_t objectIndex = 0;
+    for (const auto& [objectId, object] : gameObjects) {
+        if (objectIndex++ % 4 == 0) hiddenObjects.push_back(objectId);
+    }
+
+    struct Variant {
+        const char* name;
+        bool faceCulling;
+        bool hide;
+    };
+    static const Variant variants[] = {{"frustum", false, false}, {"faces", true, false}, {"hidden", true, true}};
+
+    size_t mismatches = 0;
+    size_t drawnScenes = 0;
+    std::printf("  %-22s %-8s %9s %9s %11s %11s\n", "camera", "variant", "gpu draws", "cpu draws", "gpu indices", "cpu indices");
+    for (const Scene& scene : scenes) {
+        Camera camera;
+        camera.setViewYXZ(scene.eye, scene.rotation);
+        camera.setPerspectiveProjection(glm::radians(50.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        glm::mat4 viewProjection = camera.getProjection() * camera.getView();
+
+        for (const Variant& variant : variants) {
+            culler.beginFrame(0);
+            if (variant.hide) {
+                for (GameObject::id_t objectId : hiddenObjects) culler.hide(objectId);
+            }
+            VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+            culler.cull(commandBuffer, viewProjection, scene.eye, variant.faceCulling);
+            device.endSingleTimeCommands(commandBuffer);
+
+            GpuCuller::Counts gpu = culler.readCounts(0);
+            GpuCuller::Counts cpu = culler.countOnCpu(viewProjection, scene.eye, variant.faceCulling);
+            bool match = gpu.draws == cpu.draws && gpu.indices == cpu.indices;
+            std::printf("  %-22s %-8s %9u %9u %11u %11u%s\n", scene.name.c_str(), variant.name, gpu.draws, cpu.draws,
+                        gpu.indices, cpu.indices, match ? "" : "  MISMATCH");
+            if (!match) mismatches++;
+            if (cpu.draws > 0) drawnScenes++;
+        }
+    }
+
+    if (mismatches > 0) {
+        std::cout << "  MISMATCH: " << mismatches << " culling passes disagree with the CPU" << std::endl;
+        return false;
+    }
+    if (drawnScenes == 0) {
+        std::cout << "  MISMATCH: no camera saw any chunk" << std::endl;
+        return false;
+    }
+    std::cout << "  all " << scenes.size() * std::size(variants) << " culling passes match the CPU" << std::endl;
+    return true;
+}
+
+} // namespace vkengine
@@ -0,0 +1,126 @@
+#include "gpu_profiler.hpp"
+#include "swapchain.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace vkengine {
+
+GpuProfiler::GpuProfiler(Device& device) : device{device} {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, families.data());
+    uint32_t graphicsFamily = device.getGraphicsQueueFamily();
+    uint32_t validBits = graphicsFamily < familyCount ? families[graphicsFamily].timestampValidBits : 0;
+
+    timestampPeriod = device.properties.limits.timestampPeriod;
+    supported = validBits > 0 && timestampPeriod > 0.0f;
+    if (!supported) {
+        std::cout << "GPU timestamps not supported, GPU profiling is off" << std::endl;
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    frames.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for (Frame& frame : frames) {
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = MAX_SCOPES * 2;
+        if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &frame.pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create timestamp query pool");
+        }
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (Frame& frame : frames) {
+        vkDestroyQueryPool(device.device(), frame.pool, nullptr);
+    }
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frame) {
+    if (!supported) return;
+    // The renderer has waited for this frame's fence, so its queries are available
+    collect(frame);
+    frameIndex = frame;
+    Frame& current = frames[frameIndex];
+    vkCmdResetQueryPool(commandBuffer, current.pool, 0, MAX_SCOPES * 2);
+}
+
+void GpuProfiler::collect(int frame) {
+    if (!supported) return;
+    Frame& current = frames[frame];
+    uint32_t complete = current.begun & current.ended;
+    for (uint32_t scope = 0; complete != 0; ++scope, complete >>= 1) {
+        if ((complete & 1u) == 0) continue;
+        uint64_t ticks[2];
+        VkResult result = vkGetQueryPoolResults(device.device(), current.pool, scope * 2, 2, sizeof(ticks), ticks,
+                                                sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS) continue;
+        // Masked so a counter that wrapped between the two still gives the right span
+        uint64_t elapsed = (ticks[1] - ticks[0]) & timestampMask;
+        addSample(static_cast<int>(scope), static_cast<float>(elapsed * static_cast<double>(timestampPeriod) / 1e6));
+    }
+    // Collected once; the scopes are written again after the next reset
+    current.begun = 0;
+    current.ended = 0;
+}
+
+void GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name) {
+    if (!supported) return;
+    int scope = scopeIndex(name);
+    if (scope < 0) return;
+    Frame& current = frames[frameIndex];
+    uint32_t bit = 1u << scope;
+    if (current.begun & bit) return;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, current.pool, scope * 2);
+    current.begun |= bit;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, const std::string& name) {
+    if (!supported) return;
+    int scope = scopeIndex(name);
+    if (scope < 0) return;
+    Frame& current = frames[frameIndex];
+    uint32_t bit = 1u << scope;
+    if (!(current.begun & bit) || (current.ended & bit)) return;
+    // Written once every earlier command has finished all of its stages
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, current.pool, scope * 2 + 1);
+    current.ended |= bit;
+}
+
+int GpuProfiler::scopeIndex(const std::string& name) {
+    for (size_t i = 0; i < scopes.size(); ++i) {
+        if (scopes[i].name == name) return static_cast<int>(i);
+    }
+    if (scopes.size() >= MAX_SCOPES) return -1;
+    scopes.push_back(Scope{name});
+    histories.emplace_back();
+    return static_cast<int>(scopes.size() - 1);
+}
+
+void GpuProfiler::addSample(int index, float milliseconds) {
+    Scope& scope = scopes[index];
+    History& history = histories[index];
+    history.samples[history.next] = milliseconds;
+    history.next = (history.next + 1) % HISTORY;
+    scope.sampleCount = std::min(scope.sampleCount + 1, HISTORY);
+    scope.lastMilliseconds = milliseconds;
+
+    // The window is at most HISTORY floats, so it is simply walked again
+    float sum = 0.0f;
+    scope.minMilliseconds = milliseconds;
+    scope.maxMilliseconds = milliseconds;
+    for (size_t i = 0; i < scope.sampleCount; ++i) {
+        float sample = history.samples[i];
+        sum += sample;
+        scope.minMilliseconds = std::min(scope.minMilliseconds, sample);
+        scope.maxMilliseconds = std::max(scope.maxMilliseconds, sample);
+    }
+    scope.averageMilliseconds = sum / static_cast<float>(scope.sampleCount);
+}
+
+} // namespace vkengine
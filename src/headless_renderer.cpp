@@ -0,0 +1,377 @@
+#include "headless_renderer.hpp"
+#include "buffer.hpp"
+#include "camera.hpp"
+#include "chunk_region.hpp"
+#include "config.hpp"
+#include "descriptors.hpp"
+#include "device.hpp"
+#include "frame_info.hpp"
+#include "gpu_culler.hpp"
+#include "gpu_profiler.hpp"
+#include "hash.hpp"
+#include "offscreen_target.hpp"
+#include "pipeline_cache.hpp"
+#include "png_writer.hpp"
+#include "stb_image.h"
+#include "systems/simple_render_system.hpp"
+#include "texture_manager.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <glm/gtc/constants.hpp>
+
+namespace vkengine {
+
+static constexpr float FRAME_SECONDS = 1.0f / 60.0f;
+
+struct Keyframe {
+    float seconds;
+    glm::vec3 position;
+    glm::vec3 rotation;     // radians, as for Camera::setViewYXZ
+};
+
+static bool isSolid(const ChunkMap& chunks, int x, int y, int z) {
+    ChunkCoord coord{floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE)};
+    auto it = chunks.find(coord);
+    if (it == chunks.end()) return false;
+    return it->second->getBlock(x - coord.x * CHUNK_SIZE, y - coord.y * CHUNK_SIZE, z - coord.z * CHUNK_SIZE).type != BlockType::AIR;
+}
+
+static std::vector<Keyframe> loadPath(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open camera path " + path);
+    }
+    std::vector<Keyframe> keyframes;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        std::istringstream fields(line);
+        Keyframe keyframe{};
+        float pitch, yaw;
+        if (!(fields >> keyframe.seconds >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> pitch >> yaw)) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected \"seconds x y z pitch yaw\"");
+        }
+        if (!keyframes.empty() && keyframe.seconds < keyframes.back().seconds) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": keyframes must be in time order");
+        }
+        keyframe.rotation = {glm::radians(pitch), glm::radians(yaw), 0.0f};
+        keyframes.push_back(keyframe);
+    }
+    return keyframes;
+}
+
+// Once around the region in four seconds, above the terrain at the centre and
+// looking slightly down at it (up is -y)
+static std::vector<Keyframe> defaultPath(const ChunkMap& chunks, int distance) {
+    int surface = distance * CHUNK_SIZE;
+    for (int y = -distance * CHUNK_SIZE; y < distance * CHUNK_SIZE; ++y) {
+        if (isSolid(chunks, 0, y, 0)) {
+            surface = y;
+            break;
+        }
+    }
+    float radius = distance * CHUNK_SIZE * 0.5f;
+    std::vector<Keyframe> keyframes;
+    const int steps = 16;
+    for (int i = 0; i <= steps; ++i) {
+        float angle = glm::two_pi<float>() * i / steps;
+        glm::vec3 position{radius * std::cos(angle), static_cast<float>(surface - 24), radius * std::sin(angle)};
+        // Yaw keeps growing past 2 pi so interpolation never turns the long way round
+        float yaw = std::atan2(-position.x, -position.z);
+        if (!keyframes.empty()) {
+            float previous = keyframes.back().rotation.y;
+            while (yaw < previous - glm::pi<float>()) yaw += glm::two_pi<float>();
+            while (yaw > previous + glm::pi<float>()) yaw -= glm::two_pi<float>();
+        }
+        keyframes.push_back({4.0f * i / steps, position, {glm::radians(-20.0f), yaw, 0.0f}});
+    }
+    return keyframes;
+}
+
+static Keyframe samplePath(const std::vector<Keyframe>& keyframes, float seconds) {
+    if (seconds <= keyframes.front().seconds) return keyframes.front();
+    for (size_t i = 1; i < keyframes.size(); ++i) {
+        const Keyframe& from = keyframes[i - 1];
+        const Keyframe& to = keyframes[i];
+        if (seconds > to.seconds) continue;
+        float span = to.seconds - from.seconds;
+        float t = span > 0.0f ? (seconds - from.seconds) / span : 1.0f;
+        return {seconds, glm::mix(from.position, to.position, t), glm::mix(from.rotation, to.rotation, t)};
+    }
+    return keyframes.back();
+}
+
+// The clear color as it reads back from the sRGB target
+static std::array<uint8_t, 3> skyPixel() {
+    std::array<uint8_t, 3> pixel{};
+    for (int i = 0; i < 3; ++i) {
+        float linear = OffscreenTarget::SKY_COLOR[i];
+        float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+        pixel[i] = static_cast<uint8_t>(std::lround(encoded * 255.0f));
+    }
+    return pixel;
+}
+
+// Share of the pixels something was drawn over, and whether any were left at the
+// clear color; a channel may be one off where the driver rounds differently
+struct Coverage {
+    float drawn = 0.0f;
+    bool sky = false;
+};
+
+static Coverage measureCoverage(const std::vector<uint8_t>& pixels, const std::array<uint8_t, 3>& sky) {
+    size_t skyPixels = 0;
+    size_t count = pixels.size() / 4;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* pixel = &pixels[i * 4];
+        bool isSky = true;
+        for (int c = 0; c < 3; ++c) {
+            isSky = isSky && std::abs(static_cast<int>(pixel[c]) - static_cast<int>(sky[c])) <= 1;
+        }
+        skyPixels += isSky;
+    }
+    Coverage coverage{};
+    coverage.drawn = count > 0 ? static_cast<float>(count - skyPixels) / count : 0.0f;
+    coverage.sky = skyPixels > 0;
+    return coverage;
+}
+
+// Decodes a written frame and compares it with the pixels it was written from
+static bool pngMatches(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels) {
+    int decodedWidth, decodedHeight, channels;
+    stbi_uc* decoded = stbi_load(path.c_str(), &decodedWidth, &decodedHeight, &channels, STBI_rgb_alpha);
+    if (!decoded) return false;
+    bool same = static_cast<uint32_t>(decodedWidth) == width && static_cast<uint32_t>(decodedHeight) == height &&
+                std::memcmp(decoded, pixels.data(), pixels.size()) == 0;
+    stbi_image_free(decoded);
+    return same;
+}
+
+struct Summary {
+    float average = 0.0f;
+    float min = 0.0f;
+    float max = 0.0f;
+    float p95 = 0.0f;
+};
+
+static Summary summarize(std::vector<float> values) {
+    Summary summary{};
+    if (values.empty()) return summary;
+    std::sort(values.begin(), values.end());
+    float sum = 0.0f;
+    for (float value : values) sum += value;
+    summary.average = sum / values.size();
+    summary.min = values.front();
+    summary.max = values.back();
+    summary.p95 = values[std::min(values.size() - 1, values.size() * 95 / 100)];
+    return summary;
+}
+
+HeadlessRenderer::HeadlessRenderer(Options opts) : options{opts} {
+    options.width = std::max(options.width, 1u);
+    options.height = std::max(options.height, 1u);
+}
+
+bool HeadlessRenderer::run() {
+    Device device{};
+    PipelineCache pipelineCache{device, "data/pipeline_cache.bin"};
+    OffscreenTarget target{device, {options.width, options.height}};
+    GpuProfiler profiler{device};
+
+    int distance = options.renderDistance;
+    ChunkMap chunks = buildRegion(options.seed, distance, &device);
+    GameObject::Map gameObjects;
+    size_t triangles = 0;
+    for (auto& [coord, chunk] : chunks) {
+        chunk->generateGreedyMesh();
+        chunk->updateGameObject();
+        if (chunk->getGameObject()->model) {
+            gameObjects[chunk->getGameObject()->getId()] = chunk->getGameObject();
+            triangles += chunk->getGameObject()->model->getIndexCount() / 3;
+        }
+    }
+
+    std::vector<Keyframe> path = options.pathFile.empty() ? defaultPath(chunks, distance) : loadPath(options.pathFile);
+    if (path.empty()) {
+        std::cout << "Headless render: the camera path has no keyframes" << std::endl;
+        return false;
+    }
+    int frames = options.frames > 0 ? options.frames
+                                     : static_cast<int>(std::floor((path.back().seconds - path.front().seconds) / FRAME_SECONDS)) + 1;
+
+    // Resources as App sets them up, for one frame at a time
+    std::shared_ptr<DescriptorPool> globalPool = DescriptorPool::Builder(device)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1)
+        .setMaxSets(2)
+        .build();
+    auto globalSetLayout = DescriptorSetLayout::Builder(device)
+        .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+        .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+        .build();
+    Buffer uboBuffer{device, sizeof(GlobalUbo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+    uboBuffer.map();
+    // Chunks are drawn one by one here, so the records binding the vertex shaders
+    // declare is never read; it only needs a buffer behind it
+    Buffer records{device, sizeof(GpuCuller::ChunkRecord), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+    VkDescriptorSet globalDescriptorSet;
+    auto bufferInfo = uboBuffer.descriptorInfo();
+    auto recordsInfo = records.descriptorInfo();
+    DescriptorWriter(*globalSetLayout, *globalPool)
+        .writeBuffer(0, &bufferInfo)
+        .writeBuffer(1, &recordsInfo)
+        .build(globalDescriptorSet);
+
+    auto textureManager = std::make_shared<TextureManager>(device);
+    if (static_cast<RenderMode>(config().getInt("render_mode")) == RenderMode::TEXTURE) {
+        textureManager->loadTextures();
+    }
+    SimpleRenderSystem renderSystem{device, target.getRenderPass(), globalSetLayout->getDescriptorSetLayout(), pipelineCache};
+    Camera camera{};
+
+    bool writeFiles = !options.outputDirectory.empty();
+    if (writeFiles) {
+        std::filesystem::create_directories(options.outputDirectory);
+    }
+    int dumpEvery = std::max(options.dumpEvery, 1);
+
+    std::cout << "Headless render: " << options.width << "x" << options.height << ", render distance " << distance << ", "
+              << gameObjects.size() << " chunks, " << triangles << " triangles, " << frames << " frames on "
+              << device.properties.deviceName << std::endl;
+    if (!profiler.isSupported()) {
+        std::cout << "  no GPU timestamps on this device, GPU times are left out" << std::endl;
+    }
+
+    std::vector<float> cpuTimes, gpuTimes, frameTimes;
+    std::vector<uint64_t> frameHashes;
+    std::vector<uint8_t> pixels;
+    const std::array<uint8_t, 3> sky = skyPixel();
+    int framesWithoutTerrain = 0;
+    int framesWithoutSky = 0;
+    int badPngs = 0;
+    std::ostringstream csv;
+    csv << "frame,cpu_ms,gpu_ms,frame_ms,drawn_percent,hash\n";
+    std::printf("  %6s %9s %9s %9s %7s %16s\n", "frame", "cpu ms", "gpu ms", "frame ms", "drawn", "hash");
+    for (int frame = 0; frame < frames; ++frame) {
+        Keyframe pose = samplePath(path, path.front().seconds + frame * FRAME_SECONDS);
+        auto start = std::chrono::steady_clock::now();
+
+        camera.setViewYXZ(pose.position, pose.rotation);
+        camera.setPerspectiveProjection(glm::radians(config().getFloat("fov")), target.getAspectRatio(), 0.1f, 1000.f);
+        GlobalUbo ubo{};
+        ubo.projection = camera.getProjection();
+        ubo.view = camera.getView();
+        uboBuffer.writeToBuffer(&ubo);
+        uboBuffer.flush();
+
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        FrameInfo frameInfo{0, FRAME_SECONDS, commandBuffer, camera, globalDescriptorSet, gameObjects, nullptr, textureManager, globalPool};
+        profiler.beginFrame(commandBuffer, 0);
+        profiler.beginScope(commandBuffer, "frame");
+        target.beginRenderPass(commandBuffer);
+        profiler.beginScope(commandBuffer, "terrain pass");
+        renderSystem.renderGameObjects(frameInfo);
+        profiler.endScope(commandBuffer, "terrain pass");
+        target.endRenderPass(commandBuffer);
+        profiler.endScope(commandBuffer, "frame");
+        float cpuMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // Waits for the queue, so the pixels and timestamps are ready
+        device.endSingleTimeCommands(commandBuffer);
+        float frameMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        profiler.collect(0);
+        float gpuMilliseconds = -1.0f;
+        for (const auto& scope : profiler.getScopes()) {
+            if (scope.name == "frame") gpuMilliseconds = scope.lastMilliseconds;
+        }
+
+        target.readPixels(pixels);
+        uint64_t hash = hashBytes(pixels.data(), pixels.size());
+        frameHashes.push_back(hash);
+        Coverage coverage = measureCoverage(pixels, sky);
+        framesWithoutTerrain += coverage.drawn == 0.0f;
+        framesWithoutSky += !coverage.sky;
+        if (writeFiles && frame % dumpEvery == 0) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%05d.png", frame);
+            std::string file = (std::filesystem::path(options.outputDirectory) / name).string();
+            writePng(file, options.width, options.height, pixels.data());
+            if (!pngMatches(file, options.width, options.height, pixels)) {
+                std::cout << "  " << file << " does not decode to the frame it was written from" << std::endl;
+                badPngs++;
+            }
+        }
+
+        char hashText[17];
+        std::snprintf(hashText, sizeof(hashText), "%016llx", static_cast<unsigned long long>(hash));
+        std::printf("  %6d %9.3f %9.3f %9.3f %6.1f%% %16s\n", frame, cpuMilliseconds, gpuMilliseconds, frameMilliseconds,
+                    coverage.drawn * 100.0f, hashText);
+        csv << frame << "," << cpuMilliseconds << "," << gpuMilliseconds << "," << frameMilliseconds << "," << coverage.drawn * 100.0f
+            << "," << hashText << "\n";
+
+        // The first frame builds the pipelines, so it stays out of the summary
+        if (frame == 0 && frames > 1) continue;
+        cpuTimes.push_back(cpuMilliseconds);
+        if (gpuMilliseconds >= 0.0f) gpuTimes.push_back(gpuMilliseconds);
+        frameTimes.push_back(frameMilliseconds);
+    }
+
+    if (writeFiles) {
+        std::ofstream out(std::filesystem::path(options.outputDirectory) / "timings.csv", std::ios::trunc);
+        out << csv.str();
+    }
+
+    const std::pair<const char*, const std::vector<float>*> rows[] = {{"cpu", &cpuTimes}, {"gpu", &gpuTimes}, {"frame", &frameTimes}};
+    std::printf("  %-6s %9s %9s %9s %9s\n", "ms", "average", "min", "max", "p95");
+    for (const auto& [name, values] : rows) {
+        if (values->empty()) continue;
+        Summary summary = summarize(*values);
+        std::printf("  %-6s %9.3f %9.3f %9.3f %9.3f\n", name, summary.average, summary.min, summary.max, summary.p95);
+    }
+
+    uint64_t digest = hashBytes(frameHashes.data(), frameHashes.size() * sizeof(uint64_t), options.seed);
+    char digestText[17];
+    std::snprintf(digestText, sizeof(digestText), "%016llx", static_cast<unsigned long long>(digest));
+    std::cout << "  digest " << digestText << std::endl;
+
+    // Checks that hold on any driver, unlike the digest: the default path always
+    // sees terrain below the horizon and sky above it and past the region's edge,
+    // and a path of its own must show each at least once
+    bool ok = true;
+    bool everyFrame = options.pathFile.empty();
+    if (everyFrame ? framesWithoutTerrain > 0 : framesWithoutTerrain == frames) {
+        std::cout << "  " << framesWithoutTerrain << " of " << frames << " frames show no terrain" << std::endl;
+        ok = false;
+    }
+    if (everyFrame ? framesWithoutSky > 0 : framesWithoutSky == frames) {
+        std::cout << "  " << framesWithoutSky << " of " << frames << " frames show no sky; the readback or its format is wrong" << std::endl;
+        ok = false;
+    }
+    if (badPngs > 0) {
+        std::cout << "  " << badPngs << " PNGs differ from their frames" << std::endl;
+        ok = false;
+    }
+    if (!options.expectedDigest.empty() && options.expectedDigest != digestText) {
+        std::cout << "  digest differs from expected " << options.expectedDigest << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace vkengine
@@ -14,7 +14,7 @@ namespace vkengine {
 // ok this just initializes imgui using the provided integration files. So in our case we need to
 // initialize the vulkan and glfw imgui implementations, since that's what our engine is built
 // using.
-Imgui::Imgui(Window &window, Device &device, VkRenderPass renderPass, uint32_t imageCount) : device{device} {
+Imgui::Imgui(Window &window, Device &device, VkRenderPass renderPass, uint32_t imageCount, VkPipelineCache pipelineCache) : device{device} {
     VkDescriptorPoolSize pool_sizes[] = {{VK_DESCRIPTOR_TYPE_SAMPLER, 1000},
                                          {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000},
                                          {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000},
@@ -47,7 +47,7 @@ Imgui::Imgui(Window &window, Device &device, VkRenderPass renderPass, uint32_t i
     init_info.Device = device.device();
     init_info.QueueFamily = device.getGraphicsQueueFamily();
     init_info.Queue = device.graphicsQueue();
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = pipelineCache;
     init_info.DescriptorPool = descriptorPool;
     init_info.Allocator = VK_NULL_HANDLE;
     init_info.MinImageCount = 2;
@@ -96,7 +96,7 @@ void Imgui::updateMeshStats(FrameInfo& frameInfo) {
     }
 }
 
-void Imgui::showPerformanceTab() {
+void Imgui::showPerformanceTab(const GpuProfiler* gpuProfiler) {
     // Access the global timer data
     const auto& timerData = GlobalTimerData::get();
     
@@ -211,6 +211,52 @@ void Imgui::showPerformanceTab() {
             ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "No timer data available");
         }
     }
+
+    if (gpuProfiler && ImGui::CollapsingHeader("GPU Timers", ImGuiTreeNodeFlags_DefaultOpen)) {
+        if (!gpuProfiler->isSupported()) {
+            ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "GPU timestamps are not supported on this device");
+        } else if (gpuProfiler->getScopes().empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "No GPU timer data available");
+        } else {
+            // The "frame" scope spans the whole command buffer; the rest are shown relative to it
+            float gpuFrame = 0.0f;
+            for (const auto& scope : gpuProfiler->getScopes()) {
+                if (scope.name == "frame") gpuFrame = scope.averageMilliseconds;
+            }
+            float cpuFrame = ImGui::GetIO().Framerate > 0.0f ? 1000.0f / ImGui::GetIO().Framerate : 0.0f;
+            ImGui::Text("Frame interval: %.2f ms, GPU busy %.2f ms (average of %d frames)", cpuFrame, gpuFrame, (int)GpuProfiler::HISTORY);
+            // With the GPU busy for most of the frame interval the GPU is the limit
+            if (cpuFrame > 0.0f && gpuFrame > 0.0f) {
+                ImGui::Text("%s", gpuFrame > 0.9f * cpuFrame ? "Likely GPU-bound" : "Likely CPU-bound");
+            }
+
+            ImGui::BeginTable("GpuTimersTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg);
+            ImGui::TableSetupColumn("GPU Scope", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Average", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("Min", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("Max", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("% of GPU Frame", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableHeadersRow();
+            for (const auto& scope : gpuProfiler->getScopes()) {
+                if (scope.name == "frame") continue;
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(scope.name.c_str());
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.3f ms", scope.averageMilliseconds);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%.3f ms", scope.minMilliseconds);
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%.3f ms", scope.maxMilliseconds);
+                ImGui::TableSetColumnIndex(4);
+                double proportion = gpuFrame > 0.0f ? (scope.averageMilliseconds / gpuFrame) * 100.0 : 0.0;
+                std::stringstream propStream;
+                propStream << std::fixed << std::setprecision(1) << proportion << "%";
+                ImGui::ProgressBar(proportion / 100.0, ImVec2(-1, 0), propStream.str().c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
     
     ImGui::End();
 }
@@ -224,6 +270,9 @@ void Imgui::debugWindow(FrameInfo& frameInfo) {
         static int counter = 0;
         ImGui::Begin("Debug Window");           
         ImGui::Text("%d Game Objects", (int)frameInfo.gameObjects.size());
+        ImGui::Text("%d Chunks, %d skipped as empty", (int)frameInfo.chunkManager->getChunkCount(), (int)frameInfo.chunkManager->getEmptyChunkCount());
+        ImGui::Text("%d cold, blocks %.1f MB, CPU meshes %.1f MB", (int)frameInfo.chunkManager->getColdChunkCount(),
+                    frameInfo.chunkManager->getBlockMemoryUsage() / 1048576.0f, frameInfo.chunkManager->getMeshMemoryUsage() / 1048576.0f);
         ImGui::Text("x: %.2f, y: %.2f, z: %.2f", frameInfo.camera.getPosition().x, frameInfo.camera.getPosition().y, frameInfo.camera.getPosition().z);
         static float speed = config().getFloat("player_speed");
         if (ImGui::SliderFloat("Speed", &speed, 10.0f, 120.0f, "%.1f°")) {
@@ -256,7 +305,7 @@ void Imgui::debugWindow(FrameInfo& frameInfo) {
         }
         ImGui::SameLine();
         if (ImGui::Button("Increase")) {
-            if (renderDistance < 16) {
+            if (renderDistance < 48) {
                 renderDistance++;
                 config().setInt("render_distance", renderDistance);
             }
@@ -283,7 +332,27 @@ void Imgui::debugWindow(FrameInfo& frameInfo) {
         if (ImGui::Combo("##RenderTechnique", &currentRenderMethod, renderMethods, IM_ARRAYSIZE(renderMethods))) {
             config().setInt("render_mode", currentRenderMethod);
         }
+
+        // Chunks beyond this many are meshed at half resolution, then a quarter, then an eighth
+        static int lodDistance = config().getInt("lod_distance");
+        ImGui::Text("LOD Distance (0: off)");
+        if (ImGui::SliderInt("##LodDistance", &lodDistance, 0, 16)) {
+            config().setInt("lod_distance", lodDistance);
+        }
         
+        // Draw commands split across worker threads, each into its own secondary command buffer
+        if (frameInfo.recorder) {
+            static int recordThreads = config().getInt("record_threads");
+            ImGui::Text("Recording Threads (0: main thread; %.2f ms)", frameInfo.recorder->getRecordMilliseconds());
+            if (ImGui::SliderInt("##RecordThreads", &recordThreads, 0, frameInfo.recorder->getMaxThreadCount())) {
+                config().setInt("record_threads", recordThreads);
+            }
+            const std::vector<float>& threadMilliseconds = frameInfo.recorder->getThreadMilliseconds();
+            for (size_t i = 0; i < threadMilliseconds.size(); ++i) {
+                ImGui::Text("  thread %d: %.2f ms", (int)i, threadMilliseconds[i]);
+            }
+        }
+
         ImGui::Text("Statistics");
         ImGui::Text("Vertices: %d", numVertices);
         ImGui::Text("Indices: %d", numIndices);
@@ -294,18 +363,16 @@ void Imgui::debugWindow(FrameInfo& frameInfo) {
     }
     {
         ImGui::Begin("World");
+        static std::string lastSaveMessage;
         if (ImGui::Button("Save World")) {
-            // Save world logic here
-            std::string worldData = frameInfo.chunkManager->serialize();
-            std::ofstream outFile("./data/world_data.txt");
-            if (outFile.is_open()) {
-                outFile << worldData;
-                outFile.close();
-                ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "World saved successfully!");
-            } else {
-                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Failed to save world.");
-            }
+            // Edited chunks are written by the autosave thread; this only skips the wait
+            frameInfo.chunkManager->requestSave();
+            lastSaveMessage = "Save requested";
         }
+        ImGui::Text("Last autosave: %d chunks, %d KB, %.1f ms",
+                    (int)frameInfo.chunkManager->getLastSaveChunks(),
+                    (int)(frameInfo.chunkManager->getLastSaveBytes() / 1024),
+                    frameInfo.chunkManager->getLastSaveMilliseconds());
         static const char* generateChunks[] = { "False", "True"};
         static int generateChunksCurrent = frameInfo.chunkManager->flags & ChunkManagerFlags::GENERATE_CHUNKS;
         ImGui::Text("Generating Chunks");
@@ -318,24 +385,117 @@ void Imgui::debugWindow(FrameInfo& frameInfo) {
             }
         }
 
-        if (ImGui::Button("Load Map")) {
-            // Load world logic here
-            std::ifstream inFile("./data/world_data.txt");
-            if (inFile.is_open()) {
-                std::string worldData((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
-                frameInfo.chunkManager->deserialize(worldData);
-                inFile.close();
-                ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "World loaded successfully!");
+        static int coarseTerrainCurrent = (frameInfo.chunkManager->flags & ChunkManagerFlags::COARSE_TERRAIN) ? 1 : 0;
+        ImGui::Text("Coarse Terrain (%d tiles)", (int)frameInfo.chunkManager->getCoarseTileCount());
+
+        if (ImGui::Combo("##Coarse Terrain", &coarseTerrainCurrent, generateChunks, IM_ARRAYSIZE(generateChunks))) {
+            if (coarseTerrainCurrent) {
+                frameInfo.chunkManager->flags |= ChunkManagerFlags::COARSE_TERRAIN;
             } else {
-                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Failed to load world.");
+                frameInfo.chunkManager->flags &= ~ChunkManagerFlags::COARSE_TERRAIN;
             }
+        }
 
-            frameInfo.chunkManager->flags &= ~ChunkManagerFlags::GENERATE_CHUNKS;
+        static int meshCacheCurrent = (frameInfo.chunkManager->flags & ChunkManagerFlags::MESH_CACHE) ? 1 : 0;
+        MeshCache& meshCache = frameInfo.chunkManager->getMeshCache();
+        ImGui::Text("Mesh Cache (%d entries, %.1f MB, %d hits, %d misses)",
+                    (int)meshCache.getEntryCount(), meshCache.getSizeBytes() / 1048576.0f,
+                    (int)meshCache.getHits(), (int)meshCache.getMisses());
+
+        if (ImGui::Combo("##Mesh Cache", &meshCacheCurrent, generateChunks, IM_ARRAYSIZE(generateChunks))) {
+            if (meshCacheCurrent) {
+                frameInfo.chunkManager->flags |= ChunkManagerFlags::MESH_CACHE;
+            } else {
+                frameInfo.chunkManager->flags &= ~ChunkManagerFlags::MESH_CACHE;
+            }
+        }
+        if (ImGui::Button("Clear Mesh Cache")) {
+            meshCache.clear();
+        }
+
+        // Identical chunks share block storage and uploaded models; an edit splits them
+        ContentPool<BlockStorage>& storagePool = blockStoragePool();
+        ContentPool<Model>& modelPool = frameInfo.chunkManager->getModelPool();
+        static int sharingCurrent = storagePool.isEnabled() ? 1 : 0;
+        ImGui::Text("Shared Chunks (%d block storages, %d models, %d/%d hits)",
+                    (int)storagePool.liveCount(), (int)modelPool.liveCount(),
+                    (int)(storagePool.getHits() + modelPool.getHits()), (int)(storagePool.getLookups() + modelPool.getLookups()));
+
+        if (ImGui::Combo("##Shared Chunks", &sharingCurrent, generateChunks, IM_ARRAYSIZE(generateChunks))) {
+            storagePool.setEnabled(sharingCurrent);
+            modelPool.setEnabled(sharingCurrent);
+        }
+
+        static int caveCullingCurrent = (frameInfo.chunkManager->flags & ChunkManagerFlags::CAVE_CULLING) ? 1 : 0;
+        ImGui::Text("Cave Culling (drawing %d of %d chunks)",
+                    (int)frameInfo.chunkManager->getVisibleChunkCount(), (int)frameInfo.chunkManager->getDrawableChunkCount());
+
+        if (ImGui::Combo("##Cave Culling", &caveCullingCurrent, generateChunks, IM_ARRAYSIZE(generateChunks))) {
+            if (caveCullingCurrent) {
+                frameInfo.chunkManager->flags |= ChunkManagerFlags::CAVE_CULLING;
+            } else {
+                frameInfo.chunkManager->flags &= ~ChunkManagerFlags::CAVE_CULLING;
+            }
+        }
+
+        static int occlusionCullingCurrent = (frameInfo.chunkManager->flags & ChunkManagerFlags::OCCLUSION_CULLING) ? 1 : 0;
+        ImGui::Text("Occlusion Culling (%d occluded, %d off screen, %.2f ms)",
+                    (int)frameInfo.chunkManager->getOccludedChunkCount(), (int)frameInfo.chunkManager->getOutsideChunkCount(),
+                    frameInfo.chunkManager->getOcclusionMilliseconds());
+
+        if (ImGui::Combo("##Occlusion Culling", &occlusionCullingCurrent, generateChunks, IM_ARRAYSIZE(generateChunks))) {
+            if (occlusionCullingCurrent) {
+                frameInfo.chunkManager->flags |= ChunkManagerFlags::OCCLUSION_CULLING;
+            } else {
+                frameInfo.chunkManager->flags &= ~ChunkManagerFlags::OCCLUSION_CULLING;
+            }
+        }
+
+        static int faceCullingCurrent = (frameInfo.chunkManager->flags & ChunkManagerFlags::FACE_CULLING) ? 1 : 0;
+        size_t totalIndices = frameInfo.chunkManager->getTotalIndexCount();
+        ImGui::Text("Face Culling (drawing %.0f%% of chunk triangles)",
+                    totalIndices ? 100.0 * frameInfo.chunkManager->getDrawnIndexCount() / totalIndices : 100.0);
+
+        if (ImGui::Combo("##Face Culling", &faceCullingCurrent, generateChunks, IM_ARRAYSIZE(generateChunks))) {
+            if (faceCullingCurrent) {
+                frameInfo.chunkManager->flags |= ChunkManagerFlags::FACE_CULLING;
+            } else {
+                frameInfo.chunkManager->flags &= ~ChunkManagerFlags::FACE_CULLING;
+            }
+        }
+
+        if (frameInfo.gpuCuller && frameInfo.gpuCuller->isSupported()) {
+            static int gpuCullingCurrent = (frameInfo.chunkManager->flags & ChunkManagerFlags::GPU_CULLING) ? 1 : 0;
+            ImGui::Text("GPU Culling (%u draws for %d chunks, %d MB shared geometry)",
+                        frameInfo.gpuCuller->getLastCounts().draws, (int)frameInfo.gpuCuller->getChunkCount(),
+                        (int)(frameInfo.gpuCuller->getGeometryBytes() >> 20));
+
+            if (ImGui::Combo("##GPU Culling", &gpuCullingCurrent, generateChunks, IM_ARRAYSIZE(generateChunks))) {
+                if (gpuCullingCurrent) {
+                    frameInfo.chunkManager->flags |= ChunkManagerFlags::GPU_CULLING;
+                } else {
+                    frameInfo.chunkManager->flags &= ~ChunkManagerFlags::GPU_CULLING;
+                }
+            }
+        } else {
+            ImGui::Text("GPU Culling (unavailable on this device, see the log)");
+        }
+
+                if (ImGui::Button("Load Map")) {
+            // Loaded chunks stream back in from their region files as they come into range
+            frameInfo.chunkManager->loadWorld();
+            lastSaveMessage = "Saving edits before reloading";
+        }
+        if (lastSaveMessage == "Saving edits before reloading" && !frameInfo.chunkManager->isLoadPending()) {
+            lastSaveMessage = "World reloaded from disk";
+        }
+        if (!lastSaveMessage.empty()) {
+            ImGui::Text("%s", lastSaveMessage.c_str());
         }
         ImGui::End();
     }
     
     // Show the performance tab with scope timer information
-    showPerformanceTab();
+    showPerformanceTab(frameInfo.gpuProfiler);
 }
 }
@@ -0,0 +1,76 @@
+#include "lod_benchmark.hpp"
+#include "chunk_manager.hpp"
+#include "chunk_region.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace vkengine {
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+LodBenchmark::LodBenchmark(Options opts) : options{opts} {
+    coords = regionCoords(options.seed, options.renderDistance);
+}
+
+void LodBenchmark::run() {
+    std::cout << "LOD benchmark: render distance " << options.renderDistance << ", LOD distance "
+              << options.lodDistance << ", " << coords.size() << " non-empty chunks" << std::endl;
+
+    ChunkMap chunks = buildRegion(options.seed, options.renderDistance);
+
+    const ChunkCoord center{0, 0, 0};
+    auto inRange = [&](const ChunkCoord& coord, int distance) {
+        return coord.x * coord.x + coord.y * coord.y + coord.z * coord.z <= distance * distance;
+    };
+
+    // Triangles of every chunk within `distance`, meshed at the level `lodDistance` gives it;
+    // meshes are dropped as they are counted
+    auto countTriangles = [&](int distance, int lodDistance, size_t* perLevel) {
+        size_t triangles = 0;
+        for (size_t i = 0; i < coords.size(); ++i) {
+            if (!inRange(coords[i], distance)) continue;
+
+            ChunkLod lod{ChunkManager::lodLevel(coords[i], center, lodDistance), 0};
+            for (int f = 0; f < 6; ++f) {
+                ChunkCoord neighbor{coords[i].x + FACE_OFFSETS[f][0], coords[i].y + FACE_OFFSETS[f][1], coords[i].z + FACE_OFFSETS[f][2]};
+                if (ChunkManager::lodLevel(neighbor, center, lodDistance) != lod.level) {
+                    lod.seams |= 1 << f;
+                }
+            }
+
+            Chunk& chunk = *chunks.at(coords[i]);
+            chunk.generateGreedyMesh(lod);
+            size_t chunkTriangles = chunk.getIndices().size() / 3;
+            triangles += chunkTriangles;
+            if (perLevel) perLevel[lod.level] += chunkTriangles;
+            chunk.clearMesh();
+        }
+        return triangles;
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t baseline = countTriangles(options.baselineDistance, 0, nullptr);
+    std::printf("  distance %2d, full resolution: %10zu triangles (%.1f ms)\n", options.baselineDistance, baseline, elapsedMs(start));
+
+    start = std::chrono::high_resolution_clock::now();
+    size_t full = countTriangles(options.renderDistance, 0, nullptr);
+    std::printf("  distance %2d, full resolution: %10zu triangles (%.1f ms)\n", options.renderDistance, full, elapsedMs(start));
+
+    size_t perLevel[MAX_LOD_LEVEL + 1] = {};
+    start = std::chrono::high_resolution_clock::now();
+    size_t lod = countTriangles(options.renderDistance, options.lodDistance, perLevel);
+    std::printf("  distance %2d, LOD:             %10zu triangles (%.1f ms)\n", options.renderDistance, lod, elapsedMs(start));
+    for (int level = 0; level <= MAX_LOD_LEVEL; ++level) {
+        std::printf("    level %d (%dx): %10zu triangles\n", level, 1 << level, perLevel[level]);
+    }
+
+    std::printf("  LOD at distance %d uses %.2fx the triangles of full resolution at distance %d\n",
+                options.renderDistance, static_cast<double>(lod) / std::max<size_t>(1, baseline), options.baselineDistance);
+}
+
+} // namespace vkengine
@@ -1,13 +1,90 @@
 #ifndef VULKAN_RENDERER
 
 #include "../include/app.hpp"
+#include "../include/codec_benchmark.hpp"
+#include "../include/command_line.hpp"
+#include "../include/decoration_verifier.hpp"
+#include "../include/generation_verifier.hpp"
+#include "../include/gpu_culling_verifier.hpp"
+#include "../include/headless_renderer.hpp"
+#include "../include/lod_benchmark.hpp"
+#include "../include/occlusion_benchmark.hpp"
+#include "../include/storage_benchmark.hpp"
+#include "../include/world_verifier.hpp"
 #include <cstdlib>
+#include <vector>
 
 using namespace vkengine;
 
 #include <iostream>
 
-int main() {
+// Headless tools; each entry binds its command-line options to the tool's Options
+static std::vector<Subcommand> subcommands() {
+    using GV = GenerationVerifier::Options;
+    using WV = WorldVerifier::Options;
+    using SB = StorageBenchmark::Options;
+    using CB = CodecBenchmark::Options;
+    using LB = LodBenchmark::Options;
+    using OB = OcclusionBenchmark::Options;
+    using GC = GpuCullingVerifier::Options;
+    using HR = HeadlessRenderer::Options;
+    using DV = DecorationVerifier::Options;
+    return {
+        subcommand<GenerationVerifier>("--verify-generation", "Headless determinism check", {
+            option("--seed", "N", &GV::seed),
+            option("--expect", "DIGEST", &GV::expectedDigest),
+        }),
+        subcommand<WorldVerifier>("--verify-world", "Checksum every saved chunk without loading it", {
+            option("--dir", "PATH", &WV::directory),
+            option("--threads", "N", &WV::threads),
+        }),
+        subcommand<StorageBenchmark>("--benchmark-storage", "Flat vs palette block storage", {
+            option("--seed", "N", &SB::seed),
+            option("--distance", "N", &SB::renderDistance),
+        }),
+        subcommand<CodecBenchmark>("--benchmark-codecs", "Chunk codec ratio and throughput", {
+            option("--seed", "N", &CB::seed),
+            option("--distance", "N", &CB::renderDistance),
+        }),
+        subcommand<LodBenchmark>("--benchmark-lod", "Triangles with and without LOD", {
+            option("--seed", "N", &LB::seed),
+            option("--distance", "N", &LB::renderDistance),
+            option("--lod-distance", "N", &LB::lodDistance),
+        }),
+        subcommand<OcclusionBenchmark>("--benchmark-occlusion", "Chunks culled and cost per frame", {
+            option("--seed", "N", &OB::seed),
+            option("--distance", "N", &OB::renderDistance),
+            option("--occluder-distance", "N", &OB::occluderDistance),
+        }),
+        subcommand<GpuCullingVerifier>("--verify-gpu-culling", "GPU culling pass against the CPU, needs a Vulkan device", {
+            option("--seed", "N", &GC::seed),
+            option("--distance", "N", &GC::renderDistance),
+        }),
+        subcommand<DecorationVerifier>("--verify-decorations", "Trees must not grow back into saved chunks", {
+            option("--seed", "N", &DV::seed),
+            option("--distance", "N", &DV::renderDistance),
+            option("--dir", "PATH", &DV::directory),
+        }),
+        subcommand<HeadlessRenderer>("--render-headless", "Offscreen path replay with per-frame timings", {
+            option("--seed", "N", &HR::seed),
+            option("--distance", "N", &HR::renderDistance),
+            option("--width", "N", &HR::width),
+            option("--height", "N", &HR::height),
+            option("--path", "FILE", &HR::pathFile),
+            option("--frames", "N", &HR::frames),
+            option("--out", "DIR", &HR::outputDirectory),
+            option("--every", "N", &HR::dumpEvery),
+            option("--expect", "DIGEST", &HR::expectedDigest),
+        }),
+    };
+}
+
+int main(int argc, char **argv) {
+    int result = runSubcommand(subcommands(), argc, argv);
+    if (result >= 0) {
+        return result;
+    }
+
     App app;
 
     try {
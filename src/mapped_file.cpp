@@ -0,0 +1,68 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace vkengine {
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data{std::exchange(other.m_data, nullptr)}, m_size{std::exchange(other.m_size, 0)} {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+bool MappedFile::map(const std::string& path) {
+    unmap();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    if (info.st_size > 0) {
+        void* address = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+        // Chunks are fetched in whatever order they come into range
+        ::madvise(address, static_cast<size_t>(info.st_size), MADV_RANDOM);
+        m_data = static_cast<const char*>(address);
+        m_size = static_cast<size_t>(info.st_size);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (m_data) {
+        ::munmap(const_cast<char*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+} // namespace vkengine
@@ -0,0 +1,217 @@
+#include "mesh_cache.hpp"
+#include "byte_io.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace vkengine {
+
+static constexpr uint32_t MESH_CACHE_MAGIC = 0x434D4B56;  // "VKMC"
+static constexpr uint32_t MESH_CACHE_VERSION = 1;
+static constexpr size_t MESH_CACHE_HEADER_SIZE = 36;
+static constexpr const char* MESH_CACHE_EXTENSION = ".mesh";
+
+// Distinguishes the temporary files of concurrent stores
+static std::atomic<uint64_t> temporaryCounter{0};
+
+MeshCache::MeshCache(std::string directory, size_t capacityBytes)
+    : directory{std::move(directory)}, capacity{capacityBytes} {}
+
+std::string MeshCache::entryPath(uint64_t key) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return directory + "/" + name + MESH_CACHE_EXTENSION;
+}
+
+void MeshCache::scanDirectory() {
+    if (scanned) return;
+    scanned = true;
+
+    struct Found {
+        std::filesystem::file_time_type time;
+        uint64_t key;
+        size_t size;
+    };
+    std::vector<Found> found;
+
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(directory, ec)) {
+        const std::filesystem::path& path = file.path();
+        if (path.extension() != MESH_CACHE_EXTENSION) continue;
+
+        std::string stem = path.stem().string();
+        char* end = nullptr;
+        uint64_t key = std::strtoull(stem.c_str(), &end, 16);
+        if (stem.size() != 16 || end != stem.c_str() + stem.size()) continue;
+
+        std::error_code fileEc;
+        size_t size = static_cast<size_t>(file.file_size(fileEc));
+        auto time = file.last_write_time(fileEc);
+        if (fileEc) continue;
+        found.push_back({time, key, size});
+    }
+
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.time > b.time; });
+    for (const Found& entry : found) {
+        recency.push_back(entry.key);
+        entries[entry.key] = {entry.size, std::prev(recency.end())};
+        totalBytes += entry.size;
+    }
+    evict();
+}
+
+void MeshCache::erase(uint64_t key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) return;
+
+    std::error_code ec;
+    std::filesystem::remove(entryPath(key), ec);
+    totalBytes -= it->second.size;
+    recency.erase(it->second.recency);
+    entries.erase(it);
+}
+
+void MeshCache::evict() {
+    while (totalBytes > capacity && !recency.empty()) {
+        erase(recency.back());
+    }
+}
+
+bool MeshCache::load(uint64_t key, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scanDirectory();
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            ++misses;
+            return false;
+        }
+        recency.splice(recency.begin(), recency, it->second.recency);
+    }
+
+    // Read outside the lock; an entry evicted meanwhile just fails to open
+    std::string path = entryPath(key);
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::string data(in ? static_cast<size_t>(in.tellg()) : 0, '\0');
+    in.seekg(0);
+    in.read(data.data(), data.size());
+    if (!in) data.clear();
+
+    bool valid = data.size() >= MESH_CACHE_HEADER_SIZE &&
+                 getU32(data.data()) == MESH_CACHE_MAGIC &&
+                 getU32(data.data() + 4) == MESH_CACHE_VERSION &&
+                 getU64(data.data() + 8) == key &&
+                 getU32(data.data() + 16) == sizeof(Model::Vertex);
+    size_t vertexCount = valid ? getU32(data.data() + 20) : 0;
+    size_t indexCount = valid ? getU32(data.data() + 24) : 0;
+    size_t vertexBytes = vertexCount * sizeof(Model::Vertex);
+    size_t indexBytes = indexCount * sizeof(uint32_t);
+    valid = valid && data.size() == MESH_CACHE_HEADER_SIZE + vertexBytes + indexBytes &&
+            hashBytes(data.data() + MESH_CACHE_HEADER_SIZE, vertexBytes + indexBytes) == getU64(data.data() + 28);
+
+    if (!valid) {
+        std::lock_guard<std::mutex> lock(mutex);
+        erase(key);
+        ++misses;
+        return false;
+    }
+
+    vertices.resize(vertexCount);
+    indices.resize(indexCount);
+    std::memcpy(vertices.data(), data.data() + MESH_CACHE_HEADER_SIZE, vertexBytes);
+    std::memcpy(indices.data(), data.data() + MESH_CACHE_HEADER_SIZE + vertexBytes, indexBytes);
+
+    // Keeps the recency order for the next session's scan
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    ++hits;
+    return true;
+}
+
+void MeshCache::store(uint64_t key, const std::vector<Model::Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    size_t vertexBytes = vertices.size() * sizeof(Model::Vertex);
+    size_t indexBytes = indices.size() * sizeof(uint32_t);
+
+    std::string data(MESH_CACHE_HEADER_SIZE, '\0');
+    data.reserve(MESH_CACHE_HEADER_SIZE + vertexBytes + indexBytes);
+    data.append(reinterpret_cast<const char*>(vertices.data()), vertexBytes);
+    data.append(reinterpret_cast<const char*>(indices.data()), indexBytes);
+    putU32(&data[0], MESH_CACHE_MAGIC);
+    putU32(&data[4], MESH_CACHE_VERSION);
+    putU64(&data[8], key);
+    putU32(&data[16], sizeof(Model::Vertex));
+    putU32(&data[20], static_cast<uint32_t>(vertices.size()));
+    putU32(&data[24], static_cast<uint32_t>(indices.size()));
+    putU64(&data[28], hashBytes(data.data() + MESH_CACHE_HEADER_SIZE, vertexBytes + indexBytes));
+
+    if (data.size() > capacity) return;
+
+    // Written aside and renamed into place, so readers never see a partial entry
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::string path = entryPath(key);
+    std::string temporary = path + "." + std::to_string(temporaryCounter++) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    scanDirectory();
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        totalBytes -= it->second.size;
+        it->second.size = data.size();
+        recency.splice(recency.begin(), recency, it->second.recency);
+    } else {
+        recency.push_front(key);
+        entries[key] = {data.size(), recency.begin()};
+    }
+    totalBytes += data.size();
+    evict();
+}
+
+void MeshCache::setCapacity(size_t capacityBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = capacityBytes;
+    if (scanned) {
+        evict();
+    }
+}
+
+void MeshCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    recency.clear();
+    entries.clear();
+    totalBytes = 0;
+    scanned = true;
+}
+
+size_t MeshCache::getEntryCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t MeshCache::getSizeBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totalBytes;
+}
+
+} // namespace vkengine
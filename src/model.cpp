@@ -3,6 +3,7 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <algorithm>
 #include <unordered_map>
 #include <iostream>
 
@@ -28,6 +29,13 @@ using namespace vkengine;
 Model::Model(Device &device, const Model::Builder &builder) : device(device) {
     createVertexBuffers(builder.vertices);
     createIndexBuffer(builder.indices);
+    if (hasIndexBuffer && !builder.groupOffsets.empty()) {
+        if (builder.groupOffsets.front() != 0 || builder.groupOffsets.back() != indexCount ||
+            !std::is_sorted(builder.groupOffsets.begin(), builder.groupOffsets.end())) {
+            throw std::runtime_error("Model index groups do not cover the indices");
+        }
+        groupOffsets = builder.groupOffsets;
+    }
 }
 
 Model::~Model() {}
@@ -43,7 +51,7 @@ void Model::createVertexBuffers(const std::vector<Vertex> &vertices) {
     stagingBuffer.map();
     stagingBuffer.writeToBuffer((void *)vertices.data());
 
-    vertexBuffer = std::make_unique<Buffer>(device, vertexSize, vertexCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vertexBuffer = std::make_unique<Buffer>(device, vertexSize, vertexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
 }
@@ -63,7 +71,7 @@ void Model::createIndexBuffer(const std::vector<uint32_t> &indices) {
     stagingBuffer.map();
     stagingBuffer.writeToBuffer((void *)indices.data());
 
-    indexBuffer = std::make_unique<Buffer>(device, indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    indexBuffer = std::make_unique<Buffer>(device, indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
     device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
 }
 
@@ -86,6 +94,32 @@ void Model::draw(VkCommandBuffer commandBuffer) {
     }
 }
 
+uint32_t Model::drawGroups(VkCommandBuffer commandBuffer, uint32_t groupMask) {
+    if (groupOffsets.empty()) {
+        draw(commandBuffer);
+        return hasIndexBuffer ? indexCount : vertexCount;
+    }
+
+    uint32_t drawn = 0;
+    uint32_t groups = getGroupCount();
+    for (uint32_t group = 0; group < groups;) {
+        if (!(groupMask & (1u << group))) {
+            group++;
+            continue;
+        }
+        uint32_t first = groupOffsets[group];
+        while (group < groups && (groupMask & (1u << group))) {
+            group++;
+        }
+        uint32_t count = groupOffsets[group] - first;
+        if (count > 0) {
+            vkCmdDrawIndexed(commandBuffer, count, 1, first, 0, 0);
+            drawn += count;
+        }
+    }
+    return drawn;
+}
+
 std::vector<VkVertexInputBindingDescription> Model::Vertex::getBindingDescriptions() {
     std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
     bindingDescriptions[0].binding = 0;
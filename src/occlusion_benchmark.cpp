@@ -0,0 +1,170 @@
+#include "occlusion_benchmark.hpp"
+#include "camera.hpp"
+#include "chunk_region.hpp"
+#include "occlusion_culler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace vkengine {
+
+// Blocks occluders are made of; water and leaves never occlude
+static bool blocksView(const ChunkMap& chunks, int x, int y, int z) {
+    ChunkCoord coord{floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE)};
+    auto it = chunks.find(coord);
+    if (it == chunks.end()) return false;
+    BlockType type = it->second->getBlock(x - coord.x * CHUNK_SIZE, y - coord.y * CHUNK_SIZE, z - coord.z * CHUNK_SIZE).type;
+    return type != BlockType::AIR && type != BlockType::WATER && type != BlockType::LEAVES;
+}
+
+// Walks the blocks between two points (Amanatides & Woo); true if none of them blocks the view
+static bool lineOfSight(const ChunkMap& chunks, glm::vec3 from, glm::vec3 to) {
+    glm::vec3 delta = to - from;
+    glm::ivec3 cell = glm::ivec3(glm::floor(from));
+    glm::ivec3 target = glm::ivec3(glm::floor(to));
+    glm::ivec3 step;
+    glm::vec3 tMax, tDelta;
+    for (int axis = 0; axis < 3; ++axis) {
+        step[axis] = delta[axis] > 0 ? 1 : -1;
+        if (delta[axis] == 0.0f) {
+            tMax[axis] = tDelta[axis] = INFINITY;
+            continue;
+        }
+        float boundary = static_cast<float>(cell[axis] + (step[axis] > 0 ? 1 : 0));
+        tMax[axis] = (boundary - from[axis]) / delta[axis];
+        tDelta[axis] = static_cast<float>(step[axis]) / delta[axis];
+    }
+    while (cell != target) {
+        if (blocksView(chunks, cell.x, cell.y, cell.z)) return false;
+        int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+        if (tMax[axis] > 1.0f) break;
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+    }
+    return true;
+}
+
+OcclusionBenchmark::OcclusionBenchmark(Options opts) : options{opts} {
+    coords = regionCoords(options.seed, options.renderDistance);
+}
+
+bool OcclusionBenchmark::run() {
+    std::cout << "Occlusion benchmark: render distance " << options.renderDistance << ", occluder distance "
+              << options.occluderDistance << ", " << coords.size() << " non-empty chunks" << std::endl;
+
+    ChunkMap chunks = buildRegion(options.seed, options.renderDistance);
+    for (auto& [coord, chunk] : chunks) {
+        chunk->generateGreedyMesh();
+    }
+
+    // Cameras at fixed columns, on the ground and above the hills, looking level in
+    // four directions (up is -y), so every run sees the same scenes
+    struct Scene {
+        glm::vec3 eye;
+        float yaw;
+        std::string name;
+    };
+    static const int columns[][2] = {{8, 8}, {40, -24}, {-56, 72}, {-88, -40}};
+    static const int heights[] = {2, 24};
+    static const int yawDegrees[] = {0, 90, 180, 270};
+    std::vector<Scene> scenes;
+    for (const auto& column : columns) {
+        int surface = options.renderDistance * CHUNK_SIZE;
+        for (int y = -options.renderDistance * CHUNK_SIZE; y < options.renderDistance * CHUNK_SIZE; ++y) {
+            if (blocksView(chunks, column[0], y, column[1])) {
+                surface = y;
+                break;
+            }
+        }
+        for (int height : heights) {
+            for (int yaw : yawDegrees) {
+                char name[48];
+                std::snprintf(name, sizeof(name), "(%d,%d)+%d yaw %d", column[0], column[1], height, yaw);
+                scenes.push_back({{column[0] + 0.5f, static_cast<float>(surface - height), column[1] + 0.5f}, glm::radians(static_cast<float>(yaw)), name});
+            }
+        }
+    }
+
+    std::vector<const Chunk*> chunkList;
+    for (const ChunkCoord& coord : coords) {
+        chunkList.push_back(chunks[coord].get());
+    }
+
+    OcclusionCuller culler;
+    const int repeats = 20;
+    size_t totalOnScreen = 0, totalOccluded = 0, wronglyCulled = 0;
+    double totalMilliseconds = 0.0;
+
+    std::printf("  %-24s %9s %8s %9s %10s\n", "camera", "on screen", "occluded", "triangles", "ms/frame");
+    for (const Scene& scene : scenes) {
+        const glm::vec3& eye = scene.eye;
+        Camera camera;
+        camera.setViewYXZ(eye, glm::vec3(0.0f, scene.yaw, 0.0f));
+        camera.setPerspectiveProjection(glm::radians(50.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        glm::mat4 viewProjection = camera.getProjection() * camera.getView();
+        ChunkCoord eyeChunk{floorDiv(static_cast<int>(std::floor(eye.x)), CHUNK_SIZE),
+                            floorDiv(static_cast<int>(std::floor(eye.y)), CHUNK_SIZE),
+                            floorDiv(static_cast<int>(std::floor(eye.z)), CHUNK_SIZE)};
+
+        std::vector<OcclusionCuller::Result> results(coords.size());
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            culler.beginFrame(viewProjection);
+            for (size_t i = 0; i < coords.size(); ++i) {
+                int dx = coords[i].x - eyeChunk.x, dy = coords[i].y - eyeChunk.y, dz = coords[i].z - eyeChunk.z;
+                const auto& occluders = chunkList[i]->getMeshOccluders();
+                if (occluders && dx * dx + dy * dy + dz * dz <= options.occluderDistance * options.occluderDistance) {
+                    culler.addOccluders(glm::vec3(coords[i].x, coords[i].y, coords[i].z) * static_cast<float>(CHUNK_SIZE), *occluders);
+                }
+            }
+            for (size_t i = 0; i < coords.size(); ++i) {
+                glm::vec3 boxMin = glm::vec3(coords[i].x, coords[i].y, coords[i].z) * static_cast<float>(CHUNK_SIZE);
+                results[i] = culler.test(boxMin, boxMin + static_cast<float>(CHUNK_SIZE));
+            }
+        }
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / repeats;
+
+        size_t onScreen = 0, occluded = 0;
+        for (size_t i = 0; i < coords.size(); ++i) {
+            const Chunk& chunk = *chunkList[i];
+            if (chunk.getVertices().empty() || results[i] == OcclusionCuller::Result::OUTSIDE) continue;
+            onScreen++;
+            if (results[i] != OcclusionCuller::Result::OCCLUDED) continue;
+            occluded++;
+
+            // A vertex in front of the camera that can see it means part of the chunk shows
+            glm::vec3 origin = glm::vec3(coords[i].x, coords[i].y, coords[i].z) * static_cast<float>(CHUNK_SIZE);
+            for (const Model::Vertex& vertex : chunk.getVertices()) {
+                glm::vec3 position = origin + vertex.position + vertex.normal * 0.01f;
+                glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+                if (clip.w <= 0.0f || std::abs(clip.x) > clip.w || std::abs(clip.y) > clip.w) continue;
+                if (glm::dot(eye - position, vertex.normal) <= 0.0f) continue;
+                if (lineOfSight(chunks, position, eye)) {
+                    wronglyCulled++;
+                    break;
+                }
+            }
+        }
+
+        std::printf("  %-24s %9zu %8zu %9zu %10.3f\n", scene.name.c_str(), onScreen, occluded, culler.getTriangleCount(), milliseconds);
+        totalOnScreen += onScreen;
+        totalOccluded += occluded;
+        totalMilliseconds += milliseconds;
+    }
+
+    std::printf("  occluded %.1f%% of on-screen chunks, %.3f ms per frame on average\n",
+                100.0 * totalOccluded / std::max<size_t>(1, totalOnScreen), totalMilliseconds / std::max<size_t>(1, scenes.size()));
+    if (wronglyCulled > 0) {
+        std::cout << "  MISMATCH: " << wronglyCulled << " culled chunks can be seen from the camera" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace vkengine
@@ -0,0 +1,180 @@
+#include "occlusion_culler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace vkengine {
+
+// Points closer to the eye than this are treated as crossing the near plane
+static constexpr float MIN_CLIP_W = 1e-3f;
+
+OcclusionCuller::OcclusionCuller(int w, int h)
+    : width{w}, height{h}, stride{(w + 3) & ~3}, depth(static_cast<size_t>(stride) * h, 1.0f) {}
+
+void OcclusionCuller::beginFrame(const glm::mat4& vp) {
+    viewProjection = vp;
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    triangleCount = 0;
+}
+
+bool OcclusionCuller::project(const glm::vec3& position, ScreenVertex& out) const {
+    glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+    if (clip.w < MIN_CLIP_W || clip.z < 0.0f) return false;
+    float inverseW = 1.0f / clip.w;
+    out.x = (clip.x * inverseW * 0.5f + 0.5f) * static_cast<float>(width);
+    out.y = (clip.y * inverseW * 0.5f + 0.5f) * static_cast<float>(height);
+    out.z = clip.z * inverseW;
+    return true;
+}
+
+void OcclusionCuller::addOccluders(const glm::vec3& origin, const std::vector<OccluderQuad>& quads) {
+    for (const OccluderQuad& quad : quads) {
+        ScreenVertex corners[4];
+        bool inFront = true;
+        for (int i = 0; i < 4 && inFront; ++i) {
+            inFront = project(origin + quad.corners[i], corners[i]);
+        }
+        // Clipping would only shrink the occluder; dropping it stays conservative
+        if (!inFront) continue;
+
+        rasterizeTriangle(corners[0], corners[1], corners[2]);
+        rasterizeTriangle(corners[0], corners[2], corners[3]);
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c) {
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (std::abs(area) < 1e-6f) return;
+    // Occluders are double sided; make the winding counter-clockwise
+    const ScreenVertex& v1 = area > 0.0f ? b : c;
+    const ScreenVertex& v2 = area > 0.0f ? c : b;
+    area = std::abs(area);
+
+    int x0 = std::max(0, static_cast<int>(std::floor(std::min({a.x, v1.x, v2.x}))));
+    int x1 = std::min(width - 1, static_cast<int>(std::ceil(std::max({a.x, v1.x, v2.x}))) - 1);
+    int y0 = std::max(0, static_cast<int>(std::floor(std::min({a.y, v1.y, v2.y}))));
+    int y1 = std::min(height - 1, static_cast<int>(std::ceil(std::max({a.y, v1.y, v2.y}))) - 1);
+    if (x0 > x1 || y0 > y1) return;
+    triangleCount++;
+
+    // Edge functions A*x + B*y + C, positive inside. A pixel is only covered
+    // when the whole pixel is inside, so each edge is pulled in by the most
+    // it can change across half a pixel.
+    const ScreenVertex* vertices[3] = {&a, &v1, &v2};
+    float edgeA[3], edgeB[3], edgeC[3];
+    for (int i = 0; i < 3; ++i) {
+        const ScreenVertex& p = *vertices[i];
+        const ScreenVertex& q = *vertices[(i + 1) % 3];
+        edgeA[i] = p.y - q.y;
+        edgeB[i] = q.x - p.x;
+        edgeC[i] = p.x * q.y - p.y * q.x - 0.5f * (std::abs(edgeA[i]) + std::abs(edgeB[i]));
+    }
+
+    // Depth is affine in screen space; take its farthest value over each pixel
+    float dzdx = ((v1.z - a.z) * (v2.y - a.y) - (v2.z - a.z) * (v1.y - a.y)) / area;
+    float dzdy = ((v2.z - a.z) * (v1.x - a.x) - (v1.z - a.z) * (v2.x - a.x)) / area;
+    float zOffset = a.z - dzdx * a.x - dzdy * a.y + 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+
+    // Start on a 4-pixel boundary; rows are padded so the last group stays in the row
+    int xStart = x0 & ~3;
+    for (int y = y0; y <= y1; ++y) {
+        float centerY = static_cast<float>(y) + 0.5f;
+        float* row = &depth[static_cast<size_t>(y) * stride];
+        float rowEdge[3];
+        for (int i = 0; i < 3; ++i) {
+            rowEdge[i] = edgeB[i] * centerY + edgeC[i];
+        }
+        float rowZ = dzdy * centerY + zOffset;
+
+#if defined(__SSE2__)
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        for (int x = xStart; x <= x1; x += 4) {
+            __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), centerX), _mm_set1_ps(rowEdge[0])), zero);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), centerX), _mm_set1_ps(rowEdge[1])), zero));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), centerX), _mm_set1_ps(rowEdge[2])), zero));
+            if (_mm_movemask_ps(inside) == 0) continue;
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), centerX), _mm_set1_ps(rowZ));
+            __m128 current = _mm_loadu_ps(row + x);
+            __m128 nearer = _mm_min_ps(current, z);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+        }
+#else
+        for (int x = xStart; x <= x1; ++x) {
+            float centerX = static_cast<float>(x) + 0.5f;
+            if (edgeA[0] * centerX + rowEdge[0] < 0.0f ||
+                edgeA[1] * centerX + rowEdge[1] < 0.0f ||
+                edgeA[2] * centerX + rowEdge[2] < 0.0f) {
+                continue;
+            }
+            row[x] = std::min(row[x], dzdx * centerX + rowZ);
+        }
+#endif
+    }
+}
+
+OcclusionCuller::Result OcclusionCuller::test(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    // Frustum first: off screen if every corner is outside the same clip plane
+    glm::vec4 clip[8];
+    int outsideAll = 0x3F;
+    bool crossesNear = false;
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 position{
+            corner & 1 ? boxMax.x : boxMin.x,
+            corner & 2 ? boxMax.y : boxMin.y,
+            corner & 4 ? boxMax.z : boxMin.z
+        };
+        clip[corner] = viewProjection * glm::vec4(position, 1.0f);
+        const glm::vec4& c = clip[corner];
+        int outside = (c.x < -c.w) | (c.x > c.w) << 1 | (c.y < -c.w) << 2 | (c.y > c.w) << 3 | (c.z < 0.0f) << 4 | (c.z > c.w) << 5;
+        outsideAll &= outside;
+        crossesNear |= c.w < MIN_CLIP_W || c.z < 0.0f;
+    }
+    if (outsideAll != 0) return Result::OUTSIDE;
+    // Boxes that reach the near plane are never culled
+    if (crossesNear) return Result::VISIBLE;
+
+    float minX = static_cast<float>(width), maxX = 0.0f;
+    float minY = static_cast<float>(height), maxY = 0.0f;
+    float nearest = 1.0f;
+    for (const glm::vec4& c : clip) {
+        float inverseW = 1.0f / c.w;
+        float x = (c.x * inverseW * 0.5f + 0.5f) * static_cast<float>(width);
+        float y = (c.y * inverseW * 0.5f + 0.5f) * static_cast<float>(height);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, c.z * inverseW);
+    }
+
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int x1 = std::min(width - 1, std::max(x0, static_cast<int>(std::ceil(maxX)) - 1));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int y1 = std::min(height - 1, std::max(y0, static_cast<int>(std::ceil(maxY)) - 1));
+
+    for (int y = y0; y <= y1; ++y) {
+        const float* row = &depth[static_cast<size_t>(y) * stride];
+        int x = x0;
+#if defined(__SSE2__)
+        __m128 boxDepth = _mm_set1_ps(nearest);
+        for (; x + 3 <= x1; x += 4) {
+            // Anything at or behind the box's nearest point leaves it visible
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth)) != 0) {
+                return Result::VISIBLE;
+            }
+        }
+#endif
+        for (; x <= x1; ++x) {
+            if (row[x] >= nearest) return Result::VISIBLE;
+        }
+    }
+    return Result::OCCLUDED;
+}
+
+} // namespace vkengine
@@ -0,0 +1,183 @@
+#include "parallel_recorder.hpp"
+#include "swapchain.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace vkengine {
+
+ParallelRecorder::ParallelRecorder(Device& device, int maxThreads) : device{device} {
+    maxThreads = std::max(0, maxThreads);
+    pools.resize(static_cast<size_t>(SwapChain::MAX_FRAMES_IN_FLIGHT) * (maxThreads + 1));
+    for (Pool& entry : pools) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = device.getGraphicsQueueFamily();
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &entry.pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create recording command pool");
+        }
+    }
+
+    for (int worker = 0; worker < maxThreads; ++worker) {
+        workers.emplace_back(&ParallelRecorder::workerLoop, this, worker);
+    }
+}
+
+ParallelRecorder::~ParallelRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    // Destroying a pool frees its buffers
+    for (Pool& entry : pools) {
+        vkDestroyCommandPool(device.device(), entry.pool, nullptr);
+    }
+}
+
+void ParallelRecorder::setThreadCount(int count) {
+    threadCount = std::clamp(count, 0, getMaxThreadCount());
+}
+
+void ParallelRecorder::beginFrame(int frame, VkRenderPass pass, VkFramebuffer target, VkExtent2D size) {
+    frameIndex = frame;
+    renderPass = pass;
+    framebuffer = target;
+    extent = size;
+    activeThreads = threadCount;
+
+    // The renderer has waited for this frame's fence, so its buffers are no longer in use
+    for (size_t slot = 0; slot <= workers.size(); ++slot) {
+        Pool& entry = pool(static_cast<int>(slot));
+        if (entry.used == 0) continue;
+        vkResetCommandPool(device.device(), entry.pool, 0);
+        entry.used = 0;
+    }
+}
+
+VkCommandBuffer ParallelRecorder::beginBuffer(Pool& entry) {
+    if (entry.used == entry.buffers.size()) {
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocateInfo.commandPool = entry.pool;
+        allocateInfo.commandBufferCount = 1;
+        VkCommandBuffer buffer;
+        if (vkAllocateCommandBuffers(device.device(), &allocateInfo, &buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate secondary command buffer");
+        }
+        entry.buffers.push_back(buffer);
+    }
+    VkCommandBuffer commandBuffer = entry.buffers[entry.used++];
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin secondary command buffer");
+    }
+
+    // Dynamic state is not inherited from the primary buffer
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{{0, 0}, extent};
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    return commandBuffer;
+}
+
+void ParallelRecorder::record(const Task& work, std::vector<VkCommandBuffer>& buffers) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &work;
+        slices = activeThreads;
+        pending = activeThreads;
+        results.assign(activeThreads, VK_NULL_HANDLE);
+        threadMilliseconds.assign(activeThreads, 0.0f);
+        error = nullptr;
+        generation++;
+    }
+    workAvailable.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return pending == 0; });
+    task = nullptr;
+    slices = 0;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    buffers.insert(buffers.end(), results.begin(), results.end());
+    recordMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ParallelRecorder::recordInline(const Task& work, VkCommandBuffer commandBuffer) {
+    auto start = std::chrono::steady_clock::now();
+    work(0, commandBuffer);
+    recordMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    threadMilliseconds.assign(1, recordMilliseconds);
+}
+
+VkCommandBuffer ParallelRecorder::beginSecondary() {
+    return beginBuffer(pool(0));
+}
+
+void ParallelRecorder::endSecondary(VkCommandBuffer commandBuffer) {
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record secondary command buffer");
+    }
+}
+
+void ParallelRecorder::workerLoop(int worker) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workAvailable.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        // Workers beyond this record()'s slices sit it out. One that wakes after
+        // the record() it was woken for has returned finds no task and waits again.
+        if (!task || worker >= slices) continue;
+        const Task& work = *task;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        std::exception_ptr failure;
+        try {
+            commandBuffer = beginBuffer(pool(worker + 1));
+            work(worker, commandBuffer);
+            endSecondary(commandBuffer);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        results[worker] = commandBuffer;
+        threadMilliseconds[worker] = milliseconds;
+        if (failure && !error) error = failure;
+        if (--pending == 0) {
+            workDone.notify_one();
+        }
+    }
+}
+
+} // namespace vkengine
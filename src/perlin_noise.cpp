@@ -1,12 +1,10 @@
 #include "perlin_noise.hpp"
+#include "hash.hpp"
 
 namespace vkengine {
 
 // Constructor with default seed
-PerlinNoise::PerlinNoise() {
-    // Initialize with a fixed seed for consistent results
-    PerlinNoise(42);
-}
+PerlinNoise::PerlinNoise() : PerlinNoise(42) {}
 
 // Constructor with specified seed
 PerlinNoise::PerlinNoise(unsigned int seed) {
@@ -14,9 +12,16 @@ PerlinNoise::PerlinNoise(unsigned int seed) {
     p.resize(256);
     std::iota(p.begin(), p.end(), 0);
     
-    // Shuffle the array with the seed
-    std::default_random_engine engine(seed);
-    std::shuffle(p.begin(), p.end(), engine);
+    // Fisher-Yates shuffle driven by splitmix64. std::default_random_engine and
+    // std::shuffle are implementation defined, so the same seed would give a
+    // different world depending on the standard library.
+    uint64_t state = seed;
+    for (int i = 255; i > 0; --i) {
+        state += 0x9e3779b97f4a7c15ULL;
+        uint64_t r = splitmix64(state);
+        int j = static_cast<int>(r % static_cast<uint64_t>(i + 1));
+        std::swap(p[i], p[j]);
+    }
     
     // Duplicate the permutation array to avoid overflow
     p.insert(p.end(), p.begin(), p.end());
@@ -82,7 +87,7 @@ double PerlinNoise::noise(double x, double y, double z) const {
     return result;
 }
 
-double PerlinNoise::octaveNoise(double x, double y, int octaves, double persistence) {
+double PerlinNoise::octaveNoise(double x, double y, int octaves, double persistence) const {
     double total = 0.0;
     double frequency = 1.0;
     double amplitude = 1.0;
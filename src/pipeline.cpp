@@ -10,8 +10,8 @@
 
 using namespace vkengine;
 
-Pipeline::Pipeline(Device &device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) : device(device) {
-    createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+Pipeline::Pipeline(Device &device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache) : device(device) {
+    createGraphicsPipeline(vertFilepath, fragFilepath, configInfo, pipelineCache);
 }
 
 Pipeline::~Pipeline() {
@@ -41,7 +41,7 @@ void Pipeline::bind(VkCommandBuffer commandBuffer) {
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 }
 
-void Pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) {
+void Pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache) {
     assert(configInfo.pipelineLayout != nullptr && "Cannot create graphics pipeline: no pipelineLayout provided");
     assert(configInfo.renderPass != nullptr && "Cannot create graphics pipeline: no renderPass provided");
 
@@ -99,7 +99,7 @@ void Pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    if(vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    if(vkCreateGraphicsPipelines(device.device(), pipelineCache, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
         throw std::runtime_error("Couldnt create graphics pipelines");
     }
 }
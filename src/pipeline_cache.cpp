@@ -0,0 +1,113 @@
+#include "pipeline_cache.hpp"
+#include "byte_io.hpp"
+#include "hash.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace vkengine {
+
+static constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43504B56;  // "VKPC"
+static constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+static constexpr size_t PIPELINE_CACHE_HEADER_SIZE = 20 + VK_UUID_SIZE + 16;
+
+PipelineCache::PipelineCache(Device& device, std::string path) : device{device}, path{std::move(path)} {
+    std::string data = load();
+    warm = !data.empty();
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+    if (vkCreatePipelineCache(device.device(), &createInfo, nullptr, &cache) != VK_SUCCESS) {
+        // The driver rejected the data after all; start empty
+        warm = false;
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        if (vkCreatePipelineCache(device.device(), &createInfo, nullptr, &cache) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache");
+        }
+    }
+    std::cout << "Pipeline cache: " << (warm ? "loaded " + std::to_string(data.size()) + " bytes from " + this->path : std::string("cold start"))
+              << std::endl;
+}
+
+PipelineCache::~PipelineCache() {
+    if (dirty) {
+        save();
+    }
+    vkDestroyPipelineCache(device.device(), cache, nullptr);
+}
+
+std::string PipelineCache::load() {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return {};
+    std::string file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (file.size() < PIPELINE_CACHE_HEADER_SIZE) return {};
+
+    const VkPhysicalDeviceProperties& properties = device.properties;
+    const char* header = file.data();
+    if (getU32(header) != PIPELINE_CACHE_MAGIC || getU32(header + 4) != PIPELINE_CACHE_VERSION) return {};
+    if (getU32(header + 8) != properties.vendorID || getU32(header + 12) != properties.deviceID ||
+        getU32(header + 16) != properties.driverVersion ||
+        std::memcmp(header + 20, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        std::cout << "Pipeline cache: " << path << " is from another device or driver, ignoring it" << std::endl;
+        return {};
+    }
+
+    uint64_t size = getU64(header + 20 + VK_UUID_SIZE);
+    uint64_t checksum = getU64(header + 28 + VK_UUID_SIZE);
+    if (size != file.size() - PIPELINE_CACHE_HEADER_SIZE ||
+        hashBytes(file.data() + PIPELINE_CACHE_HEADER_SIZE, size) != checksum) {
+        std::cout << "Pipeline cache: " << path << " is damaged, ignoring it" << std::endl;
+        return {};
+    }
+    return file.substr(PIPELINE_CACHE_HEADER_SIZE);
+}
+
+void PipelineCache::save() {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device.device(), cache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+    std::string data(PIPELINE_CACHE_HEADER_SIZE + size, '\0');
+    if (vkGetPipelineCacheData(device.device(), cache, &size, &data[PIPELINE_CACHE_HEADER_SIZE]) != VK_SUCCESS) return;
+    data.resize(PIPELINE_CACHE_HEADER_SIZE + size);
+
+    const VkPhysicalDeviceProperties& properties = device.properties;
+    putU32(&data[0], PIPELINE_CACHE_MAGIC);
+    putU32(&data[4], PIPELINE_CACHE_VERSION);
+    putU32(&data[8], properties.vendorID);
+    putU32(&data[12], properties.deviceID);
+    putU32(&data[16], properties.driverVersion);
+    std::memcpy(&data[20], properties.pipelineCacheUUID, VK_UUID_SIZE);
+    putU64(&data[20 + VK_UUID_SIZE], size);
+    putU64(&data[28 + VK_UUID_SIZE], hashBytes(data.data() + PIPELINE_CACHE_HEADER_SIZE, size));
+
+    // Written aside and renamed into place, so a crash never leaves half a file
+    std::error_code ec;
+    std::filesystem::path target{path};
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), ec);
+    }
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return;
+    }
+    dirty = false;
+}
+
+} // namespace vkengine
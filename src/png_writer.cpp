@@ -0,0 +1,93 @@
+#include "png_writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+namespace vkengine {
+
+// PNG stores every integer big-endian
+static void appendBigEndian(std::string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+static uint32_t crc32(const std::string& data, size_t offset) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = offset; i < data.size(); ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Length, type, data and a CRC over type and data
+static void appendChunk(std::string& out, const char* type, const std::string& data) {
+    appendBigEndian(out, static_cast<uint32_t>(data.size()));
+    size_t start = out.size();
+    out.append(type, 4);
+    out += data;
+    appendBigEndian(out, crc32(out, start));
+}
+
+void writePng(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba) {
+    // Every row starts with filter type 0 (none)
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::string scanlines;
+    scanlines.reserve((rowBytes + 1) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        scanlines.push_back(0);
+        scanlines.append(reinterpret_cast<const char*>(rgba + y * rowBytes), rowBytes);
+    }
+
+    // zlib stream of stored blocks, each at most 65535 bytes, then the Adler-32 of the data
+    std::string compressed{"\x78\x01", 2};
+    size_t offset = 0;
+    do {
+        size_t length = std::min<size_t>(scanlines.size() - offset, 65535);
+        bool last = offset + length == scanlines.size();
+        compressed.push_back(last ? 1 : 0);
+        compressed.push_back(static_cast<char>(length & 0xFF));
+        compressed.push_back(static_cast<char>(length >> 8));
+        compressed.push_back(static_cast<char>(~length & 0xFF));
+        compressed.push_back(static_cast<char>((~length >> 8) & 0xFF));
+        compressed.append(scanlines, offset, length);
+        offset += length;
+    } while (offset < scanlines.size());
+    uint32_t a = 1, b = 0;
+    for (char byte : scanlines) {
+        a = (a + static_cast<uint8_t>(byte)) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(compressed, (b << 16) | a);
+
+    std::string header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header += std::string{"\x08\x06\x00\x00\x00", 5};   // 8 bits, RGBA, deflate, adaptive filtering, no interlace
+
+    std::string file{"\x89PNG\r\n\x1a\n", 8};
+    appendChunk(file, "IHDR", header);
+    appendChunk(file, "IDAT", compressed);
+    appendChunk(file, "IEND", {});
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(file.data(), static_cast<std::streamsize>(file.size()));
+    if (!out) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+} // namespace vkengine
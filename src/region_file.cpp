@@ -0,0 +1,550 @@
+#include "region_file.hpp"
+#include "byte_io.hpp"
+#include "hash.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace vkengine {
+
+static constexpr char REGION_MAGIC[4] = {'V', 'K', 'R', 'G'};
+// Version 3 adds the header checksum and a payload checksum per table entry.
+// Version 2 let entries share sectors; version 1 did not. Older files are read
+// as they are and rewritten in the current layout on their first write.
+static constexpr uint32_t REGION_VERSION = 3;
+static constexpr uint32_t REGION_OLDEST_VERSION = 1;
+
+struct RegionLayout {
+    uint32_t preambleSize;
+    uint32_t entrySize;
+    uint32_t headerSectors;
+};
+
+static constexpr RegionLayout layoutFor(uint32_t version) {
+    uint32_t preamble = version >= 3 ? 32 : 16;
+    uint32_t entry = version >= 3 ? 16 : 8;
+    return {preamble, entry, (preamble + REGION_VOLUME * entry + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE};
+}
+
+static constexpr RegionLayout REGION_LAYOUT = layoutFor(REGION_VERSION);
+static constexpr size_t REGION_CHECKSUM_OFFSET = 16;
+
+// Covers the preamble fields before it and the whole chunk table
+static uint64_t headerChecksum(const char* header) {
+    uint64_t preamble = hashBytes(header, REGION_CHECKSUM_OFFSET);
+    return hashBytes(header + REGION_LAYOUT.preambleSize, static_cast<size_t>(REGION_VOLUME) * REGION_LAYOUT.entrySize, preamble);
+}
+
+std::unique_ptr<RegionFile> RegionFile::open(const std::string& path, bool create) {
+    bool exists = std::filesystem::exists(path);
+    if (!exists && !create) {
+        return nullptr;
+    }
+
+    std::unique_ptr<RegionFile> region(new RegionFile(path));
+    if (!exists) {
+        region->writeHeader();
+    }
+    region->remap();
+    region->validateHeader();
+    return region;
+}
+
+RegionFile::RegionFile(const std::string& path) : path{path} {}
+
+int RegionFile::localIndex(const ChunkCoord& coord) {
+    int x = coord.x - floorDiv(coord.x, REGION_SIZE) * REGION_SIZE;
+    int y = coord.y - floorDiv(coord.y, REGION_SIZE) * REGION_SIZE;
+    int z = coord.z - floorDiv(coord.z, REGION_SIZE) * REGION_SIZE;
+    return x + y * REGION_SIZE + z * REGION_SIZE * REGION_SIZE;
+}
+
+ChunkCoord RegionFile::regionCoord(const ChunkCoord& coord) {
+    return {floorDiv(coord.x, REGION_SIZE), floorDiv(coord.y, REGION_SIZE), floorDiv(coord.z, REGION_SIZE)};
+}
+
+ChunkCoord RegionFile::chunkCoord(const ChunkCoord& regionCoord, int localIndex) {
+    return {regionCoord.x * REGION_SIZE + localIndex % REGION_SIZE,
+            regionCoord.y * REGION_SIZE + (localIndex / REGION_SIZE) % REGION_SIZE,
+            regionCoord.z * REGION_SIZE + localIndex / (REGION_SIZE * REGION_SIZE)};
+}
+
+void RegionFile::remap() {
+    if (!mapping.map(path)) {
+        throw std::runtime_error("Failed to open region file: " + path);
+    }
+}
+
+RegionFile::~RegionFile() {
+    // Best effort; a stale checksum only fails verification until the next sync
+    try {
+        if (headerDirty) {
+            writeHeaderChecksum();
+            file.flush();
+        }
+    } catch (...) {
+    }
+}
+
+void RegionFile::validateHeader() {
+    const char* header = mapping.data();
+    if (mapping.size() < 16 || std::memcmp(header, REGION_MAGIC, sizeof(REGION_MAGIC)) != 0) {
+        throw std::runtime_error("Not a region file: " + path);
+    }
+    version = getU32(&header[4]);
+    if (version < REGION_OLDEST_VERSION || version > REGION_VERSION || getU32(&header[8]) != REGION_SIZE || getU32(&header[12]) != REGION_SECTOR_SIZE) {
+        throw std::runtime_error("Unsupported region file layout: " + path);
+    }
+    if (mapping.size() < layoutFor(version).headerSectors * REGION_SECTOR_SIZE) {
+        throw std::runtime_error("Truncated region header: " + path);
+    }
+}
+
+void RegionFile::writeHeader() {
+    std::vector<char> header(REGION_LAYOUT.headerSectors * REGION_SECTOR_SIZE, 0);
+    std::memcpy(header.data(), REGION_MAGIC, sizeof(REGION_MAGIC));
+    putU32(&header[4], REGION_VERSION);
+    putU32(&header[8], REGION_SIZE);
+    putU32(&header[12], REGION_SECTOR_SIZE);
+    putU64(&header[REGION_CHECKSUM_OFFSET], headerChecksum(header.data()));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(header.data(), header.size());
+    if (!out) {
+        throw std::runtime_error("Failed to write region header: " + path);
+    }
+}
+
+void RegionFile::writeHeaderChecksum() {
+    // The mapping sees the table as written so far once the stream is flushed
+    file.flush();
+    char bytes[8];
+    putU64(bytes, headerChecksum(mapping.data()));
+    file.seekp(REGION_CHECKSUM_OFFSET);
+    file.write(bytes, sizeof(bytes));
+    headerDirty = false;
+}
+
+RegionFile::Entry RegionFile::readEntry(int localIndex) const {
+    RegionLayout layout = layoutFor(version);
+    const char* entry = mapping.data() + layout.preambleSize + static_cast<size_t>(localIndex) * layout.entrySize;
+    if (version < 3) {
+        return {getU32(entry), getU32(entry + 4), 0};
+    }
+    return {getU32(entry), getU32(entry + 4), getU64(entry + 8)};
+}
+
+void RegionFile::writeEntry(int localIndex, const Entry& entry) {
+    char bytes[16];
+    putU32(bytes, entry.sector);
+    putU32(bytes + 4, entry.length);
+    putU64(bytes + 8, entry.checksum);
+    file.seekp(REGION_LAYOUT.preambleSize + static_cast<std::streamoff>(localIndex) * REGION_LAYOUT.entrySize);
+    file.write(bytes, sizeof(bytes));
+    headerDirty = true;
+}
+
+void RegionFile::upgrade() {
+    // Every readable chunk is copied into a current-layout file next to this
+    // one, which then replaces it. Unreadable chunks are dropped and regenerate.
+    std::string upgradedPath = path + ".upgrade";
+    std::filesystem::remove(upgradedPath);
+    {
+        auto upgraded = RegionFile::open(upgradedPath, true);
+        RegionLayout layout = layoutFor(version);
+        for (int i = 0; i < REGION_VOLUME; ++i) {
+            Entry entry = readEntry(i);
+            size_t offset = static_cast<size_t>(entry.sector) * REGION_SECTOR_SIZE;
+            if (entry.length == 0 || entry.sector < layout.headerSectors || offset + entry.length > mapping.size()) continue;
+            upgraded->writeChunk(i, std::string(mapping.data() + offset, entry.length));
+        }
+        upgraded->sync();
+    }
+
+    if (file.is_open()) {
+        file.close();
+    }
+    std::filesystem::rename(upgradedPath, path);
+    remap();
+    validateHeader();
+    usedSectors.clear();
+}
+
+void RegionFile::buildAllocationMap() {
+    usedSectors.assign(REGION_LAYOUT.headerSectors, true);
+    runs.clear();
+    runsByContent.clear();
+    for (int i = 0; i < REGION_VOLUME; ++i) {
+        Entry entry = readEntry(i);
+        if (entry.length == 0) continue;
+        if (entry.sector < REGION_LAYOUT.headerSectors) {
+            throw std::runtime_error("Corrupt chunk table in region file: " + path);
+        }
+
+        // The entry checksum is the payload hash, so sharing needs no payload reads
+        auto [run, first] = runs.try_emplace(entry.sector, Run{0, entry.length, entry.checksum});
+        if (first) {
+            runsByContent.emplace(entry.checksum, entry.sector);
+            markSectors(entry.sector, sectorsFor(entry.length), true);
+        } else if (run->second.length != entry.length || run->second.hash != entry.checksum) {
+            throw std::runtime_error("Corrupt chunk table in region file: " + path);
+        }
+        run->second.references++;
+    }
+
+    // A crash between writes and sync() leaves the header checksum stale; the
+    // journal replays identical payloads, which write no entries, so refresh it anyway
+    headerDirty = true;
+}
+
+void RegionFile::releaseRun(const Entry& entry) {
+    auto run = runs.find(entry.sector);
+    if (run == runs.end() || --run->second.references > 0) return;
+
+    auto byContent = runsByContent.find(run->second.hash);
+    if (byContent != runsByContent.end() && byContent->second == entry.sector) {
+        runsByContent.erase(byContent);
+    }
+    markSectors(entry.sector, sectorsFor(entry.length), false);
+    runs.erase(run);
+}
+
+void RegionFile::markSectors(uint32_t first, uint32_t count, bool used) {
+    if (usedSectors.size() < first + count) {
+        usedSectors.resize(first + count, false);
+    }
+    for (uint32_t i = first; i < first + count; ++i) {
+        usedSectors[i] = used;
+    }
+}
+
+uint32_t RegionFile::allocateSectors(uint32_t count) {
+    // First fit among freed sectors, otherwise grow the file
+    uint32_t run = 0;
+    for (uint32_t i = REGION_LAYOUT.headerSectors; i < usedSectors.size(); ++i) {
+        run = usedSectors[i] ? 0 : run + 1;
+        if (run == count) {
+            return i + 1 - count;
+        }
+    }
+    return static_cast<uint32_t>(usedSectors.size()) - run;
+}
+
+bool RegionFile::hasChunk(int localIndex) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return readEntry(localIndex).length > 0;
+}
+
+bool RegionFile::visitChunk(int localIndex, const std::function<void(std::string_view)>& visitor) {
+    // Shared lock: any number of workers decode at once, a write waits for them
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    Entry entry = readEntry(localIndex);
+    if (entry.length == 0) {
+        return false;
+    }
+
+    size_t offset = static_cast<size_t>(entry.sector) * REGION_SECTOR_SIZE;
+    if (entry.sector < layoutFor(version).headerSectors || offset + entry.length > mapping.size()) {
+        throw std::runtime_error("Truncated chunk payload in region file: " + path);
+    }
+    std::string_view payload(mapping.data() + offset, entry.length);
+    if (version >= 3 && hashBytes(payload.data(), payload.size()) != entry.checksum) {
+        throw std::runtime_error("Chunk checksum mismatch in region file: " + path);
+    }
+    visitor(payload);
+    return true;
+}
+
+bool RegionFile::readChunk(int localIndex, std::string& payload) {
+    return visitChunk(localIndex, [&](std::string_view data) {
+        payload.assign(data.data(), data.size());
+    });
+}
+
+void RegionFile::writeChunk(int localIndex, const std::string& payload) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (version < REGION_VERSION) {
+        upgrade();
+    }
+    if (!file.is_open()) {
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open region file for writing: " + path);
+        }
+    }
+    if (usedSectors.empty()) {
+        buildAllocationMap();
+    }
+
+    Entry entry = readEntry(localIndex);
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    uint32_t sectors = sectorsFor(length);
+    uint64_t hash = hashBytes(payload.data(), payload.size());
+
+    // Identical payload already stored: point this entry at it, nothing else is written
+    auto byContent = runsByContent.find(hash);
+    if (byContent != runsByContent.end()) {
+        Run& shared = runs.at(byContent->second);
+        size_t offset = static_cast<size_t>(byContent->second) * REGION_SECTOR_SIZE;
+        if (shared.length == length && offset + length <= mapping.size() &&
+            std::memcmp(mapping.data() + offset, payload.data(), length) == 0) {
+            if (entry.length > 0 && entry.sector == byContent->second) {
+                return;
+            }
+            Entry previous = entry;
+            entry = {byContent->second, length, hash};
+            shared.references++;
+            writeEntry(localIndex, entry);
+            // Freed only once nothing points at them any more
+            if (previous.length > 0) {
+                releaseRun(previous);
+            }
+            file.flush();
+            if (!file) {
+                throw std::runtime_error("Failed to write chunk to region file: " + path);
+            }
+            return;
+        }
+    }
+
+    // Rewrite in place when no other entry shares the sectors and the payload
+    // still fits, otherwise move it
+    auto run = entry.length > 0 ? runs.find(entry.sector) : runs.end();
+    bool inPlace = run != runs.end() && run->second.references == 1 && sectorsFor(entry.length) >= sectors;
+    if (inPlace) {
+        auto oldContent = runsByContent.find(run->second.hash);
+        if (oldContent != runsByContent.end() && oldContent->second == entry.sector) {
+            runsByContent.erase(oldContent);
+        }
+        runs.erase(run);
+        if (sectorsFor(entry.length) > sectors) {
+            markSectors(entry.sector + sectors, sectorsFor(entry.length) - sectors, false);
+        }
+    } else {
+        if (entry.length > 0) {
+            releaseRun(entry);
+        }
+        entry.sector = allocateSectors(sectors);
+    }
+    markSectors(entry.sector, sectors, true);
+    entry.length = length;
+    entry.checksum = hash;
+    runs[entry.sector] = Run{1, length, hash};
+    // A colliding hash keeps its first run; this payload is just not shared
+    runsByContent.emplace(hash, entry.sector);
+
+    // Pad to the sector boundary so the file never ends mid-sector
+    std::string padded = payload;
+    padded.resize(static_cast<size_t>(sectors) * REGION_SECTOR_SIZE, '\0');
+
+    file.clear();
+    file.seekp(static_cast<std::streamoff>(entry.sector) * REGION_SECTOR_SIZE);
+    file.write(padded.data(), padded.size());
+
+    // Payload before table entry, so a moved chunk is never pointed at half-written sectors
+    writeEntry(localIndex, entry);
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Failed to write chunk to region file: " + path);
+    }
+
+    // The shared mapping already sees the new bytes; it only has to grow with the file
+    if (static_cast<size_t>(entry.sector + sectors) * REGION_SECTOR_SIZE > mapping.size()) {
+        remap();
+    }
+}
+
+void RegionFile::sync() {
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (!file.is_open()) return;
+        if (headerDirty) {
+            writeHeaderChecksum();
+        }
+        file.flush();
+    }
+
+    // fsync through a second descriptor; it flushes the file, not the handle, so
+    // readers and writers of this region are not held up while the disk catches up
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("Failed to sync region file: " + path);
+    }
+    ::close(fd);
+}
+
+RegionReport RegionFile::verify(const std::string& path) {
+    RegionReport report;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info{};
+    if (fd < 0 || ::fstat(fd, &info) != 0) {
+        if (fd >= 0) ::close(fd);
+        report.problems.emplace_back(-1, "cannot be opened");
+        return report;
+    }
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    // Read-ahead hint only; the scan is correct without it
+#if defined(POSIX_FADV_SEQUENTIAL)
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(__APPLE__) && defined(F_RDAHEAD)
+    ::fcntl(fd, F_RDAHEAD, 1);
+#endif
+
+    auto readAt = [&](size_t offset, char* out, size_t size) {
+        for (size_t done = 0; done < size;) {
+            ssize_t count = ::pread(fd, out + done, size - done, static_cast<off_t>(offset + done));
+            if (count <= 0) return false;
+            done += static_cast<size_t>(count);
+        }
+        report.bytesRead += size;
+        return true;
+    };
+
+    struct Item {
+        Entry entry;
+        int localIndex;
+    };
+    std::vector<Item> items;
+    {
+        char preamble[16];
+        if (fileSize < sizeof(preamble) || !readAt(0, preamble, sizeof(preamble)) ||
+            std::memcmp(preamble, REGION_MAGIC, sizeof(REGION_MAGIC)) != 0) {
+            report.problems.emplace_back(-1, "not a region file");
+            ::close(fd);
+            return report;
+        }
+        uint32_t version = getU32(&preamble[4]);
+        if (version < REGION_OLDEST_VERSION || version > REGION_VERSION || getU32(&preamble[8]) != REGION_SIZE ||
+            getU32(&preamble[12]) != REGION_SECTOR_SIZE) {
+            report.problems.emplace_back(-1, "unsupported layout, version " + std::to_string(version));
+            ::close(fd);
+            return report;
+        }
+
+        RegionLayout layout = layoutFor(version);
+        std::vector<char> header(layout.preambleSize + static_cast<size_t>(REGION_VOLUME) * layout.entrySize);
+        if (fileSize < static_cast<size_t>(layout.headerSectors) * REGION_SECTOR_SIZE || !readAt(0, header.data(), header.size())) {
+            report.problems.emplace_back(-1, "truncated header");
+            ::close(fd);
+            return report;
+        }
+        report.version = version;
+        if (version >= 3 && getU64(&header[REGION_CHECKSUM_OFFSET]) != headerChecksum(header.data())) {
+            report.problems.emplace_back(-1, "header checksum mismatch");
+        }
+
+        for (int i = 0; i < REGION_VOLUME; ++i) {
+            const char* bytes = header.data() + layout.preambleSize + static_cast<size_t>(i) * layout.entrySize;
+            Entry entry{getU32(bytes), getU32(bytes + 4), version >= 3 ? getU64(bytes + 8) : 0};
+            if (entry.length == 0) continue;
+            report.chunks++;
+            size_t offset = static_cast<size_t>(entry.sector) * REGION_SECTOR_SIZE;
+            if (entry.sector < layout.headerSectors || offset + entry.length > fileSize) {
+                report.problems.emplace_back(i, "payload outside the file");
+            } else if (version >= 3) {
+                items.push_back({entry, i});
+            }
+        }
+    }
+
+    // Front to back through a window, so the disk sees one sequential read
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.entry.sector < b.entry.sector;
+    });
+    constexpr size_t WINDOW_SIZE = size_t{8} << 20;
+    std::vector<char> window;
+    size_t windowStart = 0;
+    uint32_t hashedSector = 0;
+    uint64_t hashedChecksum = 0;
+    for (const Item& item : items) {
+        const Entry& entry = item.entry;
+        // Entries sharing sectors share one hash
+        if (entry.sector != hashedSector) {
+            size_t offset = static_cast<size_t>(entry.sector) * REGION_SECTOR_SIZE;
+            if (offset < windowStart || offset + entry.length > windowStart + window.size()) {
+                windowStart = offset;
+                window.resize(std::min(std::max(WINDOW_SIZE, static_cast<size_t>(entry.length)), fileSize - offset));
+                if (!readAt(windowStart, window.data(), window.size())) {
+                    report.problems.emplace_back(item.localIndex, "read error");
+                    window.clear();
+                    continue;
+                }
+            }
+            hashedSector = entry.sector;
+            hashedChecksum = hashBytes(window.data() + (offset - windowStart), entry.length);
+        }
+        if (hashedChecksum != entry.checksum) {
+            report.problems.emplace_back(item.localIndex, "checksum mismatch");
+        }
+    }
+
+    ::close(fd);
+    return report;
+}
+
+RegionStore::RegionStore(std::string directory) : directory{std::move(directory)} {}
+
+std::string RegionStore::regionPath(const ChunkCoord& regionCoord) const {
+    return directory + "/r." + std::to_string(regionCoord.x) + "." + std::to_string(regionCoord.y) + "." +
+           std::to_string(regionCoord.z) + ".region";
+}
+
+RegionFile* RegionStore::getRegion(const ChunkCoord& regionCoord, bool create) {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    auto it = m_regions.find(regionCoord);
+    if (it != m_regions.end() && (it->second || !create)) {
+        return it->second.get();
+    }
+
+    if (create) {
+        std::filesystem::create_directories(directory);
+    }
+    auto region = RegionFile::open(regionPath(regionCoord), create);
+    RegionFile* result = region.get();
+    m_regions[regionCoord] = std::move(region);
+    return result;
+}
+
+bool RegionStore::hasChunk(const ChunkCoord& coord) {
+    RegionFile* region = getRegion(RegionFile::regionCoord(coord), false);
+    return region && region->hasChunk(RegionFile::localIndex(coord));
+}
+
+bool RegionStore::visitChunk(const ChunkCoord& coord, const std::function<void(std::string_view)>& visitor) {
+    RegionFile* region = getRegion(RegionFile::regionCoord(coord), false);
+    return region && region->visitChunk(RegionFile::localIndex(coord), visitor);
+}
+
+bool RegionStore::loadChunk(const ChunkCoord& coord, std::string& payload) {
+    RegionFile* region = getRegion(RegionFile::regionCoord(coord), false);
+    return region && region->readChunk(RegionFile::localIndex(coord), payload);
+}
+
+void RegionStore::saveChunk(const ChunkCoord& coord, const std::string& payload) {
+    RegionFile* region = getRegion(RegionFile::regionCoord(coord), true);
+    region->writeChunk(RegionFile::localIndex(coord), payload);
+}
+
+void RegionStore::sync() {
+    // Open regions are never closed or replaced, so the pointers stay valid
+    // after the lock; lookups and new regions need not wait for the fsyncs
+    std::vector<RegionFile*> regions;
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        regions.reserve(m_regions.size());
+        for (auto& [coord, region] : m_regions) {
+            if (region) regions.push_back(region.get());
+        }
+    }
+    for (RegionFile* region : regions) {
+        region->sync();
+    }
+}
+
+} // namespace vkengine
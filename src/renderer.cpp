@@ -101,7 +101,7 @@ void Renderer::endFrame() {
     currentFrameIndex = (currentFrameIndex + 1) % swapChain->MAX_FRAMES_IN_FLIGHT;
 }
 
-void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
     assert(isFrameStarted && "Can't begin render pass when frame is not in progress");
     assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
 
@@ -118,7 +118,9 @@ void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+    // Only vkCmdExecuteCommands may follow in a pass with secondary contents
+    if (contents != VK_SUBPASS_CONTENTS_INLINE) return;
 
     VkViewport viewport{};
     viewport.x = 0.0f;
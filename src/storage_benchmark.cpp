@@ -0,0 +1,349 @@
+#include "storage_benchmark.hpp"
+#include "block_storage.hpp"
+#include "chunk_region.hpp"
+#include "decoration_buffer.hpp"
+#include "mesh_cache.hpp"
+#include "region_file.hpp"
+#include "terrain_generator.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace vkengine {
+
+using FlatBlocks = std::array<Block, CHUNK_VOLUME>;
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Heap bytes in use. Unlike resident set size it drops when memory is freed,
+// so back-to-back runs in one process can be compared; 0 outside glibc.
+static size_t heapBytesInUse() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// Visible face count with the same neighbour rules as Chunk::generateMesh;
+// `blockAt(chunk, x, y, z)` returns AIR for chunks that do not exist
+template <typename BlockAt>
+static uint64_t countFaces(const std::array<int, 6>& neighbors, const FlatBlocks& self, BlockAt&& blockAt) {
+    uint64_t faces = 0;
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                if (self[chunkBlockIndex(x, y, z)].type == BlockType::AIR) continue;
+                for (int f = 0; f < 6; ++f) {
+                    int nx = x + FACE_OFFSETS[f][0];
+                    int ny = y + FACE_OFFSETS[f][1];
+                    int nz = z + FACE_OFFSETS[f][2];
+                    BlockType neighbor;
+                    if (nx >= 0 && nx < CHUNK_SIZE && ny >= 0 && ny < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
+                        neighbor = self[chunkBlockIndex(nx, ny, nz)].type;
+                    } else {
+                        neighbor = blockAt(neighbors[f], (nx + CHUNK_SIZE) % CHUNK_SIZE, (ny + CHUNK_SIZE) % CHUNK_SIZE, (nz + CHUNK_SIZE) % CHUNK_SIZE);
+                    }
+                    faces += neighbor == BlockType::AIR;
+                }
+            }
+        }
+    }
+    return faces;
+}
+
+StorageBenchmark::StorageBenchmark(Options opts) : options{opts} {
+    coords = regionCoords(options.seed, options.renderDistance, &skippedChunks);
+}
+
+void StorageBenchmark::run() {
+    std::cout << "Block storage benchmark: render distance " << options.renderDistance << ", "
+              << coords.size() << " non-empty chunks, " << skippedChunks << " empty skipped" << std::endl;
+
+    // Columns are shared by both layouts; build them up front so only chunk work is timed
+    TerrainGenerator generator{options.seed};
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& coord : coords) {
+        generator.getColumn({coord.x, coord.z});
+    }
+    std::printf("  column build (shared):   %9.1f ms\n", elapsedMs(start));
+
+    // -- Generation --
+    std::vector<FlatBlocks> flat(coords.size());
+    {
+        DecorationBuffer decorations;
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < coords.size(); ++i) {
+            generator.populateChunk(coords[i], flat[i], decorations);
+        }
+        std::printf("  generate, flat:          %9.1f ms\n", elapsedMs(start));
+    }
+
+    std::vector<BlockStorage> packed(coords.size());
+    {
+        DecorationBuffer decorations;
+        FlatBlocks scratch;
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < coords.size(); ++i) {
+            scratch.fill(Block(BlockType::AIR));
+            generator.populateChunk(coords[i], scratch, decorations);
+            packed[i].pack(scratch);
+        }
+        std::printf("  generate + pack:         %9.1f ms\n", elapsedMs(start));
+    }
+
+    // -- Meshing input: own blocks in bulk, neighbour borders block by block --
+    std::unordered_map<ChunkCoord, int, ChunkCoord::Hash> indices;
+    for (size_t i = 0; i < coords.size(); ++i) {
+        indices[coords[i]] = static_cast<int>(i);
+    }
+    std::vector<std::array<int, 6>> neighbors(coords.size());
+    for (size_t i = 0; i < coords.size(); ++i) {
+        for (int f = 0; f < 6; ++f) {
+            auto it = indices.find({coords[i].x + FACE_OFFSETS[f][0], coords[i].y + FACE_OFFSETS[f][1], coords[i].z + FACE_OFFSETS[f][2]});
+            neighbors[i][f] = it == indices.end() ? -1 : it->second;
+        }
+    }
+
+    uint64_t flatFaces = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < coords.size(); ++i) {
+        flatFaces += countFaces(neighbors[i], flat[i], [&](int chunk, int x, int y, int z) {
+            return chunk < 0 ? BlockType::AIR : flat[chunk][chunkBlockIndex(x, y, z)].type;
+        });
+    }
+    std::printf("  mesh pass, flat:         %9.1f ms\n", elapsedMs(start));
+
+    uint64_t packedFaces = 0;
+    FlatBlocks unpacked;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < coords.size(); ++i) {
+        packed[i].unpack(unpacked);
+        packedFaces += countFaces(neighbors[i], unpacked, [&](int chunk, int x, int y, int z) {
+            return chunk < 0 ? BlockType::AIR : packed[chunk].get(chunkBlockIndex(x, y, z));
+        });
+    }
+    std::printf("  mesh pass, unpack:       %9.1f ms\n", elapsedMs(start));
+
+    // -- Random access --
+    std::mt19937 rng(1234);
+    std::vector<std::pair<uint32_t, uint16_t>> accesses(1 << 20);
+    for (auto& access : accesses) {
+        access = {static_cast<uint32_t>(rng() % coords.size()), static_cast<uint16_t>(rng() % CHUNK_VOLUME)};
+    }
+
+    uint64_t checksum = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& [chunk, index] : accesses) checksum += static_cast<uint64_t>(flat[chunk][index].type);
+    std::printf("  1M random get, flat:     %9.2f ms\n", elapsedMs(start));
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& [chunk, index] : accesses) checksum -= static_cast<uint64_t>(packed[chunk].get(index));
+    std::printf("  1M random get, packed:   %9.2f ms\n", elapsedMs(start));
+
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& [chunk, index] : accesses) flat[chunk][index].type = BlockType::LEAVES;
+    std::printf("  1M random set, flat:     %9.2f ms\n", elapsedMs(start));
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& [chunk, index] : accesses) packed[chunk].set(index, BlockType::LEAVES);
+    std::printf("  1M random set, packed:   %9.2f ms\n", elapsedMs(start));
+
+    // -- Memory, measured before the random writes widened any palettes --
+    size_t flatBytes = coords.size() * sizeof(FlatBlocks);
+    size_t packedBytes = 0;
+    std::array<size_t, 9> widths{};
+    {
+        DecorationBuffer decorations;
+        FlatBlocks scratch;
+        for (const auto& coord : coords) {
+            scratch.fill(Block(BlockType::AIR));
+            generator.populateChunk(coord, scratch, decorations);
+            BlockStorage storage;
+            storage.pack(scratch);
+            packedBytes += storage.memoryUsage();
+            widths[storage.bitsPerBlock()]++;
+        }
+    }
+    std::printf("  memory, flat:            %9.1f MB (%zu bytes/chunk)\n", flatBytes / 1048576.0, sizeof(FlatBlocks));
+    std::printf("  memory, packed:          %9.1f MB (%zu bytes/chunk avg)\n", packedBytes / 1048576.0, packedBytes / std::max<size_t>(1, coords.size()));
+    std::printf("  index width histogram:   0b:%zu 1b:%zu 2b:%zu 4b:%zu 8b:%zu\n", widths[0], widths[1], widths[2], widths[4], widths[8]);
+
+    if (flatFaces != packedFaces || checksum != 0) {
+        std::cout << "  MISMATCH: layouts disagree (" << flatFaces << " vs " << packedFaces << " faces)" << std::endl;
+    } else {
+        std::cout << "  " << flatFaces << " visible faces in both layouts" << std::endl;
+    }
+
+    runMeshCache(generator, neighbors);
+    runDedup(generator, neighbors);
+}
+
+void StorageBenchmark::runMeshCache(TerrainGenerator& generator, const std::vector<std::array<int, 6>>& neighbors) {
+    // Real headless chunks, meshed the way a world reload does it
+    std::vector<std::shared_ptr<Chunk>> chunks(coords.size());
+    DecorationBuffer decorations;
+    for (size_t i = 0; i < coords.size(); ++i) {
+        auto gameObject = GameObject::createGameObject();
+        gameObject->transform.translation = {
+            static_cast<float>(coords[i].x * CHUNK_SIZE),
+            static_cast<float>(coords[i].y * CHUNK_SIZE),
+            static_cast<float>(coords[i].z * CHUNK_SIZE)
+        };
+        chunks[i] = std::make_shared<Chunk>(gameObject);
+        chunks[i]->generateTerrain(generator, decorations);
+    }
+    for (size_t i = 0; i < coords.size(); ++i) {
+        for (int f = 0; f < 6; ++f) {
+            chunks[i]->m_neighbors[f] = neighbors[i][f] < 0 ? nullptr : chunks[neighbors[i][f]];
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t meshedVertices = 0;
+    for (auto& chunk : chunks) {
+        chunk->generateGreedyMesh();
+        meshedVertices += chunk->getVertices().size();
+    }
+    std::printf("  reload, greedy mesh:     %9.1f ms\n", elapsedMs(start));
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "vkengine_mesh_cache_benchmark";
+    std::filesystem::remove_all(directory);
+    const size_t capacity = size_t{1} << 30;
+
+    // Cold: every chunk misses, is meshed and stored
+    {
+        MeshCache cache(directory.string(), capacity);
+        start = std::chrono::high_resolution_clock::now();
+        for (auto& chunk : chunks) {
+            uint64_t key = chunk->meshKey(MeshingTechnique::GREEDY);
+            std::vector<Model::Vertex> vertices;
+            std::vector<uint32_t> indices;
+            if (cache.load(key, vertices, indices)) {
+                chunk->setMesh(std::move(vertices), std::move(indices));
+                continue;
+            }
+            chunk->generateGreedyMesh();
+            cache.store(key, chunk->getVertices(), chunk->getIndices());
+        }
+        std::printf("  reload, cold mesh cache: %9.1f ms (%zu entries, %.1f MB, %zu hits)\n", elapsedMs(start),
+                    cache.getEntryCount(), cache.getSizeBytes() / 1048576.0, cache.getHits());
+    }
+
+    // Warm: a fresh cache object, as after a restart, finds every mesh on disk
+    size_t cachedVertices = 0;
+    {
+        MeshCache cache(directory.string(), capacity);
+        start = std::chrono::high_resolution_clock::now();
+        for (auto& chunk : chunks) {
+            uint64_t key = chunk->meshKey(MeshingTechnique::GREEDY);
+            std::vector<Model::Vertex> vertices;
+            std::vector<uint32_t> indices;
+            if (cache.load(key, vertices, indices)) {
+                chunk->setMesh(std::move(vertices), std::move(indices));
+            } else {
+                chunk->generateGreedyMesh();
+            }
+            cachedVertices += chunk->getVertices().size();
+        }
+        std::printf("  reload, warm mesh cache: %9.1f ms (%zu hits, %zu misses)\n", elapsedMs(start),
+                    cache.getHits(), cache.getMisses());
+    }
+    std::filesystem::remove_all(directory);
+
+    if (cachedVertices != meshedVertices) {
+        std::cout << "  MISMATCH: cached meshes have " << cachedVertices << " vertices, meshing gives " << meshedVertices << std::endl;
+    }
+}
+
+void StorageBenchmark::runDedup(TerrainGenerator& generator, const std::vector<std::array<int, 6>>& neighbors) {
+    auto createChunks = [&](std::vector<std::shared_ptr<Chunk>>& chunks) {
+        DecorationBuffer decorations;
+        chunks.resize(coords.size());
+        for (size_t i = 0; i < coords.size(); ++i) {
+            auto gameObject = GameObject::createGameObject();
+            gameObject->transform.translation = {
+                static_cast<float>(coords[i].x * CHUNK_SIZE),
+                static_cast<float>(coords[i].y * CHUNK_SIZE),
+                static_cast<float>(coords[i].z * CHUNK_SIZE)
+            };
+            chunks[i] = std::make_shared<Chunk>(gameObject);
+            chunks[i]->generateTerrain(generator, decorations);
+        }
+    };
+
+    ContentPool<BlockStorage>& pool = blockStoragePool();
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t before = heapBytesInUse();
+    createChunks(chunks);
+    size_t sharedHeap = heapBytesInUse() - before;
+    size_t distinctStorages = pool.liveCount();
+    chunks.clear();
+
+    pool.setEnabled(false);
+    before = heapBytesInUse();
+    createChunks(chunks);
+    size_t unsharedHeap = heapBytesInUse() - before;
+    pool.setEnabled(true);
+
+    std::printf("  chunk heap, unshared:    %9.2f MB\n", unsharedHeap / 1048576.0);
+    std::printf("  chunk heap, shared:      %9.2f MB (%zu distinct block storages for %zu chunks)\n",
+                sharedHeap / 1048576.0, distinctStorages, chunks.size());
+
+    // Meshes: chunks with equal keys would draw one uploaded model
+    for (size_t i = 0; i < coords.size(); ++i) {
+        for (int f = 0; f < 6; ++f) {
+            chunks[i]->m_neighbors[f] = neighbors[i][f] < 0 ? nullptr : chunks[neighbors[i][f]];
+        }
+    }
+    size_t meshBytes = 0;
+    size_t sharedMeshBytes = 0;
+    std::unordered_set<uint64_t> meshKeys;
+    for (auto& chunk : chunks) {
+        uint64_t key = chunk->meshKey(MeshingTechnique::GREEDY);
+        chunk->generateGreedyMesh();
+        size_t bytes = chunk->getVertices().size() * sizeof(Model::Vertex) + chunk->getIndices().size() * sizeof(uint32_t);
+        meshBytes += bytes;
+        if (bytes > 0 && meshKeys.insert(key).second) {
+            sharedMeshBytes += bytes;
+        }
+    }
+    std::printf("  meshes, unshared:        %9.1f MB\n", meshBytes / 1048576.0);
+    std::printf("  meshes, shared:          %9.1f MB (%zu distinct non-empty meshes)\n", sharedMeshBytes / 1048576.0, meshKeys.size());
+
+    // Region files holding every chunk, as after saving a fully edited world
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "vkengine_dedup_benchmark";
+    std::filesystem::remove_all(directory);
+    size_t duplicateBytes = 0;
+    {
+        RegionStore store(directory.string());
+        std::unordered_set<std::string> payloads;
+        for (size_t i = 0; i < coords.size(); ++i) {
+            std::string payload = chunks[i]->serialize();
+            size_t sectors = (payload.size() + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+            store.saveChunk(coords[i], payload);
+            if (!payloads.insert(std::move(payload)).second) {
+                duplicateBytes += sectors * REGION_SECTOR_SIZE;
+            }
+        }
+    }
+    size_t fileBytes = 0;
+    for (const auto& file : std::filesystem::directory_iterator(directory)) {
+        fileBytes += std::filesystem::file_size(file.path());
+    }
+    std::filesystem::remove_all(directory);
+    std::printf("  region files, unshared:  %9.1f MB\n", (fileBytes + duplicateBytes) / 1048576.0);
+    std::printf("  region files, shared:    %9.1f MB\n", fileBytes / 1048576.0);
+}
+
+} // namespace vkengine
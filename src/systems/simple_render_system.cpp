@@ -3,8 +3,10 @@
 #include "../../include/scope_timer.hpp" // Added for texture configuration
 
 #include <stdexcept>
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
+#include <iostream>
 
 #include <vulkan/vulkan_core.h>
 
@@ -16,18 +18,26 @@
 using namespace vkengine;
 using ScopeTimer = GlobalTimerData::ScopeTimer;
 
+// Chunks never rotate or scale, so a chunk draw pushes only `chunkOrigin`
+// (16 bytes) and the shaders add it to the vertex position; other objects
+// push the whole block with w = 0 and go through the matrices
 struct SimplePushConstantData {
+    glm::ivec4 chunkOrigin{0};  // xyz: origin in blocks, w: 1 for a chunk draw, 2 for GPU culled chunks
     glm::mat4 modelMatrix{1.f};
     glm::mat4 normalMatrix{1.f};
 };
 
-SimpleRenderSystem::SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : device{device} {
+SimpleRenderSystem::SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, PipelineCache &pipelineCache) : device{device}, pipelineCache{pipelineCache} {
     textureSetLayout = DescriptorSetLayout::Builder(device)
         .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
         .build();
     createPipelineLayout(globalSetLayout);
-    // createPipeline(renderPass); // Replaced by createPipelines
-    createPipelines(renderPass);
+
+    Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.pipelineLayout = pipelineLayout;
+    // Only the starting mode is built now; switching modes builds the others
+    getPipeline(static_cast<RenderMode>(config().getInt("render_mode")));
 
     std::srand(std::time(0));
 }
@@ -56,62 +66,113 @@ void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLay
     }
 }
 
-void SimpleRenderSystem::createPipelines(VkRenderPass renderPass) {
+Pipeline *SimpleRenderSystem::getPipeline(RenderMode mode) {
+    size_t index = static_cast<size_t>(mode);
+    if (index >= pipelines.size()) {
+        index = static_cast<size_t>(RenderMode::UV);
+        mode = RenderMode::UV;
+    }
+    if (pipelines[index]) return pipelines[index].get();
+
     assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+    auto start = std::chrono::steady_clock::now();
+    const char *name = "uv";
+    switch (mode) {
+        case RenderMode::WIREFRAME: {
+            PipelineConfigInfo wireframePipelineConfig = pipelineConfig; // Start with a copy
+            wireframePipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
+            wireframePipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; // Ensure we are drawing lines for triangles
+            pipelines[index] = std::make_unique<Pipeline>(device, "shaders/wireframe.vert.spv", "shaders/wireframe.frag.spv", wireframePipelineConfig, pipelineCache.getCache());
+            name = "wireframe";
+            break;
+        }
+        case RenderMode::TEXTURE:
+            // Assumes Model::Vertex::getAttributeDescriptions() includes the 'inBlockType' attribute
+            pipelines[index] = std::make_unique<Pipeline>(device, "shaders/texture_shader.vert.spv", "shaders/texture_shader.frag.spv", pipelineConfig, pipelineCache.getCache());
+            name = "texture";
+            break;
+        case RenderMode::COLOR:
+            pipelines[index] = std::make_unique<Pipeline>(device, "shaders/color_shader.vert.spv", "shaders/color_shader.frag.spv", pipelineConfig, pipelineCache.getCache());
+            name = "color";
+            break;
+        case RenderMode::UV:
+        default:
+            pipelines[index] = std::make_unique<Pipeline>(device, "shaders/uv_shader.vert.spv", "shaders/uv_shader.frag.spv", pipelineConfig, pipelineCache.getCache());
+            break;
+    }
+    pipelineCache.markDirty();
 
-    PipelineConfigInfo pipelineConfig{};
-    Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-    pipelineConfig.renderPass = renderPass;
-    pipelineConfig.pipelineLayout = pipelineLayout;
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Created " << name << " pipeline in " << milliseconds << " ms ("
+              << (pipelineCache.isWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+    return pipelines[index].get();
+}
 
-    // Textured pipeline (original uvPipeline)
-    uvPipeline = std::make_unique<Pipeline>(device, "shaders/uv_shader.vert.spv", "shaders/uv_shader.frag.spv", pipelineConfig);
-    colorPipeline = std::make_unique<Pipeline>(device, "shaders/color_shader.vert.spv", "shaders/color_shader.frag.spv", pipelineConfig);
 
-    // Texture Atlas Pipeline
-    // Assumes Model::Vertex::getAttributeDescriptions() includes the 'inBlockType' attribute
-    texturePipeline = std::make_unique<Pipeline>(device, "shaders/texture_shader.vert.spv", "shaders/texture_shader.frag.spv", pipelineConfig);
-    PipelineConfigInfo wireframePipelineConfig = pipelineConfig; // Start with a copy
-    // If your vertex_highlight shader is designed to work with point topology:
-    // vertexVisPipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
-    // vertexVisPipelineConfig.bindingDescriptions = {Model::Vertex::getBindingDescription()}; // Or just position
-    // vertexVisPipelineConfig.attributeDescriptions = {Model::Vertex::getAttributeDescriptions()[0]}; // Just position
+void SimpleRenderSystem::recordDraws(VkCommandBuffer commandBuffer, const DrawState &state, size_t begin, size_t end, DrawCounts &counts) {
+    state.pipeline->bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &state.globalDescriptorSet, 0, nullptr);
+    if (state.textureDescriptorSet != VK_NULL_HANDLE) {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &state.textureDescriptorSet, 0, nullptr);
+    }
+
+    // Every push constant the shaders use must be set once before the first
+    // draw, even the matrices chunk draws never read
+    SimplePushConstantData initial{};
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &initial);
 
-    // Configure for wireframe rendering
-    wireframePipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
-    wireframePipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; // Ensure we are drawing lines for triangles
+    for (size_t i = begin; i < end; ++i) {
+        GameObject &obj = *drawList[i];
+        // Chunk meshes are the models split into face buckets
+        bool chunk = obj.model->getGroupCount() == 6;
 
-    wireframePipeline = std::make_unique<Pipeline>(device, "shaders/wireframe.vert.spv", "shaders/wireframe.frag.spv", wireframePipelineConfig);
+        if (chunk) {
+            glm::ivec4 chunkOrigin{glm::ivec3(obj.transform.translation), 1};
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(chunkOrigin), &chunkOrigin);
+        } else {
+            SimplePushConstantData push{};
+            push.modelMatrix = obj.transform.mat4();
+            push.normalMatrix = obj.transform.normalMatrix();
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+        }
+        obj.model->bind(commandBuffer);
+        if (chunk) {
+            glm::vec3 boxMin = obj.transform.translation;
+            glm::vec3 boxMax = boxMin + static_cast<float>(CHUNK_SIZE) * obj.transform.scale;
+            uint32_t faces = state.faceCulling ? frontFacingFaces(state.eye, boxMin, boxMax) : 0x3F;
+            counts.drawnIndices += obj.model->drawGroups(commandBuffer, faces);
+            counts.totalIndices += obj.model->getIndexCount();
+        } else {
+            obj.model->draw(commandBuffer);
+        }
+    }
 }
 
+void SimpleRenderSystem::recordIndirectDraws(VkCommandBuffer commandBuffer, const DrawState &state, GpuCuller &gpuCuller) {
+    state.pipeline->bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &state.globalDescriptorSet, 0, nullptr);
+    if (state.textureDescriptorSet != VK_NULL_HANDLE) {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &state.textureDescriptorSet, 0, nullptr);
+    }
 
-void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo) {
-    Pipeline* currentPipeline = nullptr;
+    // Each draw's origin comes from the chunk record its firstInstance names
+    SimplePushConstantData push{};
+    push.chunkOrigin.w = 2;
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+    gpuCuller.draw(commandBuffer);
+}
 
-    switch (static_cast<RenderMode>(config().getInt("render_mode"))) {
-        case RenderMode::WIREFRAME:
-            currentPipeline = wireframePipeline.get();
-            break;
-        case RenderMode::TEXTURE: // New case for texture atlas rendering
-            currentPipeline = texturePipeline.get();
-            break;
-        case RenderMode::COLOR:
-            currentPipeline = colorPipeline.get();
-            break;
-        case RenderMode::UV:
-        default:
-            currentPipeline = uvPipeline.get();
-            break;
-    }
+void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo) {
+    RenderMode renderMode = static_cast<RenderMode>(config().getInt("render_mode"));
+    DrawState state{};
+    state.pipeline = getPipeline(renderMode);
+    state.globalDescriptorSet = frameInfo.globalDescriptorSet;
 
-    if (!currentPipeline) {
+    if (!state.pipeline) {
         throw std::runtime_error("No pipeline selected for rendering!");
     }
 
-    currentPipeline->bind(frameInfo.commandBuffer);
-
-    vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
-    if (static_cast<RenderMode>(config().getInt("render_mode")) == RenderMode::TEXTURE) {
+    if (renderMode == RenderMode::TEXTURE) {
         std::shared_ptr<TextureManager> textureManager = frameInfo.textureManager;
         if (textureManager && textureManager->getTextureArrayImageView() != VK_NULL_HANDLE) {
             // Check if the descriptor set needs to be created or updated
@@ -132,9 +193,7 @@ void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo) {
             }
             // Ensure textureDescriptorSet is valid before binding
             if (textureDescriptorSet != VK_NULL_HANDLE) {
-              
-                vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &textureDescriptorSet, 0, nullptr);
-                
+                state.textureDescriptorSet = textureDescriptorSet;
             } else {
                  throw std::runtime_error("Texture descriptor set is null even after attempting to build");
             }
@@ -143,17 +202,65 @@ void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo) {
         }
     }
 
+    // Chunk meshes come in six buckets, one per face direction; from outside a
+    // chunk's box along an axis, the bucket facing away on that axis is skipped
+    state.faceCulling = frameInfo.chunkManager && (frameInfo.chunkManager->flags & ChunkManagerFlags::FACE_CULLING);
+    state.eye = frameInfo.camera.getPosition();
+
+    // Chunks culled on the GPU are drawn from its buffers, not one by one
+    GpuCuller *gpuCuller = frameInfo.gpuCuller && frameInfo.gpuCuller->isCulling() ? frameInfo.gpuCuller : nullptr;
+
+    // Everything the recording threads read is settled here, on the main thread
+    drawList.clear();
     for (auto& kv : frameInfo.gameObjects) {
-        auto &obj = kv.second;
+        if (kv.second->model == nullptr) continue;
+        if (gpuCuller && kv.second->model->getGroupCount() == 6) continue;
+        // Chunks the cave-culling search could not reach from the camera
+        if (frameInfo.chunkManager && frameInfo.chunkManager->isCulled(kv.first)) continue;
+        drawList.push_back(kv.second.get());
+    }
 
-        if(obj->model == nullptr) continue;
+    ParallelRecorder *recorder = frameInfo.recorder;
+    int slices = recorder && recorder->isParallel() ? recorder->getActiveThreadCount() : 1;
+    std::vector<DrawCounts> counts(slices);
+    ParallelRecorder::Task task = [&](int slice, VkCommandBuffer commandBuffer) {
+        size_t begin = drawList.size() * slice / slices;
+        size_t end = drawList.size() * (slice + 1) / slices;
+        recordDraws(commandBuffer, state, begin, end, counts[slice]);
+    };
 
-        SimplePushConstantData push{};
-        push.modelMatrix = obj->transform.mat4();
-        push.normalMatrix = obj->transform.normalMatrix();
+    if (recorder && recorder->isParallel()) {
+        std::vector<VkCommandBuffer> buffers;
+        recorder->record(task, buffers);
+        if (gpuCuller) {
+            VkCommandBuffer indirect = recorder->beginSecondary();
+            recordIndirectDraws(indirect, state, *gpuCuller);
+            recorder->endSecondary(indirect);
+            buffers.push_back(indirect);
+        }
+        vkCmdExecuteCommands(frameInfo.commandBuffer, static_cast<uint32_t>(buffers.size()), buffers.data());
+    } else {
+        if (recorder) {
+            recorder->recordInline(task, frameInfo.commandBuffer);
+        } else {
+            task(0, frameInfo.commandBuffer);
+        }
+        if (gpuCuller) {
+            recordIndirectDraws(frameInfo.commandBuffer, state, *gpuCuller);
+        }
+    }
 
-        vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
-        obj->model->bind(frameInfo.commandBuffer);
-        obj->model->draw(frameInfo.commandBuffer);
+    if (frameInfo.chunkManager) {
+        DrawCounts total{};
+        for (const DrawCounts &sliceCounts : counts) {
+            total.drawnIndices += sliceCounts.drawnIndices;
+            total.totalIndices += sliceCounts.totalIndices;
+        }
+        if (gpuCuller) {
+            // Read back from an earlier frame; close enough for the overlay
+            total.drawnIndices += gpuCuller->getLastCounts().indices;
+            total.totalIndices += gpuCuller->getTotalIndexCount();
+        }
+        frameInfo.chunkManager->setDrawnIndexCounts(total.drawnIndices, total.totalIndices);
     }
 }
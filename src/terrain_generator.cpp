@@ -0,0 +1,304 @@
+#include "terrain_generator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace vkengine {
+
+// Perlin noise is zero on lattice points. The biome fields use very low
+// frequencies, so without an offset the whole spawn area would sit on one.
+static constexpr double BIOME_NOISE_OFFSET = 0.5;
+
+// Converts a world block position (height axis pointing up) into its chunk and local index
+static ChunkCoord worldToChunk(int worldX, int height, int worldZ, int& index) {
+    int flippedY = (CHUNK_SIZE - 1) - height;
+    ChunkCoord coord{floorDiv(worldX, CHUNK_SIZE), floorDiv(flippedY, CHUNK_SIZE), floorDiv(worldZ, CHUNK_SIZE)};
+    index = chunkBlockIndex(worldX - coord.x * CHUNK_SIZE, flippedY - coord.y * CHUNK_SIZE, worldZ - coord.z * CHUNK_SIZE);
+    return coord;
+}
+
+TerrainGenerator::TerrainGenerator(uint64_t seed) : seed{seed}, settings{seed} {}
+
+std::shared_ptr<const TerrainColumn> TerrainGenerator::getColumn(const ColumnCoord& coord) {
+    {
+        std::shared_lock<std::shared_mutex> lock(columnsMutex);
+        auto it = m_columns.find(coord);
+        if (it != m_columns.end()) {
+            return it->second;
+        }
+    }
+
+    // Built outside the lock; if another thread raced us the first insert wins
+    std::shared_ptr<const TerrainColumn> column = buildColumn(coord);
+
+    std::unique_lock<std::shared_mutex> lock(columnsMutex);
+    auto [it, inserted] = m_columns.emplace(coord, column);
+    return it->second;
+}
+
+void TerrainGenerator::evictColumns(const ChunkCoord& center, int radius) {
+    std::unique_lock<std::shared_mutex> lock(columnsMutex);
+    for (auto it = m_columns.begin(); it != m_columns.end();) {
+        int dx = std::abs(it->first.x - center.x);
+        int dz = std::abs(it->first.z - center.z);
+        if (dx > radius || dz > radius) {
+            it = m_columns.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int TerrainGenerator::globalMaxHeight() const {
+    // Octave noise is normalised to [-1, 1] and roughness never exceeds 1
+    double terrain = settings.elevBaseHeight + settings.elevHeightScale;
+    double water = settings.riverBedHeight + 2;
+    return static_cast<int>(std::ceil(std::max(terrain, water))) + TREE_MAX_HEIGHT;
+}
+
+bool TerrainGenerator::isChunkEmpty(const ChunkCoord& coord) {
+    // Lowest block of the layer underneath this one
+    int belowBottom = blockHeight(coord.y + 1, CHUNK_SIZE - 1);
+
+    // Cheap rejection before touching any column data
+    if (belowBottom > globalMaxHeight()) {
+        return true;
+    }
+
+    // Trees rooted in the neighbouring columns can overhang into this one
+    int maxHeight = std::numeric_limits<int>::min();
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            maxHeight = std::max(maxHeight, getColumn({coord.x + dx, coord.z + dz})->maxHeight);
+        }
+    }
+    return belowBottom > maxHeight + TREE_MAX_HEIGHT;
+}
+
+void TerrainGenerator::sampleBiome(double worldX, double worldZ, float& temperature, float& humidity, float& river) const {
+    // Remap [-1, 1] noise to [0, 1] for temperature and humidity
+    double t = settings.temperatureNoise.noise(worldX * settings.temperatureFrequency + BIOME_NOISE_OFFSET, worldZ * settings.temperatureFrequency + BIOME_NOISE_OFFSET);
+    double h = settings.humidityNoise.noise(worldX * settings.humidityFrequency + BIOME_NOISE_OFFSET, worldZ * settings.humidityFrequency + BIOME_NOISE_OFFSET);
+    temperature = static_cast<float>(std::clamp(0.5 + 0.5 * t, 0.0, 1.0));
+    humidity = static_cast<float>(std::clamp(0.5 + 0.5 * h, 0.0, 1.0));
+
+    // Rivers follow the zero crossings of the river noise, so keep the raw value
+    river = static_cast<float>(settings.riverNoise.noise(worldX * settings.riverFrequency + BIOME_NOISE_OFFSET, worldZ * settings.riverFrequency + BIOME_NOISE_OFFSET));
+}
+
+void TerrainGenerator::sampleBiomeGrid(const ColumnCoord& coord, TerrainColumn& column) const {
+    int worldOffsetX = coord.x * CHUNK_SIZE;
+    int worldOffsetZ = coord.z * CHUNK_SIZE;
+
+    for (int gz = 0; gz < BIOME_GRID_SIZE; ++gz) {
+        for (int gx = 0; gx < BIOME_GRID_SIZE; ++gx) {
+            int index = gx + gz * BIOME_GRID_SIZE;
+            sampleBiome(worldOffsetX + gx * BIOME_CELL_SIZE, worldOffsetZ + gz * BIOME_CELL_SIZE,
+                        column.temperature[index], column.humidity[index], column.river[index]);
+        }
+    }
+}
+
+float TerrainGenerator::biomeLookup(const std::array<float, BIOME_GRID_SIZE * BIOME_GRID_SIZE>& grid, int x, int z) const {
+    int gx = x / BIOME_CELL_SIZE;
+    int gz = z / BIOME_CELL_SIZE;
+    float fx = static_cast<float>(x % BIOME_CELL_SIZE) / BIOME_CELL_SIZE;
+    float fz = static_cast<float>(z % BIOME_CELL_SIZE) / BIOME_CELL_SIZE;
+
+    float v00 = grid[gx + gz * BIOME_GRID_SIZE];
+    float v10 = grid[(gx + 1) + gz * BIOME_GRID_SIZE];
+    float v01 = grid[gx + (gz + 1) * BIOME_GRID_SIZE];
+    float v11 = grid[(gx + 1) + (gz + 1) * BIOME_GRID_SIZE];
+
+    float top = v00 + (v10 - v00) * fx;
+    float bottom = v01 + (v11 - v01) * fx;
+    return top + (bottom - top) * fz;
+}
+
+std::shared_ptr<TerrainColumn> TerrainGenerator::buildColumn(const ColumnCoord& coord) const {
+    auto column = std::make_shared<TerrainColumn>();
+    sampleBiomeGrid(coord, *column);
+
+    int worldOffsetX = coord.x * CHUNK_SIZE;
+    int worldOffsetZ = coord.z * CHUNK_SIZE;
+
+    column->minHeight = std::numeric_limits<int>::max();
+    column->maxHeight = std::numeric_limits<int>::min();
+
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            int index = x + z * CHUNK_SIZE;
+
+            float temperature = biomeLookup(column->temperature, x, z);
+            float humidity = biomeLookup(column->humidity, x, z);
+            float riverValue = biomeLookup(column->river, x, z);
+
+            SurfaceSample surface = computeSurface(worldOffsetX + x, worldOffsetZ + z, temperature, humidity, riverValue);
+            column->height[index] = surface.height;
+            column->waterLevel[index] = surface.waterLevel;
+            column->soilDepth[index] = surface.soilDepth;
+            column->surfaceBlock[index] = surface.surfaceBlock;
+            column->soilBlock[index] = surface.soilBlock;
+
+            column->minHeight = std::min(column->minHeight, surface.height);
+            column->maxHeight = std::max(column->maxHeight, std::max(surface.height, surface.waterLevel));
+        }
+    }
+
+    return column;
+}
+
+SurfaceSample TerrainGenerator::sampleSurface(int worldX, int worldZ) const {
+    float temperature, humidity, river;
+    sampleBiome(worldX, worldZ, temperature, humidity, river);
+    return computeSurface(worldX, worldZ, temperature, humidity, river);
+}
+
+SurfaceSample TerrainGenerator::computeSurface(int worldX, int worldZ, float temperature, float humidity, float river) const {
+    SurfaceSample surface;
+
+    // Base heightmap, same path as before biomes existed
+    double nx = worldX * settings.elevFrequency;
+    double nz = worldZ * settings.elevFrequency;
+    double e = settings.elevationNoise.octaveNoise(nx, nz, settings.elevOctaves, settings.elevPersistence);
+
+    // Dry regions get rugged, wet regions flatten out into plains
+    double roughness = std::clamp(1.0 - 0.75 * humidity, 0.25, 1.0);
+    double height = settings.elevBaseHeight + e * settings.elevHeightScale * roughness;
+
+    // Carve towards the river bed, strongest on the zero crossing of the river noise
+    double riverStrength = std::clamp(1.0 - std::abs(river) / settings.riverThreshold, 0.0, 1.0);
+    riverStrength = riverStrength * riverStrength;
+    if (height > settings.riverBedHeight) {
+        height += (settings.riverBedHeight - height) * riverStrength;
+    }
+
+    int h = static_cast<int>(std::floor(height));
+    surface.height = h;
+
+    // Rivers keep a couple of blocks of water above their bed
+    surface.waterLevel = std::numeric_limits<int>::min();
+    if (riverStrength > 0.5) {
+        surface.waterLevel = static_cast<int>(settings.riverBedHeight) + 2;
+    }
+
+    double soil = settings.baseSoilDepth * (1.0 + settings.soilDepthVariation * (2.0 * humidity - 1.0));
+    surface.soilDepth = static_cast<uint8_t>(std::clamp(static_cast<int>(std::lround(soil)), 1, 255));
+
+    if (surface.waterLevel >= h) {
+        surface.surfaceBlock = BlockType::SAND;
+        surface.soilBlock = BlockType::SAND;
+    } else if (temperature > 0.65f && humidity < 0.4f) {
+        surface.surfaceBlock = BlockType::SAND;
+        surface.soilBlock = BlockType::SAND;
+    } else if (temperature < 0.3f && h > settings.elevBaseHeight + settings.elevHeightScale * 0.25) {
+        surface.surfaceBlock = BlockType::STONE;
+        surface.soilBlock = BlockType::STONE;
+    } else {
+        surface.surfaceBlock = BlockType::GRASS;
+        surface.soilBlock = BlockType::DIRT;
+    }
+
+    return surface;
+}
+
+void TerrainGenerator::generateChunk(const ChunkCoord& coord, std::array<Block, CHUNK_VOLUME>& blocks) {
+    std::shared_ptr<const TerrainColumn> column = getColumn({coord.x, coord.z});
+
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            int columnIndex = x + z * CHUNK_SIZE;
+            int height = column->height[columnIndex];
+            int soilTop = height - column->soilDepth[columnIndex];
+            int waterLevel = column->waterLevel[columnIndex];
+
+            for (int y = 0; y < CHUNK_SIZE; ++y) {
+                int worldY = blockHeight(coord.y, y);
+                BlockType type;
+                if (worldY < soilTop) {
+                    type = BlockType::STONE;
+                } else if (worldY < height) {
+                    type = column->soilBlock[columnIndex];
+                } else if (worldY == height) {
+                    type = column->surfaceBlock[columnIndex];
+                } else if (worldY <= waterLevel) {
+                    type = BlockType::WATER;
+                } else {
+                    type = BlockType::AIR;
+                }
+                blocks[chunkBlockIndex(x, y, z)].type = type;
+            }
+        }
+    }
+}
+
+void TerrainGenerator::decorateChunk(const ChunkCoord& coord, std::array<Block, CHUNK_VOLUME>& blocks, DecorationBuffer& decorations) {
+    std::shared_ptr<const TerrainColumn> column = getColumn({coord.x, coord.z});
+
+    // Trees whose trunk starts outside this chunk's layer belong to another chunk
+    int layerTop = blockHeight(coord.y, 0);
+    int layerBottom = blockHeight(coord.y, CHUNK_SIZE - 1);
+    if (column->maxHeight + 1 < layerBottom || column->minHeight + 1 > layerTop) {
+        return;
+    }
+
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            int columnIndex = x + z * CHUNK_SIZE;
+            int height = column->height[columnIndex];
+            if (height + 1 < layerBottom || height + 1 > layerTop) continue;
+            if (column->surfaceBlock[columnIndex] != BlockType::GRASS) continue;
+
+            int worldX = coord.x * CHUNK_SIZE + x;
+            int worldZ = coord.z * CHUNK_SIZE + z;
+            uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(worldX)) << 32) | static_cast<uint32_t>(worldZ);
+            uint64_t roll = splitmix64(seed ^ splitmix64(key));
+
+            // Wetter grassland grows denser forest
+            double chance = static_cast<double>(roll >> 11) * (1.0 / 9007199254740992.0);
+            double density = 0.005 + 0.03 * biomeLookup(column->humidity, x, z);
+            if (chance >= density) continue;
+
+            int trunkHeight = 4 + static_cast<int>((roll >> 3) % 3);
+            placeTree(coord, blocks, decorations, worldX, height, worldZ, trunkHeight);
+        }
+    }
+}
+
+void TerrainGenerator::placeTree(const ChunkCoord& origin, std::array<Block, CHUNK_VOLUME>& blocks, DecorationBuffer& decorations,
+                                 int worldX, int surfaceHeight, int worldZ, int trunkHeight) const {
+    auto write = [&](int wx, int height, int wz, BlockType type) {
+        int index;
+        ChunkCoord target = worldToChunk(wx, height, wz, index);
+        if (target == origin) {
+            applyDecorationBlock(blocks[index], type);
+        } else {
+            decorations.push(target, {static_cast<uint16_t>(index), type});
+        }
+    };
+
+    int top = surfaceHeight + trunkHeight;
+    for (int height = top - 2; height <= top + 1; ++height) {
+        int radius = height > top - 1 ? 1 : 2;
+        for (int dz = -radius; dz <= radius; ++dz) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                if (radius == 2 && std::abs(dx) == 2 && std::abs(dz) == 2) continue;
+                write(worldX + dx, height, worldZ + dz, BlockType::LEAVES);
+            }
+        }
+    }
+
+    for (int height = surfaceHeight + 1; height <= top; ++height) {
+        write(worldX, height, worldZ, BlockType::WOOD);
+    }
+}
+
+void TerrainGenerator::populateChunk(const ChunkCoord& coord, std::array<Block, CHUNK_VOLUME>& blocks, DecorationBuffer& decorations) {
+    generateChunk(coord, blocks);
+    decorateChunk(coord, blocks, decorations);
+    applyPendingBlocks(blocks, decorations.take(coord));
+}
+
+} // namespace vkengine